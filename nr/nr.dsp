@@ -85,6 +85,14 @@ LIB32=link.exe -lib
 # PROP Default_Filter ""
 # Begin Source File
 
+SOURCE=.\nrArena.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrArena.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrArray.h
 # End Source File
 # Begin Source File
@@ -93,6 +101,14 @@ SOURCE=.\nrArray.inl
 # End Source File
 # Begin Source File
 
+SOURCE=.\nrHash.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrHash.inl
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrLibrary.h
 # End Source File
 # Begin Source File
@@ -129,6 +145,30 @@ SOURCE=.\nrColorRamp.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\nrDenoiser.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrDenoiser.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrDenoiser.inl
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrFrameBuffer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrFrameBuffer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrFrameBuffer.inl
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrImage.cpp
 # End Source File
 # Begin Source File
@@ -149,12 +189,44 @@ SOURCE=.\nrImageTGA.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\nrImageTGA.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrImageWriter.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrImageWriter.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrKernel.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrKernel.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrPixel.cpp
 # End Source File
 # Begin Source File
 
 SOURCE=.\nrPixel.h
 # End Source File
+# Begin Source File
+
+SOURCE=.\nrSplatBuffer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrSplatBuffer.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrSplatBuffer.inl
+# End Source File
 # End Group
 # Begin Group "io"
 
@@ -243,6 +315,14 @@ SOURCE=.\nrMaterial.cpp
 
 SOURCE=.\nrMaterial.h
 # End Source File
+# Begin Source File
+
+SOURCE=.\nrProgram.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrProgram.h
+# End Source File
 # End Group
 # Begin Group "math"
 
@@ -257,6 +337,14 @@ SOURCE=.\nrBasis.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\nrFastMath.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrFastMath.inl
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrInterval.h
 # End Source File
 # Begin Source File
@@ -285,6 +373,18 @@ SOURCE=.\nrNoise.inl
 # End Source File
 # Begin Source File
 
+SOURCE=.\nrSampler.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrSampler.inl
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrSimd.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrVector2.h
 # End Source File
 # Begin Source File
@@ -371,6 +471,14 @@ SOURCE=.\nrRay.h
 
 SOURCE=.\nrRay.inl
 # End Source File
+# Begin Source File
+
+SOURCE=.\nrRayDifferential.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrRayDifferential.inl
+# End Source File
 # End Group
 # Begin Group "surface"
 
@@ -385,6 +493,14 @@ SOURCE=.\nrBound.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\nrPrimitives.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrPrimitives.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrScene.cpp
 # End Source File
 # Begin Source File
@@ -401,6 +517,14 @@ SOURCE=.\nrSurface.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\nrSurfaceBatch.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrSurfaceBatch.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrSurfaceBox.cpp
 # End Source File
 # Begin Source File
@@ -433,6 +557,14 @@ SOURCE=.\nrSurfaceSphere.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\nrSurfaceTBVH.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrSurfaceTBVH.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrSurfaceTriangle.cpp
 # End Source File
 # Begin Source File
@@ -445,12 +577,28 @@ SOURCE=.\nrSurfaceTriangle.h
 # PROP Default_Filter ""
 # Begin Source File
 
+SOURCE=.\nrSemaphore.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrSemaphore.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\nrStopWatch.cpp
 # End Source File
 # Begin Source File
 
 SOURCE=.\nrStopWatch.h
 # End Source File
+# Begin Source File
+
+SOURCE=.\nrThread.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\nrThread.h
+# End Source File
 # End Group
 # End Target
 # End Project
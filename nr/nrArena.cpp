@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrArena.cpp
+//
+// A class for arena (bump) allocation.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrArena.h"
+
+#include <assert.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment( lib, "psapi.lib" )
+#else
+#include <sys/resource.h>
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+#define NR_ARENA_ALIGNMENT 16
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrArena::nrArena( int block_size )
+{
+    assert( block_size > 0 );
+    
+    m_BlockSize = block_size;
+    m_Size = 0;
+    m_Top = 0;
+    m_End = 0;
+    m_Last = 0;
+    m_NumAllocations = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrArena::~nrArena( void )
+{
+    Release();
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void* nrArena::Allocate( int size )
+{
+    assert( size >= 0 );
+    
+    size = ( size + NR_ARENA_ALIGNMENT - 1 ) & ~( NR_ARENA_ALIGNMENT - 1 );
+    
+    m_NumAllocations++;
+    
+    // Allocations bigger than a quarter of a block get a block of their
+    // own, so they don't waste the rest of the current one.
+    if ( size > m_BlockSize / 4 )
+    {
+        char* block = new char[ size + NR_ARENA_ALIGNMENT ];
+        assert( block );
+        
+        m_Blocks.Add( block );
+        m_Size += size + NR_ARENA_ALIGNMENT;
+        
+        char* pointer = ( char* )( ( ( size_t )block + NR_ARENA_ALIGNMENT - 1 ) & ~( size_t )( NR_ARENA_ALIGNMENT - 1 ) );
+        
+        m_Last = 0;
+        return pointer;
+    }
+    
+    if ( m_Top == 0 || m_Top + size > m_End )
+    {
+        char* block = new char[ m_BlockSize + NR_ARENA_ALIGNMENT ];
+        assert( block );
+        
+        m_Blocks.Add( block );
+        m_Size += m_BlockSize + NR_ARENA_ALIGNMENT;
+        
+        m_Top = ( char* )( ( ( size_t )block + NR_ARENA_ALIGNMENT - 1 ) & ~( size_t )( NR_ARENA_ALIGNMENT - 1 ) );
+        m_End = m_Top + m_BlockSize;
+    }
+    
+    m_Last = m_Top;
+    m_Top += size;
+    
+    return m_Last;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrArena::Free( void* pointer )
+{
+    if ( pointer != 0 && pointer == m_Last )
+    {
+        m_Top = m_Last;
+        m_Last = 0;
+        m_NumAllocations--;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrArena::Release( void )
+{
+    for ( int i = 0; i < m_Blocks.Length(); i++ )
+    {
+        delete [] m_Blocks[ i ];
+    }
+    
+    m_Blocks.Clear();
+    m_Size = 0;
+    m_Top = 0;
+    m_End = 0;
+    m_Last = 0;
+    m_NumAllocations = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrArena::NumAllocations( void ) const
+{
+    return m_NumAllocations;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrArena::NumBlocks( void ) const
+{
+    return m_Blocks.Length();
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrArena::Size( void ) const
+{
+    return m_Size;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Static
+////////////////////////////////////////////////////////////////////////////
+
+int nrArena::PeakMemory( void )
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof ( counters ) ) )
+    {
+        return ( int )( counters.PeakWorkingSetSize / 1024 );
+    }
+    
+    return 0;
+#else
+    struct rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) == 0 )
+    {
+        return ( int )usage.ru_maxrss;
+    }
+    
+    return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
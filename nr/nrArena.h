@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrArena.h
+//
+// A class for arena (bump) allocation.
+//
+// Memory is handed out from large blocks, and all of it is given back at
+// once by Release().  Objects are placed in an arena with
+// 
+//     nrSurfaceTriangle* t = new ( arena ) nrSurfaceTriangle( ... );
+// 
+// and are never deleted; their destructors are not called, so only
+// objects which don't own other (heap) memory should be placed in one.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRARENA_H
+#define NRARENA_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrArray.h"
+
+#include <stddef.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrArena
+{
+public:
+    
+    nrArena( int block_size = 1024 * 1024 );
+    ~nrArena( void );
+    
+    // Return size bytes of memory, aligned to 16 bytes.
+    void* Allocate( int size );
+    
+    // Give back the memory of the most recent allocation.  Memory from
+    // any other allocation is kept until Release().
+    void Free( void* pointer );
+    
+    // Give back all of the memory in the arena.
+    void Release( void );
+    
+    // Return the number of allocations made (and not freed).
+    int NumAllocations( void ) const;
+    
+    // Return the number of blocks allocated.
+    int NumBlocks( void ) const;
+    
+    // Return the number of bytes allocated (including the unused ends of
+    // the blocks).
+    int Size( void ) const;
+    
+    // Return the peak memory use of the process, in kilobytes (0 if it
+    // can't be determined).
+    static int PeakMemory( void );
+    
+private:
+    
+    int              m_BlockSize;
+    nrArray< char* > m_Blocks;
+    int              m_Size;
+    
+    char*            m_Top;      // Next free byte in the current block.
+    char*            m_End;      // End of the current block.
+    char*            m_Last;     // Most recent allocation.
+    
+    int              m_NumAllocations;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+inline void* operator new( size_t size, nrArena& arena )
+{
+    return arena.Allocate( ( int )size );
+}
+
+// Only called if a constructor throws, in which case the memory is held
+// until the arena is released.
+inline void operator delete( void* pointer, nrArena& arena )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRARENA_H
@@ -18,6 +18,7 @@
 #include "nrChannelMarble.h"
 
 #include "nrParser.h"
+#include "nrProgram.h"
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -26,6 +27,7 @@
 
 nrChannel::nrChannel( void )
 {
+    m_Shared = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -36,6 +38,19 @@ nrChannel::~nrChannel( void )
 
 ////////////////////////////////////////////////////////////////////////////
 
+void nrChannel::Bake( const nrBound& bound )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrChannel::Compile( nrProgram& program ) const
+{
+    return program.Channel( this );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 nrChannel* nrChannel::Parse( nrParser& parser )
 {
     nrChannel* channel = 0;
@@ -68,7 +83,7 @@ nrChannel* nrChannel::Parse( nrParser& parser )
     
     if ( parser.Error() )
     {
-		delete channel;
+		Release( channel );
         return 0;
     }
     
@@ -76,3 +91,20 @@ nrChannel* nrChannel::Parse( nrParser& parser )
 }
 
 ////////////////////////////////////////////////////////////////////////////
+
+bool nrChannel::Shared( void ) const
+{
+    return m_Shared;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrChannel::Release( nrChannel* channel )
+{
+    if ( channel && ! channel->m_Shared )
+    {
+        delete channel;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
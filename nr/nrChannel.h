@@ -23,7 +23,9 @@
 // Classes
 ////////////////////////////////////////////////////////////////////////////
 
+class nrBound;
 class nrParser;
+class nrProgram;
 class nrVector3;
 
 ////////////////////////////////////////////////////////////////////////////
@@ -35,8 +37,21 @@ public:
     nrChannel( void );
     virtual ~nrChannel( void );
     
-    // Return the color of this channel.
-    virtual nrColor Color( const nrVector3& point ) const = 0;
+    // Return the color of this channel at a point.  The footprint is the
+    // width of the area the color stands for (e.g., a pixel projected
+    // onto the surface), or 0 if it isn't known.  Channels may leave out
+    // detail finer than the footprint, since it would only alias.
+    virtual nrColor Color( const nrVector3& point, float footprint = 0.0f ) const = 0;
+    
+    // Precompute what can be over the bound of the surfaces the channel
+    // is used on.  The default does nothing.
+    virtual void Bake( const nrBound& bound );
+    
+    // Emit the instructions which compute the color of this channel into
+    // a program, and return the (first) register holding the color, or 
+    // -1 if the program has run out of registers.  The default emits an
+    // instruction which calls Color() for each point.
+    virtual int Compile( nrProgram& program ) const;
 	
     // Return a new channel parsed from a file.  The channel directive
     // has the following form:
@@ -46,6 +61,18 @@ public:
     // 
     // elements in ()'s are optional.
     static nrChannel* Parse( nrParser& parser );
+    
+    // Delete a channel, unless it is shared (interned, see 
+    // nrChannelColor::Intern()).  Owners of channels should release them
+    // rather than deleting them.
+    static void Release( nrChannel* channel );
+    
+    // Return true if the channel is shared (interned).
+    bool Shared( void ) const;
+    
+protected:
+    
+    bool m_Shared;
 };
 
 ////////////////////////////////////////////////////////////////////////////
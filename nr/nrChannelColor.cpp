@@ -16,6 +16,16 @@
 #include "nrChannelColor.h"
 
 #include "nrParser.h"
+#include "nrProgram.h"
+
+#include <stdio.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Static
+////////////////////////////////////////////////////////////////////////////
+
+nrHash< nrChannelColor* > nrChannelColor::m_Interned;
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -35,13 +45,20 @@ nrChannelColor::~nrChannelColor( void )
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrColor nrChannelColor::Color( const nrVector3& point ) const
+nrColor nrChannelColor::Color( const nrVector3& point, float footprint ) const
 {
 	return m_Color;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
+int nrChannelColor::Compile( nrProgram& program ) const
+{
+	return program.Constant( m_Color );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 nrChannelColor* nrChannelColor::Parse( nrParser& parser )
 {
 	parser.ReadToken( nrParser::TOKEN_LIST_BEGIN );
@@ -50,9 +67,41 @@ nrChannelColor* nrChannelColor::Parse( nrParser& parser )
 	float b = parser.ReadFloat();
 	parser.ReadToken( nrParser::TOKEN_LIST_END );
 	
-    nrChannelColor* c = new nrChannelColor( nrColor( r, g, b ) );
+	if ( parser.Error() )
+	{
+		return 0;
+	}
 	
-	return c;
+	return Intern( nrColor( r, g, b ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrChannelColor* nrChannelColor::Intern( const nrColor& color )
+{
+    // Key on the bits of the components, so only identical colors match.
+    char key[ 32 ];
+    sprintf( key, "%08x %08x %08x", *( unsigned int* )&color.r, 
+        *( unsigned int* )&color.g, *( unsigned int* )&color.b );
+    
+    nrChannelColor** c = m_Interned.Find( key );
+    if ( c )
+    {
+        return *c;
+    }
+    
+    nrChannelColor* channel = new nrChannelColor( color );
+    channel->m_Shared = true;
+    m_Interned.Add( key, channel );
+    
+    return channel;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrChannelColor::NumInterned( void )
+{
+    return m_Interned.Length();
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -17,6 +17,7 @@
 ////////////////////////////////////////////////////////////////////////////
 
 #include "nrChannel.h"
+#include "nrHash.h"
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -33,7 +34,10 @@ public:
     virtual ~nrChannelColor( void );
     
     // Return the color of this channel.
-    virtual nrColor Color( const nrVector3& point ) const;
+    virtual nrColor Color( const nrVector3& point, float footprint = 0.0f ) const;
+    
+    // Emit a constant into the program.
+    virtual int Compile( nrProgram& program ) const;
 
     // Return a new channel parsed from a file.  The channel directive
     // has the following form:
@@ -41,11 +45,23 @@ public:
     // color < r g b >
     // 
     // elements in ()'s are optional.
+	// 
+	// The channel is interned (see Intern()).
 	static nrChannelColor* Parse( nrParser& parser );
 	
+    // Return the shared channel for a color.  Channels are interned by
+    // content, so every channel of the same color is the same object
+    // (which must not be deleted, see nrChannel::Release()).
+    static nrChannelColor* Intern( const nrColor& color );
+    
+    // Return the number of interned channels.
+    static int NumInterned( void );
+    
 private:
 
 	nrColor m_Color;
+	
+    static nrHash< nrChannelColor* > m_Interned;
 };
 
 ////////////////////////////////////////////////////////////////////////////
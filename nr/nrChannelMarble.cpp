@@ -16,8 +16,37 @@
 #include "nrChannelMarble.h"
 
 #include "nrColorRamp.h"
+#include "nrFastMath.h"
+#include "nrHash.h"
+#include "nrLog.h"
 #include "nrNoise.h"
 #include "nrParser.h"
+#include "nrProgram.h"
+#include "nrStopWatch.h"
+#include "nrThread.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+#define NR_MARBLE_KEY_LENGTH 256
+
+// Smallest number of points Marble() computes together (fewer are
+// computed one at a time).
+#define NR_MARBLE_BATCH_MINIMUM 4
+
+
+////////////////////////////////////////////////////////////////////////////
+// Static
+////////////////////////////////////////////////////////////////////////////
+
+nrHash< nrChannelMarble* > nrChannelMarble::m_Interned;
+int nrChannelMarble::m_NumShades = 0;
+double nrChannelMarble::m_NumOctaves = 0.0;
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -31,6 +60,12 @@ nrChannelMarble::nrChannelMarble( float scale, float period, float distortion, i
 	m_Distortion = distortion;
 	m_Octaves = octaves;
 	m_ColorRamp = 0;
+	
+	m_Bake = 0;
+	m_Size[ 0 ] = m_Size[ 1 ] = m_Size[ 2 ] = 0;
+	m_Spacing = 0.0f;
+	m_Volume = 0;
+	m_NextSlice = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -38,13 +73,14 @@ nrChannelMarble::nrChannelMarble( float scale, float period, float distortion, i
 nrChannelMarble::~nrChannelMarble( void )
 {
 	delete m_ColorRamp;
+	delete [] m_Volume;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrColor nrChannelMarble::Color( const nrVector3& point ) const
+nrColor nrChannelMarble::Color( const nrVector3& point, float footprint ) const
 {
-	float m = nrMath::Abs( nrNoise::Marble3( point * m_Scale, m_Period, m_Distortion, m_Octaves ) );
+	float m = Marble( point, footprint );
 	
 	if ( m_ColorRamp )
 	{
@@ -58,9 +94,238 @@ nrColor nrChannelMarble::Color( const nrVector3& point ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
+void nrChannelMarble::Marble( const float* x, const float* y, const float* z, const float* footprint, int count, float* marble ) const
+{
+	for ( int i = 0; i < count; i += 8 )
+	{
+		int n = nrMath::Min( count - i, 8 );
+		
+		// A few points are cheaper one at a time than padded out to 8.
+		if ( n < NR_MARBLE_BATCH_MINIMUM )
+		{
+			for ( int l = i; l < i + n; l++ )
+			{
+				marble[ l ] = Marble( nrVector3( x[ l ], y[ l ], z[ l ] ), footprint[ l ] );
+			}
+			
+			continue;
+		}
+		
+		// Lanes past the end of the batch repeat the last point.
+		float v[ 3 ][ 8 ];
+		float octaves[ 8 ];
+		float noise[ 8 ];
+		bool baked[ 8 ];
+		int needed = 0;
+		
+		int k;
+		for ( k = 0; k < 8; k++ )
+		{
+			int l = i + nrMath::Min( k, n - 1 );
+			
+			v[ 0 ][ k ] = x[ l ] * m_Scale;
+			v[ 1 ][ k ] = y[ l ] * m_Scale;
+			v[ 2 ][ k ] = z[ l ] * m_Scale;
+			
+			noise[ k ] = 0.0f;
+			baked[ k ] = m_Volume && Lookup( nrVector3( x[ l ], y[ l ], z[ l ] ), noise[ k ] );
+			octaves[ k ] = 0.0f;
+			
+			if ( ! baked[ k ] )
+			{
+				octaves[ k ] = Octaves( footprint[ l ] );
+				
+				int full = ( int )octaves[ k ];
+				needed = nrMath::Max( needed, octaves[ k ] > full ? full + 1 : full );
+				
+				if ( k < n )
+				{
+					m_NumShades++;
+					m_NumOctaves += octaves[ k ];
+				}
+			}
+		}
+		
+		// Sum the octaves in the same order as nrNoise::Fractal3(), the
+		// fractional octave of each point faded in.
+		for ( int j = 0; j < needed; j++ )
+		{
+			float o = ( float )( 1 << j );
+			
+			float w[ 3 ][ 8 ];
+			float octave[ 8 ];
+			
+			for ( k = 0; k < 8; k++ )
+			{
+				w[ 0 ][ k ] = v[ 0 ][ k ] * o;
+				w[ 1 ][ k ] = v[ 1 ][ k ] * o;
+				w[ 2 ][ k ] = v[ 2 ][ k ] * o;
+			}
+			
+			nrNoise::Noise3( w, octave );
+			
+			for ( k = 0; k < 8; k++ )
+			{
+				int full = ( int )octaves[ k ];
+				
+				if ( j < full )
+				{
+					noise[ k ] += octave[ k ] / o;
+				}
+				else if ( j == full && ! baked[ k ] )
+				{
+					float fade = nrMath::SmoothStep( 0.3f, 0.7f, octaves[ k ] - full );
+					if ( fade > 0.0f )
+					{
+						noise[ k ] += fade * octave[ k ] / o;
+					}
+				}
+			}
+		}
+		
+		for ( k = 0; k < 8; k++ )
+		{
+			v[ 0 ][ k ] = 180.0f * ( m_Period * v[ 0 ][ k ] + m_Distortion * noise[ k ] );
+		}
+		
+#ifdef NR_AVX2
+		_mm256_storeu_ps( v[ 0 ], nrFastMath::Sin( _mm256_loadu_ps( v[ 0 ] ) ) );
+#else
+		for ( k = 0; k < 8; k++ )
+		{
+			v[ 0 ][ k ] = nrFastMath::Sin( v[ 0 ][ k ] );
+		}
+#endif
+		
+		for ( k = 0; k < n; k++ )
+		{
+			marble[ i + k ] = nrMath::Abs( v[ 0 ][ k ] );
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrChannelMarble::Compile( nrProgram& program ) const
+{
+	int m = program.Marble( this );
+	
+	if ( m_ColorRamp )
+	{
+		return program.Ramp( m_ColorRamp, m );
+	}
+	else
+	{
+		return program.Gray( m );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrChannelMarble::Bake( const nrBound& bound )
+{
+    if ( m_Bake == 0 )
+    {
+        return;
+    }
+    
+    nrVector3 extent = bound.m_Maximums - bound.m_Minimums;
+    float longest = nrMath::Max( extent.x, nrMath::Max( extent.y, extent.z ) );
+    if ( longest <= 0.0f )
+    {
+        return;
+    }
+    
+    // Pad the volume by half a sample, so points on the surfaces at the
+    // edge of the bound (give or take a little roundoff) are inside it.
+    float spacing = longest / ( m_Bake - 1 );
+    nrVector3 pad( spacing / 2, spacing / 2, spacing / 2 );
+    
+    nrBound volume( bound.m_Minimums - pad, bound.m_Maximums + pad );
+    
+    // The channel may be shared by several materials.
+    if ( m_Volume && 
+         volume.m_Minimums.x == m_Bound.m_Minimums.x && 
+         volume.m_Minimums.y == m_Bound.m_Minimums.y && 
+         volume.m_Minimums.z == m_Bound.m_Minimums.z && 
+         volume.m_Maximums.x == m_Bound.m_Maximums.x && 
+         volume.m_Maximums.y == m_Bound.m_Maximums.y && 
+         volume.m_Maximums.z == m_Bound.m_Maximums.z )
+    {
+        return;
+    }
+    
+    delete [] m_Volume;
+    m_Volume = 0;
+    
+    m_Bound = volume;
+    m_Spacing = spacing;
+    m_Size[ 0 ] = ( int )nrMath::Ceil( ( extent.x + spacing ) / spacing ) + 1;
+    m_Size[ 1 ] = ( int )nrMath::Ceil( ( extent.y + spacing ) / spacing ) + 1;
+    m_Size[ 2 ] = ( int )nrMath::Ceil( ( extent.z + spacing ) / spacing ) + 1;
+    
+    // The key covers everything the volume depends on, including the 
+    // noise tables themselves (which depend on the random number 
+    // generator), through a sample of the noise.
+    float check = nrNoise::Noise3( nrVector3( 0.5f, 0.25f, 0.125f ) );
+    
+    char key[ NR_MARBLE_KEY_LENGTH ];
+    sprintf( key, "marble %08x %08x %d %d %08x %08x %08x %08x %08x %08x", 
+        *( unsigned int* )&check, *( unsigned int* )&m_Scale, m_Octaves, m_Bake, 
+        *( unsigned int* )&m_Bound.m_Minimums.x, *( unsigned int* )&m_Bound.m_Minimums.y, 
+        *( unsigned int* )&m_Bound.m_Minimums.z, *( unsigned int* )&m_Bound.m_Maximums.x, 
+        *( unsigned int* )&m_Bound.m_Maximums.y, *( unsigned int* )&m_Bound.m_Maximums.z );
+    
+    char file_name[ 64 ];
+    sprintf( file_name, "marble-%08x.vol", nrHash<int>::Hash( key ) );
+    
+    m_Volume = new float[ m_Size[ 0 ] * m_Size[ 1 ] * m_Size[ 2 ] ];
+    
+    if ( Read( file_name, key ) )
+    {
+        g_Log.Write( "Read baked marble noise (%dx%dx%d) from \"%s\".\n", 
+            m_Size[ 0 ], m_Size[ 1 ], m_Size[ 2 ], file_name );
+        return;
+    }
+    
+    g_Log.Write( "Baking marble noise (%dx%dx%d).\n", m_Size[ 0 ], m_Size[ 1 ], m_Size[ 2 ] );
+    
+    nrStopWatch stopwatch;
+    stopwatch.Reset();
+    stopwatch.Start();
+    
+    m_NextSlice = 0;
+    nrThread::Run( BakeSlices, this );
+    
+    stopwatch.Stop();
+    g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
+    
+    if ( ! Write( file_name, key ) )
+    {
+        g_Log.Write( "Unable to cache baked marble noise in \"%s\".\n", file_name );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrChannelMarble::NumShades( void )
+{
+	return m_NumShades;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+float nrChannelMarble::AverageOctaves( void )
+{
+	return m_NumShades > 0 ? ( float )( m_NumOctaves / m_NumShades ) : 0.0f;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 nrChannelMarble* nrChannelMarble::Parse( nrParser& parser )
 {
     nrChannelMarble* c = new nrChannelMarble;
+	nrArray< nrColor > colors;
 	
 	parser.ReadToken( nrParser::TOKEN_AGGREGATE_BEGIN );
 
@@ -84,9 +349,17 @@ nrChannelMarble* nrChannelMarble::Parse( nrParser& parser )
         {
             c->m_Octaves = parser.ReadInt();
         }
+        else if ( parser.KeyMatches( key, "bake" ) )
+        {
+            c->m_Bake = parser.ReadInt();
+            if ( c->m_Bake < 2 && c->m_Bake != 0 )
+            {
+                parser.ParseError( "bake resolution must be at least 2." );
+            }
+        }
         else if ( parser.KeyMatches( key, "ramp" ) )
         {
-			nrArray< nrColor > colors;
+			colors.Clear();
 			
 			parser.ReadToken( nrParser::TOKEN_AGGREGATE_BEGIN );
 			
@@ -103,6 +376,7 @@ nrChannelMarble* nrChannelMarble::Parse( nrParser& parser )
 			
 			parser.ReadToken( nrParser::TOKEN_AGGREGATE_END );
 			
+			delete c->m_ColorRamp;
 			c->m_ColorRamp = new nrColorRamp();
 			c->m_ColorRamp->CreateFromColors( colors );
         }
@@ -114,7 +388,213 @@ nrChannelMarble* nrChannelMarble::Parse( nrParser& parser )
 	
 	parser.ReadToken( nrParser::TOKEN_AGGREGATE_END );
 	
-	return c;
+	if ( parser.Error() )
+	{
+		return c;
+	}
+	
+	return Intern( c, colors );
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+float nrChannelMarble::Marble( const nrVector3& point, float footprint ) const
+{
+	float noise;
+	
+	// Unless the fractal noise is baked.
+	if ( ! m_Volume || ! Lookup( point, noise ) )
+	{
+		float octaves = Octaves( footprint );
+		
+		m_NumShades++;
+		m_NumOctaves += octaves;
+		
+		if ( octaves < m_Octaves )
+		{
+			noise = nrNoise::Fractal3( point * m_Scale, octaves );
+		}
+		else
+		{
+			noise = nrNoise::Fractal3( point * m_Scale, m_Octaves );
+		}
+	}
+	
+	// The same as nrNoise::Marble3(), with the fast sine (the error of
+	// which is far below a level of an 8 bit color).
+	return nrMath::Abs( nrFastMath::Sin( 180.0f * ( m_Period * ( point.x * m_Scale ) + m_Distortion * noise ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+float nrChannelMarble::Octaves( float footprint ) const
+{
+	// Octaves with a period smaller than the footprint (in noise space)
+	// would only alias, so they're left out.
+	float octaves = ( float )m_Octaves;
+	if ( footprint > 0.0f )
+	{
+		octaves = nrMath::Clamp( 1.0f - nrMath::Log2( footprint * m_Scale ), 1.0f, octaves );
+	}
+	
+	return octaves;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrChannelMarble::Lookup( const nrVector3& point, float& noise ) const
+{
+    float x = ( point.x - m_Bound.m_Minimums.x ) / m_Spacing;
+    float y = ( point.y - m_Bound.m_Minimums.y ) / m_Spacing;
+    float z = ( point.z - m_Bound.m_Minimums.z ) / m_Spacing;
+    
+    // Outside the volume, the noise is computed.
+    if ( ! ( x >= 0.0f && y >= 0.0f && z >= 0.0f &&
+             x <= m_Size[ 0 ] - 1 && y <= m_Size[ 1 ] - 1 && z <= m_Size[ 2 ] - 1 ) )
+    {
+        return false;
+    }
+    
+    int i = nrMath::Min( ( int )x, m_Size[ 0 ] - 2 );
+    int j = nrMath::Min( ( int )y, m_Size[ 1 ] - 2 );
+    int k = nrMath::Min( ( int )z, m_Size[ 2 ] - 2 );
+    
+    float u = x - i;
+    float v = y - j;
+    float w = z - k;
+    
+    int dy = m_Size[ 0 ];
+    int dz = m_Size[ 0 ] * m_Size[ 1 ];
+    
+    const float* s = m_Volume + i + j * dy + k * dz;
+    
+    float s00 = nrMath::Lerp( s[ 0 ],       s[ 1 ],           u );
+    float s10 = nrMath::Lerp( s[ dy ],      s[ dy + 1 ],      u );
+    float s01 = nrMath::Lerp( s[ dz ],      s[ dz + 1 ],      u );
+    float s11 = nrMath::Lerp( s[ dy + dz ], s[ dy + dz + 1 ], u );
+    
+    noise = nrMath::Lerp( nrMath::Lerp( s00, s10, v ), nrMath::Lerp( s01, s11, v ), w );
+    
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrChannelMarble::Read( const char* file_name, const char* key )
+{
+    FILE* file = fopen( file_name, "rb" );
+    if ( file == NULL )
+    {
+        return false;
+    }
+    
+    char k[ NR_MARBLE_KEY_LENGTH ];
+    int size[ 3 ];
+    int n = m_Size[ 0 ] * m_Size[ 1 ] * m_Size[ 2 ];
+    
+    bool read = 
+        fread( k, sizeof ( k ), 1, file ) == 1 &&
+        fread( size, sizeof ( size ), 1, file ) == 1 &&
+        strncmp( k, key, sizeof ( k ) ) == 0 &&
+        size[ 0 ] == m_Size[ 0 ] && size[ 1 ] == m_Size[ 1 ] && size[ 2 ] == m_Size[ 2 ] &&
+        fread( m_Volume, sizeof ( float ), n, file ) == ( size_t )n;
+    
+    fclose( file );
+    
+    return read;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrChannelMarble::Write( const char* file_name, const char* key ) const
+{
+    FILE* file = fopen( file_name, "wb" );
+    if ( file == NULL )
+    {
+        return false;
+    }
+    
+    char k[ NR_MARBLE_KEY_LENGTH ];
+    memset( k, 0, sizeof ( k ) );
+    strncpy( k, key, sizeof ( k ) - 1 );
+    
+    int n = m_Size[ 0 ] * m_Size[ 1 ] * m_Size[ 2 ];
+    
+    bool written = 
+        fwrite( k, sizeof ( k ), 1, file ) == 1 &&
+        fwrite( m_Size, sizeof ( m_Size ), 1, file ) == 1 &&
+        fwrite( m_Volume, sizeof ( float ), n, file ) == ( size_t )n;
+    
+    fclose( file );
+    
+    return written;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrChannelMarble::BakeSlices( void* data, int thread, int num_threads )
+{
+    nrChannelMarble* c = ( nrChannelMarble* )data;
+    
+    const nrVector3& minimums = c->m_Bound.m_Minimums;
+    
+    int k;
+    while ( ( k = nrThread::Next( c->m_NextSlice ) ) < c->m_Size[ 2 ] )
+    {
+        float* s = c->m_Volume + k * c->m_Size[ 0 ] * c->m_Size[ 1 ];
+        
+        for ( int j = 0; j < c->m_Size[ 1 ]; j++ )
+        {
+            for ( int i = 0; i < c->m_Size[ 0 ]; i++ )
+            {
+                nrVector3 p( minimums.x + i * c->m_Spacing, 
+                             minimums.y + j * c->m_Spacing, 
+                             minimums.z + k * c->m_Spacing );
+                
+                *s++ = nrNoise::Fractal3( p * c->m_Scale, c->m_Octaves );
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrChannelMarble* nrChannelMarble::Intern( nrChannelMarble* channel, const nrArray< nrColor >& ramp )
+{
+    // Key on the bits of the parameters and of the ramp colors, so only
+    // identical channels match.
+    char* key = new char[ 64 + ramp.Length() * 27 ];
+    char* k = key;
+    
+    k += sprintf( k, "%08x %08x %08x %d %d", 
+        *( unsigned int* )&channel->m_Scale, *( unsigned int* )&channel->m_Period, 
+        *( unsigned int* )&channel->m_Distortion, channel->m_Octaves, channel->m_Bake );
+    
+    if ( channel->m_ColorRamp )
+    {
+        for ( int i = 0; i < ramp.Length(); i++ )
+        {
+            k += sprintf( k, " %08x %08x %08x", *( unsigned int* )&ramp[ i ].r, 
+                *( unsigned int* )&ramp[ i ].g, *( unsigned int* )&ramp[ i ].b );
+        }
+    }
+    
+    nrChannelMarble** c = m_Interned.Find( key );
+    if ( c )
+    {
+        delete [] key;
+        delete channel;
+        return *c;
+    }
+    
+    channel->m_Shared = true;
+    m_Interned.Add( key, channel );
+    
+    delete [] key;
+    
+    return channel;
 }
 
 ////////////////////////////////////////////////////////////////////////////
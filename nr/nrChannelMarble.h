@@ -16,7 +16,10 @@
 // Includes
 ////////////////////////////////////////////////////////////////////////////
 
+#include "nrArray.h"
+#include "nrBound.h"
 #include "nrChannel.h"
+#include "nrHash.h"
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -36,17 +39,76 @@ public:
     nrChannelMarble( float scale = 1.0f, float period = 1.0f, float distortion = 1.0f, int octaves = 8 );
     virtual ~nrChannelMarble( void );
     
-    // Return the color of this channel.
-    virtual nrColor Color( const nrVector3& point ) const;
+    // Return the color of this channel.  Octaves of noise finer than the
+    // footprint are left out (the last one is faded), unless the noise
+    // is baked.
+    virtual nrColor Color( const nrVector3& point, float footprint = 0.0f ) const;
+    
+    // Compute the marble (before the ramp, in [ 0..1 ]) at a batch of 
+    // count points with the given footprints, 8 points at a time.  The
+    // same as Color(), point for point.
+    void Marble( const float* x, const float* y, const float* z, const float* footprint, int count, float* marble ) const;
+    
+    // Emit the marble (and the ramp) into the program.
+    virtual int Compile( nrProgram& program ) const;
 	
+    // If the channel has a bake resolution, precompute the fractal noise
+    // over the bound into a volume with that many samples along its 
+    // longest side.  The volume is cached on disk (in the current 
+    // directory), keyed by the noise parameters, the resolution and the
+    // bound, so later renders of the same scene just read it back in.
+    virtual void Bake( const nrBound& bound );
+    
     // Return a new channel parsed from a file.  The channel directive
     // has the following form:
     // 
-    // marble < scale period distortion (octaves) >
+    // marble {
+    //   (scale s)
+    //   (period p)
+    //   (distortion d)
+    //   (octaves n)
+    //   (ramp { < r g b > ... })
+    //   (bake resolution)
+    // }
     // 
-    // elements in ()'s are optional.
+    // elements in ()'s are optional.  With a bake resolution the noise is
+    // looked up in the baked volume (with trilinear interpolation) rather
+    // than computed at every point; higher resolutions take longer to
+    // bake and use more memory, but are closer to the computed noise.
+    // Channels are interned by content, so every marble directive with
+    // the same parameters (and ramp) returns the same shared channel.
     static nrChannelMarble* Parse( nrParser& parser );
 	
+    // Return the number of times noise was computed (rather than looked
+    // up in a baked volume) by all marble channels, and the average 
+    // number of octaves it was computed with.
+    static int NumShades( void );
+    static float AverageOctaves( void );
+    
+private:
+	
+    // Return the marble (before the ramp) at a point.
+    float Marble( const nrVector3& point, float footprint ) const;
+    
+    // Return the number of octaves of noise to compute for a footprint.
+    float Octaves( float footprint ) const;
+    
+    // Return true (and the fractal noise at the point) if the point is
+    // inside the baked volume, false otherwise.
+    bool Lookup( const nrVector3& point, float& noise ) const;
+    
+    // Read/Write the baked volume from/to the cache file.
+    bool Read( const char* file_name, const char* key );
+    bool Write( const char* file_name, const char* key ) const;
+    
+    // Bake slices of the volume (run on each thread, see nrThread).
+    static void BakeSlices( void* data, int thread, int num_threads );
+    
+    // Return the interned channel identical to the channel (with the 
+    // colors of the ramp it was created from), deleting the channel, or
+    // intern the channel and return it if there is none.
+    static nrChannelMarble* Intern( nrChannelMarble* channel, const nrArray< nrColor >& ramp );
+    
 private:
 	
 	float m_Scale;
@@ -54,6 +116,21 @@ private:
 	float m_Distortion;
 	int m_Octaves;
 	nrColorRamp* m_ColorRamp;
+	
+    // The baked volume: m_Bake samples along the longest side, 
+    // m_Size[ 0 ] * m_Size[ 1 ] * m_Size[ 2 ] samples in all, spaced 
+    // m_Spacing apart starting at the minimum corner of m_Bound.
+    int m_Bake;
+    int m_Size[ 3 ];
+    float m_Spacing;
+    nrBound m_Bound;
+    float* m_Volume;
+    
+    volatile int m_NextSlice;
+    
+    static nrHash< nrChannelMarble* > m_Interned;
+    static int m_NumShades;
+    static double m_NumOctaves;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -82,6 +82,20 @@ nrCmdLineArg::nrCmdLineArg( const char* _switch, const char* parameter, const ch
 
 ////////////////////////////////////////////////////////////////////////////
 
+nrCmdLineArg::nrCmdLineArg( const char* _switch, const char* parameter, const char* _default, const char* description, int* variables, int count )
+{
+    m_Switch = _switch;
+    m_Parameter = parameter;
+    m_Default = _default;
+    m_Description = description;
+    m_Type = CMDLINEARG_INTS;
+    m_Int = variables;
+    m_Length = count;
+    m_Parsed = false;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 void nrCmdLineArg::Parse( const char* parameter )
 {
     switch ( m_Type )
@@ -110,6 +124,20 @@ void nrCmdLineArg::Parse( const char* parameter )
             strncpy( m_String, parameter, m_Length - 1 );
         }
         break;
+    case CMDLINEARG_INTS:
+        if ( m_Int )
+        {
+            for ( int i = 0; i < m_Length; i++ )
+            {
+                int n = 0;
+                if ( sscanf( parameter, "%d%n", &m_Int[ i ], &n ) != 1 )
+                {
+                    break;
+                }
+                parameter += n;
+            }
+        }
+        break;
     default:
         assert( 0 );
         break;
@@ -160,13 +188,36 @@ bool nrCmdLine::Parse( int argc, const char** argv )
             
             if ( s.m_Switch && strcmp( _switch, s.m_Switch ) == 0 )
             {
-                n++;
-                if ( n >= argc )
+                // Most switches take one parameter, but a list of ints
+                // takes one for each (joined up, as its default is).
+                int count = ( s.m_Type == nrCmdLineArg::CMDLINEARG_INTS ) ? s.m_Length : 1;
+                
+                if ( n + count >= argc )
                 {
                     g_Log.Write( "nrCmdLine::Parse(): Malformed command line (switch requires a parameter).\n " );
                     return false;
                 }
-                s.Parse( argv[ n ] );
+                
+                if ( count == 1 )
+                {
+                    n++;
+                    s.Parse( argv[ n ] );
+                }
+                else
+                {
+                    char parameter[ 256 ] = "";
+                    for ( int k = 0; k < count; k++ )
+                    {
+                        n++;
+                        int room = ( int )sizeof ( parameter ) - ( int )strlen( parameter ) - 2;
+                        if ( room > 0 )
+                        {
+                            strncat( parameter, argv[ n ], room );
+                            strcat( parameter, " " );
+                        }
+                    }
+                    s.Parse( parameter );
+                }
                 parsed = true;
                 break;
             }
@@ -50,6 +50,10 @@ public:
     nrCmdLineArg( const char* _switch, const char* parameter, const char* _default, const char* description, float& variable );
     nrCmdLineArg( const char* _switch, const char* parameter, const char* _default, const char* description, char* variable, int length );
     
+    // A switch followed by count integers (the default is a string of
+    // them, separated by spaces).
+    nrCmdLineArg( const char* _switch, const char* parameter, const char* _default, const char* description, int* variables, int count );
+    
 private:
 
     void Parse( const char* parameter );
@@ -62,6 +66,7 @@ private:
         CMDLINEARG_BOOL,
         CMDLINEARG_FLOAT,
         CMDLINEARG_STRING,
+        CMDLINEARG_INTS,
     };
     
 private:
@@ -71,7 +76,7 @@ private:
     const char* m_Default;
     const char* m_Description;
     int         m_Type;
-    int         m_Length;
+    int         m_Length;       // Of a string, or number of ints.
     bool        m_Parsed;
     
     union
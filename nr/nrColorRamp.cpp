@@ -18,6 +18,9 @@
 #include "nrImage.h"
 #include "nrPixel.h"
 #include "nrMath.h"
+#include "nrSimd.h"
+
+#include <stddef.h>
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -28,6 +31,8 @@ nrColorRamp::nrColorRamp( void )
 {
 	m_NumEntries = 0;
 	m_ColorRamp = 0;
+	m_Memory = 0;
+	m_Table = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -35,6 +40,7 @@ nrColorRamp::nrColorRamp( void )
 nrColorRamp::~nrColorRamp( void )
 {
 	delete [] m_ColorRamp;
+	delete [] m_Memory;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -54,6 +60,8 @@ void nrColorRamp::CreateFromImage( const nrImage& image )
 		m_ColorRamp[ i ].g = ( float )pixel.g / 255.0f;
 		m_ColorRamp[ i ].b = ( float )pixel.b / 255.0f;
 	}
+	
+	Resample();
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -69,11 +77,105 @@ void nrColorRamp::CreateFromColors( const nrArray< nrColor >& colors )
 	{
 		m_ColorRamp[ i ] = colors[ i ];
 	}
+	
+	Resample();
 }
 
 ///////////////////////////////////////////////////////////////////////////
 
 nrColor nrColorRamp::Color( float value ) const
+{
+	if ( m_Table == 0 )
+	{
+		return nrColor( 0, 0, 0 );
+	}
+	
+	value = nrMath::Clamp( value, 0.0f, 1.0f );
+	
+	float entry = value * NR_COLOR_RAMP_SIZE;
+	
+	int i = nrMath::Min( ( int )entry, NR_COLOR_RAMP_SIZE - 1 );
+	
+	float t = entry - i;
+	float u = 1.0f - t;
+	
+	const float* a = m_Table + i * 4;
+	
+	return nrColor( a[ 0 ] * u + a[ 4 ] * t, a[ 1 ] * u + a[ 5 ] * t, a[ 2 ] * u + a[ 6 ] * t );
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void nrColorRamp::Color( const float* values, int count, float* r, float* g, float* b ) const
+{
+	int i = 0;
+	
+#ifdef NR_AVX2
+	if ( m_Table )
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps( 1.0f );
+		const __m256 size = _mm256_set1_ps( ( float )NR_COLOR_RAMP_SIZE );
+		const __m256i last = _mm256_set1_epi32( NR_COLOR_RAMP_SIZE - 1 );
+		
+		for ( ; i + 8 <= count; i += 8 )
+		{
+			__m256 value = _mm256_min_ps( _mm256_max_ps( _mm256_loadu_ps( values + i ), zero ), one );
+			__m256 entry = _mm256_mul_ps( value, size );
+			
+			__m256i e = _mm256_min_epi32( _mm256_cvttps_epi32( entry ), last );
+			
+			__m256 t = _mm256_sub_ps( entry, _mm256_cvtepi32_ps( e ) );
+			__m256 u = _mm256_sub_ps( one, t );
+			
+			// Index the interleaved table by entry * 4.
+			__m256i index = _mm256_slli_epi32( e, 2 );
+			
+			__m256 r0 = _mm256_i32gather_ps( m_Table + 0, index, 4 );
+			__m256 r1 = _mm256_i32gather_ps( m_Table + 4, index, 4 );
+			__m256 g0 = _mm256_i32gather_ps( m_Table + 1, index, 4 );
+			__m256 g1 = _mm256_i32gather_ps( m_Table + 5, index, 4 );
+			__m256 b0 = _mm256_i32gather_ps( m_Table + 2, index, 4 );
+			__m256 b1 = _mm256_i32gather_ps( m_Table + 6, index, 4 );
+			
+			_mm256_storeu_ps( r + i, _mm256_add_ps( _mm256_mul_ps( r0, u ), _mm256_mul_ps( r1, t ) ) );
+			_mm256_storeu_ps( g + i, _mm256_add_ps( _mm256_mul_ps( g0, u ), _mm256_mul_ps( g1, t ) ) );
+			_mm256_storeu_ps( b + i, _mm256_add_ps( _mm256_mul_ps( b0, u ), _mm256_mul_ps( b1, t ) ) );
+		}
+	}
+#endif
+	
+	for ( ; i < count; i++ )
+	{
+		nrColor c = Color( values[ i ] );
+		
+		r[ i ] = c.r;
+		g[ i ] = c.g;
+		b[ i ] = c.b;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+int nrColorRamp::Size( void ) const
+{
+	return m_Table ? NR_COLOR_RAMP_SIZE + 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+nrColor nrColorRamp::Entry( int i ) const
+{
+	const float* a = m_Table + i * 4;
+	
+	return nrColor( a[ 0 ], a[ 1 ], a[ 2 ] );
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+nrColor nrColorRamp::Interpolate( float value ) const
 {
 	value = nrMath::Clamp( value, 0.0f, 1.0f );
 	
@@ -87,4 +189,32 @@ nrColor nrColorRamp::Color( float value ) const
 	return nrColor::Lerp( a, b, t );
 }
 
+///////////////////////////////////////////////////////////////////////////
+
+void nrColorRamp::Resample( void )
+{
+	delete [] m_Memory;
+	m_Memory = 0;
+	m_Table = 0;
+	
+	if ( m_NumEntries == 0 )
+	{
+		return;
+	}
+	
+	// Align the table to 16 bytes.
+	m_Memory = new float[ ( NR_COLOR_RAMP_SIZE + 1 ) * 4 + 3 ];
+	m_Table = ( float* )( ( ( size_t )m_Memory + 15 ) & ~( size_t )15 );
+	
+	for ( int i = 0; i <= NR_COLOR_RAMP_SIZE; i++ )
+	{
+		nrColor c = Interpolate( ( float )i / NR_COLOR_RAMP_SIZE );
+		
+		m_Table[ i * 4 + 0 ] = c.r;
+		m_Table[ i * 4 + 1 ] = c.g;
+		m_Table[ i * 4 + 2 ] = c.b;
+		m_Table[ i * 4 + 3 ] = 1.0f;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////
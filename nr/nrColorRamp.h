@@ -20,6 +20,15 @@
 #include "nrColor.h"
 
 
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// Number of segments the ramp is resampled into (a power of two).  The
+// table holds one more entry than this, so the last segment has an end.
+#define NR_COLOR_RAMP_SIZE 256
+
+
 ////////////////////////////////////////////////////////////////////////////
 // Classes
 ////////////////////////////////////////////////////////////////////////////
@@ -47,10 +56,35 @@ public:
     // ramp, and 1 is the end.
 	nrColor Color( float value ) const;
 	
+	// Return the colors for a batch of values (8 at a time, if AVX2 is 
+	// available).  The same as Color(), value for value.
+	void Color( const float* values, int count, float* r, float* g, float* b ) const;
+	
+	// Return the number of entries in the resampled table (one more than
+	// NR_COLOR_RAMP_SIZE), or 0 if the ramp hasn't been created, and an
+	// entry of the table.  Entry i is the color at i / NR_COLOR_RAMP_SIZE.
+	int Size( void ) const;
+	nrColor Entry( int i ) const;
+	
+private:
+	
+	// Return an interpolated color from the colors the ramp was created
+	// from.
+	nrColor Interpolate( float value ) const;
+	
+	// Resample the colors into the table.
+	void Resample( void );
+	
 private:
 	
 	int      m_NumEntries;
 	nrColor* m_ColorRamp;
+	
+	// The table, interleaved r, g, b, a (always 1), so an entry is a 
+	// single aligned 16 byte load.  m_Memory is the allocation m_Table is
+	// aligned within.
+	float*   m_Memory;
+	float*   m_Table;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,434 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrDenoiser.cpp
+//
+// A class for filtering the noise out of a rendered frame, guided by the
+// surfaces seen through each pixel.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrDenoiser.h"
+
+#include "nrFastMath.h"
+#include "nrLog.h"
+#include "nrSimd.h"
+#include "nrThread.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Globals
+////////////////////////////////////////////////////////////////////////////
+
+// The 5 x 5 B-spline kernel, the outer product of { 1, 4, 6, 4, 1 } / 16
+// with itself (every weight is exact in a float).
+static const float g_Kernel[ 5 ][ 5 ] =
+{
+    { 1.0f / 256.0f,  4.0f / 256.0f,  6.0f / 256.0f,  4.0f / 256.0f, 1.0f / 256.0f },
+    { 4.0f / 256.0f, 16.0f / 256.0f, 24.0f / 256.0f, 16.0f / 256.0f, 4.0f / 256.0f },
+    { 6.0f / 256.0f, 24.0f / 256.0f, 36.0f / 256.0f, 24.0f / 256.0f, 6.0f / 256.0f },
+    { 4.0f / 256.0f, 16.0f / 256.0f, 24.0f / 256.0f, 16.0f / 256.0f, 4.0f / 256.0f },
+    { 1.0f / 256.0f,  4.0f / 256.0f,  6.0f / 256.0f,  4.0f / 256.0f, 1.0f / 256.0f },
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrDenoiser::nrDenoiser( void )
+{
+    m_Width = 0;
+    m_Height = 0;
+    m_NX = 0;
+    m_NY = 0;
+    m_NZ = 0;
+    m_Depth = 0;
+    m_Material = 0;
+    m_SigmaColor = 0.25f;
+    m_SigmaNormal = 0.3f;
+    m_SigmaDepth = 0.05f;
+    m_Color[ 0 ] = 0;
+    m_Color[ 1 ] = 0;
+    m_Source = 0;
+    m_Step = 1;
+    m_InvColor = 0.0f;
+    m_InvNormal = 0.0f;
+    m_InvDepth = 0.0f;
+    m_Next = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrDenoiser::~nrDenoiser( void )
+{
+    delete [] m_NX;
+    delete [] m_NY;
+    delete [] m_NZ;
+    delete [] m_Depth;
+    delete [] m_Material;
+    delete [] m_Color[ 0 ];
+    delete [] m_Color[ 1 ];
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrDenoiser::Create( int width, int height )
+{
+    int n = width * height;
+
+    delete [] m_NX;
+    delete [] m_NY;
+    delete [] m_NZ;
+    delete [] m_Depth;
+    delete [] m_Material;
+    delete [] m_Color[ 0 ];
+    delete [] m_Color[ 1 ];
+
+    m_NX = new float[ n ];
+    m_NY = new float[ n ];
+    m_NZ = new float[ n ];
+    m_Depth = new float[ n ];
+    m_Material = new int[ n ];
+    m_Color[ 0 ] = new float[ n * 3 ];
+    m_Color[ 1 ] = new float[ n * 3 ];
+
+    if ( ! m_NX || ! m_NY || ! m_NZ || ! m_Depth || ! m_Material || ! m_Color[ 0 ] || ! m_Color[ 1 ] )
+    {
+        g_Log.Write( "nrDenoiser::Create() : Out of memory.\n" );
+        return false;
+    }
+
+    m_Width = width;
+    m_Height = height;
+
+    memset( m_NX, 0, n * sizeof ( float ) );
+    memset( m_NY, 0, n * sizeof ( float ) );
+    memset( m_NZ, 0, n * sizeof ( float ) );
+    memset( m_Depth, 0, n * sizeof ( float ) );
+    memset( m_Material, 0, n * sizeof ( int ) );
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrDenoiser::SetSigmas( float color, float normal, float depth )
+{
+    assert( color > 0.0f && normal > 0.0f && depth > 0.0f );
+
+    m_SigmaColor = color;
+    m_SigmaNormal = normal;
+    m_SigmaDepth = depth;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrDenoiser::Denoise( nrFrameBuffer& buffer, int iterations )
+{
+    assert( m_Material );
+    assert( buffer.Width() == m_Width && buffer.Height() == m_Height );
+
+    int n = m_Width * m_Height;
+    int p, c;
+
+    // Filter the colors (not the sums of the samples).
+    float* color = m_Color[ 0 ];
+
+    for ( p = 0; p < n; p++ )
+    {
+        const float* pixel = buffer.m_Pixels + p * 4;
+
+        for ( c = 0; c < 3; c++ )
+        {
+            color[ c * n + p ] = ( pixel[ 3 ] > 0.0f ) ? pixel[ c ] / pixel[ 3 ] : 0.0f;
+        }
+    }
+
+    m_Source = 0;
+    m_InvNormal = 1.0f / ( m_SigmaNormal * m_SigmaNormal );
+    m_InvDepth = 1.0f / ( m_SigmaDepth * m_SigmaDepth );
+
+    for ( int i = 0; i < iterations; i++ )
+    {
+        float sigma = m_SigmaColor / ( float )( 1 << i );
+
+        m_Step = 1 << i;
+        m_InvColor = 1.0f / ( sigma * sigma );
+        m_Next = 0;
+
+        nrThread::Run( FilterRows, this );
+
+        m_Source = 1 - m_Source;
+    }
+
+    color = m_Color[ m_Source ];
+
+    for ( p = 0; p < n; p++ )
+    {
+        float* pixel = buffer.m_Pixels + p * 4;
+
+        for ( c = 0; c < 3; c++ )
+        {
+            pixel[ c ] = color[ c * n + p ] * pixel[ 3 ];
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+double nrDenoiser::Noise( const nrFrameBuffer& buffer ) const
+{
+    assert( m_Material );
+    assert( buffer.Width() == m_Width && buffer.Height() == m_Height );
+
+    int w = m_Width;
+    double sum = 0.0;
+    int count = 0;
+
+    for ( int y = 1; y < m_Height - 1; y++ )
+    {
+        for ( int x = 1; x < w - 1; x++ )
+        {
+            int p = y * w + x;
+            int m = m_Material[ p ];
+
+            if ( m_Material[ p - 1 ] != m || m_Material[ p + 1 ] != m ||
+                 m_Material[ p - w ] != m || m_Material[ p + w ] != m )
+            {
+                continue;
+            }
+
+            nrColor c, l, r, b, t;
+            buffer.GetPixel( x, y, c );
+            buffer.GetPixel( x - 1, y, l );
+            buffer.GetPixel( x + 1, y, r );
+            buffer.GetPixel( x, y - 1, b );
+            buffer.GetPixel( x, y + 1, t );
+
+            double dr = c.r - ( l.r + r.r + b.r + t.r ) / 4.0;
+            double dg = c.g - ( l.g + r.g + b.g + t.g ) / 4.0;
+            double db = c.b - ( l.b + r.b + b.b + t.b ) / 4.0;
+
+            sum += dr * dr + dg * dg + db * db;
+            count++;
+        }
+    }
+
+    return count > 0 ? sqrt( sum / ( 3.0 * count ) ) : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+void nrDenoiser::FilterRows( void* data, int thread, int num_threads )
+{
+    nrDenoiser* denoiser = ( nrDenoiser* )data;
+
+    int y;
+    while ( ( y = nrThread::Next( denoiser->m_Next ) ) < denoiser->m_Height )
+    {
+        denoiser->FilterRow( y );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrDenoiser::FilterRow( int y ) const
+{
+    int w = m_Width;
+    int x = 0;
+
+#ifdef NR_AVX2
+    // The pixels at least 2 steps from the left and right edges, 8 at a
+    // time: the same sums as FilterPixel(), in the same order, where a tap
+    // of another material weighs 0 (rather than being skipped).
+    int n = m_Width * m_Height;
+    int s = 2 * m_Step;
+
+    const float* r = m_Color[ m_Source ];
+    const float* g = r + n;
+    const float* b = g + n;
+
+    float* R = m_Color[ 1 - m_Source ];
+    float* G = R + n;
+    float* B = G + n;
+
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps( 1.0f );
+    __m256 negative = _mm256_set1_ps( -0.0f );
+    __m256 inv_color = _mm256_set1_ps( m_InvColor );
+    __m256 inv_normal = _mm256_set1_ps( m_InvNormal );
+    __m256 inv_depth = _mm256_set1_ps( m_InvDepth );
+
+    for ( ; x < w && x < s; x++ )
+    {
+        FilterPixel( x, y );
+    }
+
+    for ( ; x + 8 + s <= w; x += 8 )
+    {
+        int p = y * w + x;
+
+        __m256 pr = _mm256_loadu_ps( r + p );
+        __m256 pg = _mm256_loadu_ps( g + p );
+        __m256 pb = _mm256_loadu_ps( b + p );
+        __m256 pnx = _mm256_loadu_ps( m_NX + p );
+        __m256 pny = _mm256_loadu_ps( m_NY + p );
+        __m256 pnz = _mm256_loadu_ps( m_NZ + p );
+        __m256 pz = _mm256_loadu_ps( m_Depth + p );
+        __m256i pm = _mm256_loadu_si256( ( const __m256i* )( m_Material + p ) );
+
+        __m256 rz = _mm256_div_ps( one, _mm256_blendv_ps( one, pz, _mm256_cmp_ps( pz, zero, _CMP_GT_OQ ) ) );
+
+        __m256 sr = zero;
+        __m256 sg = zero;
+        __m256 sb = zero;
+        __m256 sw = zero;
+
+        for ( int j = -2; j <= 2; j++ )
+        {
+            int yy = y + j * m_Step;
+            if ( yy < 0 || yy >= m_Height )
+            {
+                continue;
+            }
+
+            for ( int i = -2; i <= 2; i++ )
+            {
+                int q = yy * w + x + i * m_Step;
+
+                __m256 qr = _mm256_loadu_ps( r + q );
+                __m256 qg = _mm256_loadu_ps( g + q );
+                __m256 qb = _mm256_loadu_ps( b + q );
+
+                __m256 dr = _mm256_sub_ps( qr, pr );
+                __m256 dg = _mm256_sub_ps( qg, pg );
+                __m256 db = _mm256_sub_ps( qb, pb );
+                __m256 dc = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dr, dr ), _mm256_mul_ps( dg, dg ) ), _mm256_mul_ps( db, db ) );
+
+                __m256 dx = _mm256_sub_ps( _mm256_loadu_ps( m_NX + q ), pnx );
+                __m256 dy = _mm256_sub_ps( _mm256_loadu_ps( m_NY + q ), pny );
+                __m256 dz = _mm256_sub_ps( _mm256_loadu_ps( m_NZ + q ), pnz );
+                __m256 dn = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dx, dx ), _mm256_mul_ps( dy, dy ) ), _mm256_mul_ps( dz, dz ) );
+
+                __m256 dd = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( m_Depth + q ), pz ), rz );
+                dd = _mm256_mul_ps( dd, dd );
+
+                __m256 e = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dc, inv_color ), _mm256_mul_ps( dn, inv_normal ) ),
+                                          _mm256_mul_ps( dd, inv_depth ) );
+
+                __m256 same = _mm256_castsi256_ps( _mm256_cmpeq_epi32( _mm256_loadu_si256( ( const __m256i* )( m_Material + q ) ), pm ) );
+                __m256 weight = _mm256_mul_ps( _mm256_set1_ps( g_Kernel[ j + 2 ][ i + 2 ] ), nrFastMath::Exp( _mm256_xor_ps( e, negative ) ) );
+                weight = _mm256_and_ps( weight, same );
+
+                sr = _mm256_add_ps( sr, _mm256_mul_ps( weight, qr ) );
+                sg = _mm256_add_ps( sg, _mm256_mul_ps( weight, qg ) );
+                sb = _mm256_add_ps( sb, _mm256_mul_ps( weight, qb ) );
+                sw = _mm256_add_ps( sw, weight );
+            }
+        }
+
+        _mm256_storeu_ps( R + p, _mm256_div_ps( sr, sw ) );
+        _mm256_storeu_ps( G + p, _mm256_div_ps( sg, sw ) );
+        _mm256_storeu_ps( B + p, _mm256_div_ps( sb, sw ) );
+    }
+#endif
+
+    for ( ; x < w; x++ )
+    {
+        FilterPixel( x, y );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrDenoiser::FilterPixel( int x, int y ) const
+{
+    int w = m_Width;
+    int n = m_Width * m_Height;
+    int p = y * w + x;
+
+    const float* r = m_Color[ m_Source ];
+    const float* g = r + n;
+    const float* b = g + n;
+
+    float pr = r[ p ];
+    float pg = g[ p ];
+    float pb = b[ p ];
+    float pz = m_Depth[ p ];
+    int pm = m_Material[ p ];
+
+    // Depths are compared relative to the pixel's (the background has
+    // none).
+    float rz = 1.0f / ( ( pz > 0.0f ) ? pz : 1.0f );
+
+    float sr = 0.0f;
+    float sg = 0.0f;
+    float sb = 0.0f;
+    float sw = 0.0f;
+
+    for ( int j = -2; j <= 2; j++ )
+    {
+        int yy = y + j * m_Step;
+        if ( yy < 0 || yy >= m_Height )
+        {
+            continue;
+        }
+
+        for ( int i = -2; i <= 2; i++ )
+        {
+            int xx = x + i * m_Step;
+            if ( xx < 0 || xx >= w )
+            {
+                continue;
+            }
+
+            int q = yy * w + xx;
+            if ( m_Material[ q ] != pm )
+            {
+                continue;
+            }
+
+            float dr = r[ q ] - pr;
+            float dg = g[ q ] - pg;
+            float db = b[ q ] - pb;
+            float dc = ( dr * dr + dg * dg ) + db * db;
+
+            float dx = m_NX[ q ] - m_NX[ p ];
+            float dy = m_NY[ q ] - m_NY[ p ];
+            float dz = m_NZ[ q ] - m_NZ[ p ];
+            float dn = ( dx * dx + dy * dy ) + dz * dz;
+
+            float dd = ( m_Depth[ q ] - pz ) * rz;
+            dd = dd * dd;
+
+            float e = ( dc * m_InvColor + dn * m_InvNormal ) + dd * m_InvDepth;
+
+            float weight = g_Kernel[ j + 2 ][ i + 2 ] * nrFastMath::Exp( -e );
+
+            sr = sr + weight * r[ q ];
+            sg = sg + weight * g[ q ];
+            sb = sb + weight * b[ q ];
+            sw = sw + weight;
+        }
+    }
+
+    float* R = m_Color[ 1 - m_Source ];
+
+    R[ p ] = sr / sw;
+    R[ n + p ] = sg / sw;
+    R[ n * 2 + p ] = sb / sw;
+}
+
+////////////////////////////////////////////////////////////////////////////
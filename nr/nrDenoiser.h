@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrDenoiser.h
+//
+// A class for filtering the noise out of a rendered frame, guided by the
+// surfaces seen through each pixel.
+//
+// The filter is the edge-avoiding a-trous wavelet filter (see Dammertz et
+// al., "Edge-Avoiding A-Trous Wavelet Transform for fast Global
+// Illumination Filtering", HPG 2010): each iteration convolves the frame
+// with a 5 x 5 B-spline kernel whose taps are spread 2^i pixels apart, so
+// a few iterations cover a wide footprint with 25 taps a pixel each.  The
+// weight of a tap falls off with its difference from the pixel in color,
+// normal and (relative) depth, and is 0 if it saw another material, so
+// the filter smooths within surfaces but not across their edges.  The
+// color difference allowed halves with each iteration, as the noise does.
+//
+// The guide (a G-buffer) is set a pixel at a time by the tracer, from the
+// primary hit through the pixel.  The rows are filtered on several
+// threads at once (see nrThread) and, if AVX2 is available (see
+// nrSimd.h), 8 pixels at a time, with the same results.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRDENOISER_H
+#define NRDENOISER_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrFrameBuffer.h"
+#include "nrVector3.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrDenoiser
+{
+public:
+
+    nrDenoiser( void );
+    ~nrDenoiser( void );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Create the G-buffer for a frame of the specified dimensions, with
+    // nothing (material 0) seen through any pixel.
+    //
+    // If successful, returns true, otherwise returns false and writes an
+    // error message to the global log.
+    bool Create( int width, int height );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Set what was seen through a pixel: the (unit) normal, depth and
+    // material (see nrMaterial::m_ID) of the surface hit, or material 0
+    // for nothing (the background).
+    //
+    // Out of range x,y are clipped (i.e., the G-buffer is unchanged).
+    inline void SetPixel( int x, int y, const nrVector3& normal, float depth, int material );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Set how far apart in color (for the first iteration), normal
+    // (unit vectors) and relative depth the pixels a tap is weighted
+    // e^-1 are.
+    void SetSigmas( float color, float normal, float depth );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Filter the colors of a frame buffer (of the same dimensions) over
+    // the given number of iterations.  The weights of the pixels are kept.
+    void Denoise( nrFrameBuffer& buffer, int iterations );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Return an estimate of the noise in a frame buffer: the RMS of the
+    // difference between each pixel and the average of its 4 neighbors,
+    // over the pixels whose neighbors all saw the same material.
+    double Noise( const nrFrameBuffer& buffer ) const;
+
+private:
+
+    // Filter the rows of the iteration, on each thread (see
+    // nrThread::Run()).
+    static void FilterRows( void* data, int thread, int num_threads );
+
+    // Filter row y of the iteration.
+    void FilterRow( int y ) const;
+
+    // Filter pixel ( x, y ) of the iteration (FilterRow() filters 8 at a
+    // time, where their taps are all in the frame).
+    void FilterPixel( int x, int y ) const;
+
+    // Not copyable.
+    nrDenoiser( const nrDenoiser& );
+    nrDenoiser& operator=( const nrDenoiser& );
+
+private:
+
+    int m_Width;
+    int m_Height;
+
+    // The G-buffer, a plane (row by row) of each of the normal
+    // components, the depth and the material.
+    float* m_NX;
+    float* m_NY;
+    float* m_NZ;
+    float* m_Depth;
+    int* m_Material;
+
+    float m_SigmaColor;
+    float m_SigmaNormal;
+    float m_SigmaDepth;
+
+    // The colors, filtered from m_Color[ m_Source ] into the other, a
+    // plane of red, then green, then blue.
+    float* m_Color[ 2 ];
+    int m_Source;
+
+    // The iteration being filtered.
+    int m_Step;                 // Pixels between taps.
+    float m_InvColor;           // 1 / sigma^2 of each guide.
+    float m_InvNormal;
+    float m_InvDepth;
+    volatile int m_Next;        // Next row to filter (see FilterRows()).
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrDenoiser.inl"
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRDENOISER_H
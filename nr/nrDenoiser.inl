@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrDenoiser.inl
+//
+// A class for filtering the noise out of a rendered frame, guided by the
+// surfaces seen through each pixel.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrDenoiser.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+inline void nrDenoiser::SetPixel( int x, int y, const nrVector3& normal, float depth, int material )
+{
+    if ( x < 0 || x >= m_Width || y < 0 || y >= m_Height )
+    {
+        return;
+    }
+
+    int p = y * m_Width + x;
+
+    m_NX[ p ] = normal.x;
+    m_NY[ p ] = normal.y;
+    m_NZ[ p ] = normal.z;
+    m_Depth[ p ] = depth;
+    m_Material[ p ] = material;
+}
+
+////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrFastMath.h
+//
+// A class for fast (approximate) math.
+//
+// The functions here are polynomial approximations which trade a little
+// accuracy (and range) for speed; nrMath has the accurate versions.  A
+// call site picks one or the other, e.g., nrMath::Sin() or
+// nrFastMath::Sin().  Each function has a scalar version and, if AVX2 is
+// available (see nrSimd.h), an 8 wide version which computes exactly the
+// same results.  The error bounds below were measured against double
+// precision over the given ranges (see tools/fastmath).
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRFASTMATH_H
+#define NRFASTMATH_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSimd.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrFastMath
+{
+public:
+
+    // Return the sine/cosine of an angle in degrees.  The largest error
+    // is 1.2e-7 (absolute) for |angle| < 1e6.
+    inline static float Sin( float angle_in_degrees );
+    inline static float Cos( float angle_in_degrees );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Return the sine/cosine of an angle in radians.  The largest error
+    // is 1.2e-7 (absolute) for |angle| < 1e4.
+    inline static float SinRadians( float angle_in_radians );
+    inline static float CosRadians( float angle_in_radians );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Return e to the power x.  x is clamped to [ -87, 88 ].  The largest
+    // error is 2.5e-7 (relative).
+    inline static float Exp( float x );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Return the natural logarithm of x, which must be positive, finite
+    // and normalized.  The largest error is 1.2e-7 (absolute) for x in
+    // [ 0.5, 2 ], and 1.2e-7 (relative) elsewhere.
+    inline static float Log( float x );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Return x (which must be positive) to the power y, as Exp( y *
+    // Log( x ) ).  The relative error grows with | y * Log( x ) |: it
+    // is about 2.5e-7 + 1.2e-7 * | y * Log( x ) |.
+    inline static float Pow( float x, float y );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Return 1 / Sqrt( x ), for positive x.  The largest error is 1.5e-7
+    // (relative).
+    inline static float RSqrt( float x );
+
+    ////////////////////////////////////////////////////////////////////////
+
+#ifdef NR_AVX2
+    // The same as the functions above, 8 at a time.
+    inline static __m256 Sin( __m256 angle_in_degrees );
+    inline static __m256 Cos( __m256 angle_in_degrees );
+    inline static __m256 SinRadians( __m256 angle_in_radians );
+    inline static __m256 CosRadians( __m256 angle_in_radians );
+    inline static __m256 Exp( __m256 x );
+    inline static __m256 Log( __m256 x );
+    inline static __m256 Pow( __m256 x, __m256 y );
+    inline static __m256 RSqrt( __m256 x );
+
+    ////////////////////////////////////////////////////////////////////////
+#endif
+
+private:
+
+    nrFastMath( void );
+    ~nrFastMath( void );
+
+    // Return x rounded to the nearest integer (ties to even), for
+    // |x| < 2^22.
+    inline static float Round( float x );
+
+    // Return sin( r ), for r in [ -pi / 2, pi / 2 ].
+    inline static float SinPolynomial( float r );
+
+    // Return the bits of a float, and the float with the given bits.
+    inline static unsigned int Bits( float x );
+    inline static float Float( unsigned int bits );
+
+#ifdef NR_AVX2
+    inline static __m256 Round( __m256 x );
+    inline static __m256 SinPolynomial( __m256 r );
+#endif
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrFastMath.inl"
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRFASTMATH_H
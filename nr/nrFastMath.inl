@@ -0,0 +1,416 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrFastMath.inl
+//
+// A class for fast (approximate) math.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrFastMath.h"
+
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// Adding and subtracting this rounds a float to the nearest integer.
+#define NR_FAST_ROUND       12582912.0f
+
+// Pi in four parts (the first three with few enough bits that a product
+// with a small integer is exact), to reduce angles in radians.
+#define NR_FAST_PI_A        3.140625f
+#define NR_FAST_PI_B        0.0009670257568359375f
+#define NR_FAST_PI_C        6.2771141529083251953e-07f
+#define NR_FAST_PI_D        1.2154201256553420762e-10f
+#define NR_FAST_1_PI        0.318309886f
+#define NR_FAST_PI_180      0.0174532925f
+#define NR_FAST_1_180       0.00555555569f
+
+// Ln( 2 ) in two parts, to reduce the argument of Exp().
+#define NR_FAST_LN2_A       0.693359375f
+#define NR_FAST_LN2_B       -2.12194440e-4f
+#define NR_FAST_LOG2E       1.44269504f
+
+#define NR_FAST_SQRT2       1.41421356f
+
+// Minimax coefficients of sin( r ) = r + r^3 * S( r^2 ) on
+// [ -pi / 2, pi / 2 ].
+#define NR_FAST_SIN_0       -0.166666567f
+#define NR_FAST_SIN_1       0.00833301712f
+#define NR_FAST_SIN_2       -0.000198066147f
+#define NR_FAST_SIN_3       2.60005459e-06f
+
+// Minimax coefficients of exp( r ) = 1 + r + r^2 * E( r ) on
+// [ -ln( 2 ) / 2, ln( 2 ) / 2 ].
+#define NR_FAST_EXP_0       0.499992311f
+#define NR_FAST_EXP_1       0.166671142f
+#define NR_FAST_EXP_2       0.0418901145f
+#define NR_FAST_EXP_3       0.00831252523f
+
+// Minimax coefficients of log( 1 + f ) = f - f^2 / 2 + f^3 * L( f ) on
+// [ sqrt( 0.5 ) - 1, sqrt( 2 ) - 1 ].
+#define NR_FAST_LOG_0       0.333341658f
+#define NR_FAST_LOG_1       -0.250016987f
+#define NR_FAST_LOG_2       0.199548751f
+#define NR_FAST_LOG_3       -0.165644258f
+#define NR_FAST_LOG_4       0.149779946f
+#define NR_FAST_LOG_5       -0.143790096f
+#define NR_FAST_LOG_6       0.0867218524f
+
+// The initial guess for RSqrt() (refined by three Newton steps).
+#define NR_FAST_RSQRT       0x5f375a86
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::Sin( float angle_in_degrees )
+{
+    // Reduce the angle in degrees (which is exact, 180 being an integer)
+    // to r in [ -90, 90 ], so sin( angle ) = +/-sin( r ).
+    float q = Round( angle_in_degrees * NR_FAST_1_180 );
+    float r = ( angle_in_degrees - q * 180.0f ) * NR_FAST_PI_180;
+
+    unsigned int sign = ( ( unsigned int )( int )q ) << 31;
+
+    return Float( Bits( SinPolynomial( r ) ) ^ sign );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::Cos( float angle_in_degrees )
+{
+    return Sin( angle_in_degrees + 90.0f );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::SinRadians( float angle_in_radians )
+{
+    float q = Round( angle_in_radians * NR_FAST_1_PI );
+
+    float r = angle_in_radians - q * NR_FAST_PI_A;
+    r = r - q * NR_FAST_PI_B;
+    r = r - q * NR_FAST_PI_C;
+    r = r - q * NR_FAST_PI_D;
+
+    unsigned int sign = ( ( unsigned int )( int )q ) << 31;
+
+    return Float( Bits( SinPolynomial( r ) ) ^ sign );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::CosRadians( float angle_in_radians )
+{
+    // cos( angle ) = -( -1 )^q sin( r ), with angle = ( q + 1/2 ) pi + r.
+    float q = Round( angle_in_radians * NR_FAST_1_PI - 0.5f );
+    float k = q + 0.5f;
+
+    float r = angle_in_radians - k * NR_FAST_PI_A;
+    r = r - k * NR_FAST_PI_B;
+    r = r - k * NR_FAST_PI_C;
+    r = r - k * NR_FAST_PI_D;
+
+    unsigned int sign = ( ( unsigned int )( ( int )q + 1 ) ) << 31;
+
+    return Float( Bits( SinPolynomial( r ) ) ^ sign );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::Exp( float x )
+{
+    x = x < -87.0f ? -87.0f : ( x > 88.0f ? 88.0f : x );
+
+    // e^x = 2^n e^r, with r in [ -ln( 2 ) / 2, ln( 2 ) / 2 ].
+    float n = Round( x * NR_FAST_LOG2E );
+
+    float r = x - n * NR_FAST_LN2_A;
+    r = r - n * NR_FAST_LN2_B;
+
+    float p = NR_FAST_EXP_3;
+    p = p * r + NR_FAST_EXP_2;
+    p = p * r + NR_FAST_EXP_1;
+    p = p * r + NR_FAST_EXP_0;
+    p = p * ( r * r ) + r;
+    p = p + 1.0f;
+
+    return p * Float( ( unsigned int )( ( int )n + 127 ) << 23 );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::Log( float x )
+{
+    // x = 2^e m, with m in [ sqrt( 0.5 ), sqrt( 2 ) ).
+    unsigned int bits = Bits( x );
+
+    float e = ( float )( ( int )( bits >> 23 ) - 127 );
+    float m = Float( ( bits & 0x007fffff ) | 0x3f800000 );
+
+    if ( m > NR_FAST_SQRT2 )
+    {
+        m = m * 0.5f;
+        e = e + 1.0f;
+    }
+
+    float f = m - 1.0f;
+    float z = f * f;
+
+    float p = NR_FAST_LOG_6;
+    p = p * f + NR_FAST_LOG_5;
+    p = p * f + NR_FAST_LOG_4;
+    p = p * f + NR_FAST_LOG_3;
+    p = p * f + NR_FAST_LOG_2;
+    p = p * f + NR_FAST_LOG_1;
+    p = p * f + NR_FAST_LOG_0;
+
+    float y = p * ( z * f );
+    y = y + e * NR_FAST_LN2_B;
+    y = y - 0.5f * z;
+
+    return ( f + y ) + e * NR_FAST_LN2_A;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::Pow( float x, float y )
+{
+    return Exp( y * Log( x ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::RSqrt( float x )
+{
+    float h = 0.5f * x;
+    float y = Float( NR_FAST_RSQRT - ( Bits( x ) >> 1 ) );
+
+    y = y * ( 1.5f - ( h * y ) * y );
+    y = y * ( 1.5f - ( h * y ) * y );
+    y = y * ( 1.5f - ( h * y ) * y );
+
+    return y;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+#ifdef NR_AVX2
+
+inline __m256 nrFastMath::Sin( __m256 angle_in_degrees )
+{
+    __m256 q = Round( _mm256_mul_ps( angle_in_degrees, _mm256_set1_ps( NR_FAST_1_180 ) ) );
+    __m256 r = _mm256_mul_ps( _mm256_sub_ps( angle_in_degrees, _mm256_mul_ps( q, _mm256_set1_ps( 180.0f ) ) ),
+                              _mm256_set1_ps( NR_FAST_PI_180 ) );
+
+    __m256 sign = _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_cvtps_epi32( q ), 31 ) );
+
+    return _mm256_xor_ps( SinPolynomial( r ), sign );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline __m256 nrFastMath::Cos( __m256 angle_in_degrees )
+{
+    return Sin( _mm256_add_ps( angle_in_degrees, _mm256_set1_ps( 90.0f ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline __m256 nrFastMath::SinRadians( __m256 angle_in_radians )
+{
+    __m256 q = Round( _mm256_mul_ps( angle_in_radians, _mm256_set1_ps( NR_FAST_1_PI ) ) );
+
+    __m256 r = _mm256_sub_ps( angle_in_radians, _mm256_mul_ps( q, _mm256_set1_ps( NR_FAST_PI_A ) ) );
+    r = _mm256_sub_ps( r, _mm256_mul_ps( q, _mm256_set1_ps( NR_FAST_PI_B ) ) );
+    r = _mm256_sub_ps( r, _mm256_mul_ps( q, _mm256_set1_ps( NR_FAST_PI_C ) ) );
+    r = _mm256_sub_ps( r, _mm256_mul_ps( q, _mm256_set1_ps( NR_FAST_PI_D ) ) );
+
+    __m256 sign = _mm256_castsi256_ps( _mm256_slli_epi32( _mm256_cvtps_epi32( q ), 31 ) );
+
+    return _mm256_xor_ps( SinPolynomial( r ), sign );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline __m256 nrFastMath::CosRadians( __m256 angle_in_radians )
+{
+    __m256 q = Round( _mm256_sub_ps( _mm256_mul_ps( angle_in_radians, _mm256_set1_ps( NR_FAST_1_PI ) ),
+                                     _mm256_set1_ps( 0.5f ) ) );
+    __m256 k = _mm256_add_ps( q, _mm256_set1_ps( 0.5f ) );
+
+    __m256 r = _mm256_sub_ps( angle_in_radians, _mm256_mul_ps( k, _mm256_set1_ps( NR_FAST_PI_A ) ) );
+    r = _mm256_sub_ps( r, _mm256_mul_ps( k, _mm256_set1_ps( NR_FAST_PI_B ) ) );
+    r = _mm256_sub_ps( r, _mm256_mul_ps( k, _mm256_set1_ps( NR_FAST_PI_C ) ) );
+    r = _mm256_sub_ps( r, _mm256_mul_ps( k, _mm256_set1_ps( NR_FAST_PI_D ) ) );
+
+    __m256i n = _mm256_add_epi32( _mm256_cvtps_epi32( q ), _mm256_set1_epi32( 1 ) );
+    __m256 sign = _mm256_castsi256_ps( _mm256_slli_epi32( n, 31 ) );
+
+    return _mm256_xor_ps( SinPolynomial( r ), sign );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline __m256 nrFastMath::Exp( __m256 x )
+{
+    x = _mm256_min_ps( _mm256_max_ps( x, _mm256_set1_ps( -87.0f ) ), _mm256_set1_ps( 88.0f ) );
+
+    __m256 n = Round( _mm256_mul_ps( x, _mm256_set1_ps( NR_FAST_LOG2E ) ) );
+
+    __m256 r = _mm256_sub_ps( x, _mm256_mul_ps( n, _mm256_set1_ps( NR_FAST_LN2_A ) ) );
+    r = _mm256_sub_ps( r, _mm256_mul_ps( n, _mm256_set1_ps( NR_FAST_LN2_B ) ) );
+
+    __m256 p = _mm256_set1_ps( NR_FAST_EXP_3 );
+    p = _mm256_add_ps( _mm256_mul_ps( p, r ), _mm256_set1_ps( NR_FAST_EXP_2 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, r ), _mm256_set1_ps( NR_FAST_EXP_1 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, r ), _mm256_set1_ps( NR_FAST_EXP_0 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, _mm256_mul_ps( r, r ) ), r );
+    p = _mm256_add_ps( p, _mm256_set1_ps( 1.0f ) );
+
+    __m256i e = _mm256_slli_epi32( _mm256_add_epi32( _mm256_cvtps_epi32( n ), _mm256_set1_epi32( 127 ) ), 23 );
+
+    return _mm256_mul_ps( p, _mm256_castsi256_ps( e ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline __m256 nrFastMath::Log( __m256 x )
+{
+    __m256i bits = _mm256_castps_si256( x );
+
+    __m256 e = _mm256_cvtepi32_ps( _mm256_sub_epi32( _mm256_srli_epi32( bits, 23 ), _mm256_set1_epi32( 127 ) ) );
+    __m256 m = _mm256_castsi256_ps( _mm256_or_si256( _mm256_and_si256( bits, _mm256_set1_epi32( 0x007fffff ) ),
+                                                     _mm256_set1_epi32( 0x3f800000 ) ) );
+
+    __m256 big = _mm256_cmp_ps( m, _mm256_set1_ps( NR_FAST_SQRT2 ), _CMP_GT_OQ );
+    m = _mm256_blendv_ps( m, _mm256_mul_ps( m, _mm256_set1_ps( 0.5f ) ), big );
+    e = _mm256_blendv_ps( e, _mm256_add_ps( e, _mm256_set1_ps( 1.0f ) ), big );
+
+    __m256 f = _mm256_sub_ps( m, _mm256_set1_ps( 1.0f ) );
+    __m256 z = _mm256_mul_ps( f, f );
+
+    __m256 p = _mm256_set1_ps( NR_FAST_LOG_6 );
+    p = _mm256_add_ps( _mm256_mul_ps( p, f ), _mm256_set1_ps( NR_FAST_LOG_5 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, f ), _mm256_set1_ps( NR_FAST_LOG_4 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, f ), _mm256_set1_ps( NR_FAST_LOG_3 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, f ), _mm256_set1_ps( NR_FAST_LOG_2 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, f ), _mm256_set1_ps( NR_FAST_LOG_1 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, f ), _mm256_set1_ps( NR_FAST_LOG_0 ) );
+
+    __m256 y = _mm256_mul_ps( p, _mm256_mul_ps( z, f ) );
+    y = _mm256_add_ps( y, _mm256_mul_ps( e, _mm256_set1_ps( NR_FAST_LN2_B ) ) );
+    y = _mm256_sub_ps( y, _mm256_mul_ps( _mm256_set1_ps( 0.5f ), z ) );
+
+    return _mm256_add_ps( _mm256_add_ps( f, y ), _mm256_mul_ps( e, _mm256_set1_ps( NR_FAST_LN2_A ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline __m256 nrFastMath::Pow( __m256 x, __m256 y )
+{
+    return Exp( _mm256_mul_ps( y, Log( x ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline __m256 nrFastMath::RSqrt( __m256 x )
+{
+    __m256 h = _mm256_mul_ps( _mm256_set1_ps( 0.5f ), x );
+    __m256 y = _mm256_castsi256_ps( _mm256_sub_epi32( _mm256_set1_epi32( NR_FAST_RSQRT ),
+                                                      _mm256_srli_epi32( _mm256_castps_si256( x ), 1 ) ) );
+
+    __m256 three_halves = _mm256_set1_ps( 1.5f );
+
+    y = _mm256_mul_ps( y, _mm256_sub_ps( three_halves, _mm256_mul_ps( _mm256_mul_ps( h, y ), y ) ) );
+    y = _mm256_mul_ps( y, _mm256_sub_ps( three_halves, _mm256_mul_ps( _mm256_mul_ps( h, y ), y ) ) );
+    y = _mm256_mul_ps( y, _mm256_sub_ps( three_halves, _mm256_mul_ps( _mm256_mul_ps( h, y ), y ) ) );
+
+    return y;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::Round( float x )
+{
+    // Volatile, so the compiler doesn't fold the addition and subtraction.
+    volatile float y = x + NR_FAST_ROUND;
+    return y - NR_FAST_ROUND;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::SinPolynomial( float r )
+{
+    float z = r * r;
+
+    float p = NR_FAST_SIN_3;
+    p = p * z + NR_FAST_SIN_2;
+    p = p * z + NR_FAST_SIN_1;
+    p = p * z + NR_FAST_SIN_0;
+
+    return p * ( z * r ) + r;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline unsigned int nrFastMath::Bits( float x )
+{
+    unsigned int bits;
+    memcpy( &bits, &x, sizeof ( bits ) );
+    return bits;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrFastMath::Float( unsigned int bits )
+{
+    float x;
+    memcpy( &x, &bits, sizeof ( x ) );
+    return x;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+#ifdef NR_AVX2
+
+inline __m256 nrFastMath::Round( __m256 x )
+{
+    __m256 round = _mm256_set1_ps( NR_FAST_ROUND );
+    return _mm256_sub_ps( _mm256_add_ps( x, round ), round );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline __m256 nrFastMath::SinPolynomial( __m256 r )
+{
+    __m256 z = _mm256_mul_ps( r, r );
+
+    __m256 p = _mm256_set1_ps( NR_FAST_SIN_3 );
+    p = _mm256_add_ps( _mm256_mul_ps( p, z ), _mm256_set1_ps( NR_FAST_SIN_2 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, z ), _mm256_set1_ps( NR_FAST_SIN_1 ) );
+    p = _mm256_add_ps( _mm256_mul_ps( p, z ), _mm256_set1_ps( NR_FAST_SIN_0 ) );
+
+    return _mm256_add_ps( _mm256_mul_ps( p, _mm256_mul_ps( z, r ) ), r );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,267 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrFrameBuffer.cpp
+//
+// A class for floating point (high dynamic range) frame buffers.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrFrameBuffer.h"
+
+#include "nrFastMath.h"
+#include "nrLog.h"
+#include "nrMath.h"
+#include "nrSimd.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// The smallest color raised to 1 / gamma (nrFastMath::Pow() needs a
+// positive, normalized argument).
+#define NR_FRAMEBUFFER_TINY 1e-30f
+
+
+////////////////////////////////////////////////////////////////////////////
+// Globals
+////////////////////////////////////////////////////////////////////////////
+
+// The 8 x 8 Bayer matrix: the dither thresholds are ( b + 0.5 ) / 64.
+static const unsigned char g_Bayer[ 8 ][ 8 ] =
+{
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+// Store the first three of the quantized components q (one pixel) in dst,
+// in bytes (8 bit) or pairs of bytes (16 bit), and return the end of them.
+static inline unsigned char* nrFrameBufferStore( const int* q, int bits, unsigned char* dst )
+{
+    if ( bits == 16 )
+    {
+        for ( int c = 0; c < 3; c++ )
+        {
+            *dst++ = ( unsigned char )( q[ c ] >> 8 );
+            *dst++ = ( unsigned char )( q[ c ] & 0xFF );
+        }
+    }
+    else
+    {
+        *dst++ = ( unsigned char )q[ 0 ];
+        *dst++ = ( unsigned char )q[ 1 ];
+        *dst++ = ( unsigned char )q[ 2 ];
+    }
+
+    return dst;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrFrameBuffer::nrFrameBuffer( void )
+{
+    m_Width = 0;
+    m_Height = 0;
+    m_Pixels = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrFrameBuffer::~nrFrameBuffer( void )
+{
+    delete [] m_Pixels;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrFrameBuffer::Create( int width, int height )
+{
+    delete [] m_Pixels;
+
+    m_Pixels = new float[ width * height * 4 ];
+
+    if ( m_Pixels == NULL )
+    {
+        g_Log.Write( "nrFrameBuffer::Create() : Out of memory.\n" );
+        return false;
+    }
+
+    m_Width  = width;
+    m_Height = height;
+
+    Clear();
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrFrameBuffer::Clear( void )
+{
+    assert( m_Pixels );
+
+    memset( m_Pixels, 0, m_Width * m_Height * 4 * sizeof ( float ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrFrameBuffer::CopySub( const nrFrameBuffer& src, int src_x, int src_y, int src_w, int src_h, int dst_x, int dst_y )
+{
+    assert( m_Pixels && src.m_Pixels );
+
+    // Clip the portion to the source, then to this frame buffer.
+    if ( src_x < 0 )
+    {
+        src_w += src_x;
+        dst_x -= src_x;
+        src_x = 0;
+    }
+    if ( src_y < 0 )
+    {
+        src_h += src_y;
+        dst_y -= src_y;
+        src_y = 0;
+    }
+    if ( dst_x < 0 )
+    {
+        src_w += dst_x;
+        src_x -= dst_x;
+        dst_x = 0;
+    }
+    if ( dst_y < 0 )
+    {
+        src_h += dst_y;
+        src_y -= dst_y;
+        dst_y = 0;
+    }
+
+    int w = nrMath::Min3( src_w, src.m_Width - src_x, m_Width - dst_x );
+    int h = nrMath::Min3( src_h, src.m_Height - src_y, m_Height - dst_y );
+
+    if ( w <= 0 || h <= 0 )
+    {
+        return;
+    }
+
+    for ( int j = 0; j < h; j++ )
+    {
+        memmove( Pixel( dst_x, dst_y + j ), src.Pixel( src_x, src_y + j ), w * 4 * sizeof ( float ) );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrFrameBuffer::Resolve( int y, float exposure, float gamma, bool dither, int bits, unsigned char* dst ) const
+{
+    assert( m_Pixels );
+    assert( y >= 0 && y < m_Height );
+    assert( bits == 8 || bits == 16 );
+
+    float scale = ( float )pow( 2.0, exposure );
+    float power = 1.0f / gamma;
+    bool correct = ( gamma != 1.0f );
+    float maximum = ( bits == 16 ) ? 65535.0f : 255.0f;
+    int top = ( bits == 16 ) ? 65535 : 255;
+
+    // The dither thresholds of the row (0 without a dither), by column.
+    float thresholds[ 8 ];
+
+    int i;
+    for ( i = 0; i < 8; i++ )
+    {
+        thresholds[ i ] = dither ? ( ( float )g_Bayer[ y & 7 ][ i ] + 0.5f ) / 64.0f : 0.0f;
+    }
+
+    const float* p = Pixel( 0, y );
+    int q[ 8 ];
+    int x = 0;
+
+#ifdef NR_AVX2
+    // Two pixels at a time (the weights are in the fourth float of each).
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps( 1.0f );
+    __m256 tiny = _mm256_set1_ps( NR_FRAMEBUFFER_TINY );
+    __m256 vscale = _mm256_set1_ps( scale );
+    __m256 vpower = _mm256_set1_ps( power );
+    __m256 vmaximum = _mm256_set1_ps( maximum );
+    __m256i vtop = _mm256_set1_epi32( top );
+
+    for ( ; x + 2 <= m_Width; x += 2 )
+    {
+        __m256 v = _mm256_loadu_ps( p + x * 4 );
+        __m256 w = _mm256_permute_ps( v, 0xFF );
+
+        __m256 c = _mm256_and_ps( _mm256_div_ps( v, w ), _mm256_cmp_ps( w, zero, _CMP_GT_OQ ) );
+        c = _mm256_mul_ps( c, vscale );
+        c = _mm256_min_ps( _mm256_max_ps( c, zero ), one );
+
+        if ( correct )
+        {
+            c = nrFastMath::Pow( _mm256_max_ps( c, tiny ), vpower );
+        }
+
+        float t0 = thresholds[ x & 7 ];
+        float t1 = thresholds[ ( x + 1 ) & 7 ];
+        __m256 d = _mm256_set_ps( t1, t1, t1, t1, t0, t0, t0, t0 );
+
+        c = _mm256_add_ps( _mm256_mul_ps( c, vmaximum ), d );
+
+        _mm256_storeu_si256( ( __m256i* )q, _mm256_min_epi32( _mm256_cvttps_epi32( c ), vtop ) );
+
+        dst = nrFrameBufferStore( q, bits, dst );
+        dst = nrFrameBufferStore( q + 4, bits, dst );
+    }
+#endif
+
+    for ( ; x < m_Width; x++ )
+    {
+        const float* v = p + x * 4;
+        float w = v[ 3 ];
+
+        for ( int k = 0; k < 3; k++ )
+        {
+            float c = ( w > 0.0f ) ? v[ k ] / w : 0.0f;
+            c = c * scale;
+            c = ( c > 0.0f ) ? c : 0.0f;
+            c = ( c < 1.0f ) ? c : 1.0f;
+
+            if ( correct )
+            {
+                c = nrFastMath::Pow( ( c > NR_FRAMEBUFFER_TINY ) ? c : NR_FRAMEBUFFER_TINY, power );
+            }
+
+            c = c * maximum + thresholds[ x & 7 ];
+
+            q[ k ] = ( int )c;
+            q[ k ] = ( q[ k ] < top ) ? q[ k ] : top;
+        }
+
+        dst = nrFrameBufferStore( q, bits, dst );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
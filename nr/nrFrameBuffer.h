@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrFrameBuffer.h
+//
+// A class for floating point (high dynamic range) frame buffers.
+//
+// Each pixel is four floats: the red, green and blue sums of the samples
+// in it, and the sum of their weights, so that samples may be added up
+// (over several passes, or with a filter) before the pixel is resolved.
+// The color of a pixel is its sums divided by its weight.
+//
+// Resolve() maps the (linear) colors to integers for an image file: each
+// color is scaled by 2^exposure, clamped to [ 0, 1 ], raised to 1 /
+// gamma, and quantized to 8 or 16 bits, optionally with an ordered
+// (Bayer) dither.  Without a dither, quantizing truncates (so 8 bit
+// resolves with the defaults are the same as nrImage::SetPixel(), for
+// colors in [ 0, 1 ]); with one, the average of the quantized colors is
+// the color.  If AVX2 is
+// available (see nrSimd.h), two pixels are resolved at a time, with the
+// same results.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRFRAMEBUFFER_H
+#define NRFRAMEBUFFER_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrColor.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrFrameBuffer
+{
+public:
+
+    nrFrameBuffer( void );
+    ~nrFrameBuffer( void );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Create a frame buffer of the specified dimensions, cleared (to no
+    // samples).
+    //
+    // If successful, returns true, otherwise returns false and writes an
+    // error message to the global log.
+    bool Create( int width, int height );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Clear the frame buffer (to no samples).
+    void Clear( void );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Copy the portion src_w x src_h at ( src_x, src_y ) of another frame
+    // buffer to ( dst_x, dst_y ) in this one (see nrImage::CopySub()).
+    //
+    // The portion is clipped by both frame buffers.
+    void CopySub( const nrFrameBuffer& src, int src_x, int src_y, int src_w, int src_h, int dst_x = 0, int dst_y = 0 );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Set a pixel to a color (a sample with a weight of 1), or add a
+    // sample of the given weight to it.
+    //
+    // Out of range x,y are clipped (i.e., the frame buffer is unchanged).
+    inline void SetPixel( int x, int y, const nrColor& color );
+    inline void AddPixel( int x, int y, const nrColor& color, float weight );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Get the color of a pixel (black, if it has no samples).
+    //
+    // Out of range x,y are clipped (i.e., color is unchanged).
+    inline void GetPixel( int x, int y, nrColor& color ) const;
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Resolve row y to 3 components of bits (8 or 16, most significant
+    // byte first) each, in dst (Width() * 3 * bits / 8 bytes).
+    void Resolve( int y, float exposure, float gamma, bool dither, int bits, unsigned char* dst ) const;
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Returns the frame buffer width.
+    inline int Width( void ) const;
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Returns the frame buffer height.
+    inline int Height( void ) const;
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Returns the four floats of the pixel ( x, y ); the pixels of a row
+    // follow each other.
+    inline float* Pixel( int x, int y );
+    inline const float* Pixel( int x, int y ) const;
+
+private:
+
+    // Not copyable.
+    nrFrameBuffer( const nrFrameBuffer& );
+    nrFrameBuffer& operator=( const nrFrameBuffer& );
+
+public:
+
+    int m_Width;
+    int m_Height;
+
+    float* m_Pixels;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrFrameBuffer.inl"
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRFRAMEBUFFER_H
@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrFrameBuffer.inl
+//
+// A class for floating point (high dynamic range) frame buffers.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrFrameBuffer.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+inline void nrFrameBuffer::SetPixel( int x, int y, const nrColor& color )
+{
+    if ( x < 0 || x >= m_Width || y < 0 || y >= m_Height )
+    {
+        return;
+    }
+
+    float* p = Pixel( x, y );
+
+    p[ 0 ] = color.r;
+    p[ 1 ] = color.g;
+    p[ 2 ] = color.b;
+    p[ 3 ] = 1.0f;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline void nrFrameBuffer::AddPixel( int x, int y, const nrColor& color, float weight )
+{
+    if ( x < 0 || x >= m_Width || y < 0 || y >= m_Height )
+    {
+        return;
+    }
+
+    float* p = Pixel( x, y );
+
+    p[ 0 ] += color.r * weight;
+    p[ 1 ] += color.g * weight;
+    p[ 2 ] += color.b * weight;
+    p[ 3 ] += weight;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline void nrFrameBuffer::GetPixel( int x, int y, nrColor& color ) const
+{
+    if ( x < 0 || x >= m_Width || y < 0 || y >= m_Height )
+    {
+        return;
+    }
+
+    const float* p = Pixel( x, y );
+
+    if ( p[ 3 ] > 0.0f )
+    {
+        color = nrColor( p[ 0 ] / p[ 3 ], p[ 1 ] / p[ 3 ], p[ 2 ] / p[ 3 ] );
+    }
+    else
+    {
+        color = nrColor( 0.0f, 0.0f, 0.0f );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline int nrFrameBuffer::Width( void ) const
+{
+    return m_Width;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline int nrFrameBuffer::Height( void ) const
+{
+    return m_Height;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float* nrFrameBuffer::Pixel( int x, int y )
+{
+    return m_Pixels + ( y * m_Width + x ) * 4;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline const float* nrFrameBuffer::Pixel( int x, int y ) const
+{
+    return m_Pixels + ( y * m_Width + x ) * 4;
+}
+
+////////////////////////////////////////////////////////////////////////////
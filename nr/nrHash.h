@@ -4,6 +4,10 @@
 //
 // A hash table class.
 //
+// Items are looked up by (string) key.  The keys are copied into the hash
+// table.  Collisions are chained, and the table grows to keep the chains
+// short, so adding and finding are constant time on average.
+//
 // Nate Robins, March 2002.
 //
 ////////////////////////////////////////////////////////////////////////////
@@ -12,6 +16,13 @@
 #define NRHASH_H
 
 
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrArray.h"
+
+
 ////////////////////////////////////////////////////////////////////////////
 // Classes
 ////////////////////////////////////////////////////////////////////////////
@@ -25,32 +36,47 @@ public:
     
     // Operations //////////////////////////////////////////////////////////
     
-    // Set the size of the hash table (must be called before anything is 
-    // added to the hash table).
+    // Set the (initial) number of buckets in the hash table.  The table 
+    // grows as necessary, so this is only a hint.
     inline void Size( int size );
     
-    // Add an item to the hash table.
+    // Add an item to the hash table.  The key must not already be in the
+    // hash table.
     inline void Add( const char* key, T item );
     
-    // Remove an item from the list (collapses the array, but does not
-    // compress the array).
-    //inline void Remove( int index );
+    // Find an item in the hash table.
+    //
+    // If the key couldn't be found, 0 is returned.
+    inline T* Find( const char* key ) const;
     
-    // Return a reference to an item in the hash table.
+    // Return a reference to an item in the hash table (the key must be in
+    // the hash table).
     inline T& operator[]( const char* key ) const;
     
+    // Return the number of items in the hash table.
+    inline int Length( void ) const;
+    
     // Clear the hash table (remove all items).
     inline void Clear( void );
     
+    // Return a hash value given a key (FNV-1a).
+    inline static unsigned int Hash( const char* key );
+    
 private:
     
-    // Return a hash value given a key.
-    inline int Hash( const char* key );
+    // Rebuild the buckets with the given number of buckets (must be a 
+    // power of two).
+    inline void Rehash( int size );
     
 private:
     
-    int           m_Size;
-    nrArray< T >* m_Hash;
+    int                     m_Size;      // Number of buckets.
+    int*                    m_Buckets;   // First item in each bucket.
+    
+    nrArray< char* >        m_Keys;
+    nrArray< unsigned int > m_Hashes;
+    nrArray< int >          m_Next;      // Next item in the same bucket.
+    nrArray< T >            m_Items;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -2,34 +2,12 @@
 //
 // nrHash.inl
 //
-// A linked Hash class.
+// A hash table class.
 //
 // Nate Robins, March 2002.
 //
 ////////////////////////////////////////////////////////////////////////////
 
-
-
-
-
-
-
-<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
-
-Bah, this is broken.
-
-
-<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
-
-
-
-
-
-
-
-
-
-
 ////////////////////////////////////////////////////////////////////////////
 // Includes
 ////////////////////////////////////////////////////////////////////////////
@@ -37,7 +15,6 @@ Bah, this is broken.
 #include "nrHash.h"
 
 #include <assert.h>
-#include <crtdbg.h>
 #include <string.h>
 
 
@@ -47,80 +24,157 @@ Bah, this is broken.
 
 template <class T> inline nrHash<T>::nrHash( void )
 {
-    m_Hash = 0;
-    Clear();
+    m_Size = 0;
+    m_Buckets = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
 template <class T> inline nrHash<T>::~nrHash( void )
 {
-    delete [] m_Hash;
+    Clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
-template <class T> inline void nrHash<T>::Add( const char* key, T item )
+template <class T> inline void nrHash<T>::Size( int size )
 {
-    assert( m_Hash );
+    int s = 16;
+    while ( s < size )
+    {
+        s *= 2;
+    }
     
-    int h = Hash( key );
-    while ( m_Hash[ h ] != 0 )
+    if ( s > m_Size )
     {
-        #if defined ( _DEBUG )
-        _RPT2( _CRT_WARN, "nrHash<0x%08X>::Add() : Collision (size %d)!\n", this, m_Size );
-        #endif
-        
-        h += 7;
+        Rehash( s );
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
-template <class T> inline T& nrHash<T>::operator[]( const char* key ) const
+template <class T> inline void nrHash<T>::Add( const char* key, T item )
 {
-    int h = Hash( key );
+    assert( key );
+    assert( Find( key ) == 0 );
+    
+    // Keep the chains short.
+    if ( m_Items.Length() >= m_Size )
+    {
+        Rehash( m_Size ? m_Size * 2 : 16 );
+    }
+    
+    char* k = new char[ strlen( key ) + 1 ];
+    strcpy( k, key );
+    
+    unsigned int h = Hash( key );
+    int b = ( int )( h & ( m_Size - 1 ) );
+    
+    m_Keys.Add( k );
+    m_Hashes.Add( h );
+    m_Next.Add( m_Buckets[ b ] );
+    m_Items.Add( item );
+    
+    m_Buckets[ b ] = m_Items.Length() - 1;
+}
 
-    assert( m_Hash[ h ].Length() > 0 ); // Key not found in the hash table!
+////////////////////////////////////////////////////////////////////////////
 
-    if ( m_Hash[ h ].Length() > 1 )
+template <class T> inline T* nrHash<T>::Find( const char* key ) const
+{
+    if ( key == 0 || m_Size == 0 )
     {
-        // Search.
-        for ( int i = 0; i < m_Hash[ h ].Length; i++ )
-        {
-
-        }
+        return 0;
     }
-    else
+    
+    unsigned int h = Hash( key );
+    
+    for ( int i = m_Buckets[ h & ( m_Size - 1 ) ]; i >= 0; i = m_Next[ i ] )
     {
-        return m_Hash[ h ][ 0 ];
+        if ( m_Hashes[ i ] == h && strcmp( m_Keys[ i ], key ) == 0 )
+        {
+            return &m_Items[ i ];
+        }
     }
+    
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <class T> inline T& nrHash<T>::operator[]( const char* key ) const
+{
+    T* item = Find( key );
+    assert( item ); // Key not found in the hash table!
+    
+    return *item;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <class T> inline int nrHash<T>::Length( void ) const
+{
+    return m_Items.Length();
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
 template <class T> inline void nrHash<T>::Clear( void )
 {
-    delete [] m_Hash;
+    for ( int i = 0; i < m_Keys.Length(); i++ )
+    {
+        delete [] m_Keys[ i ];
+    }
+    
+    m_Keys.Clear();
+    m_Hashes.Clear();
+    m_Next.Clear();
+    m_Items.Clear();
+    
+    delete [] m_Buckets;
+    m_Buckets = 0;
     m_Size = 0;
 }
 
+////////////////////////////////////////////////////////////////////////////
+
+template <class T> inline unsigned int nrHash<T>::Hash( const char* key )
+{
+    unsigned int h = 2166136261u;
+    
+    for ( const char* c = key; *c; c++ )
+    {
+        h ^= ( unsigned char )*c;
+        h *= 16777619u;
+    }
+    
+    return h;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Private
 ////////////////////////////////////////////////////////////////////////////
 
-template <class T> inline int nrHash<T>::Hash( const char* key )
+template <class T> inline void nrHash<T>::Rehash( int size )
 {
-    unsigned int h = 0;
+    assert( ( size & ( size - 1 ) ) == 0 );
     
-    for ( int i = 0; i < strlen( key ); i++ )
+    delete [] m_Buckets;
+    m_Buckets = new int[ size ];
+    m_Size = size;
+    
+    for ( int b = 0; b < m_Size; b++ )
     {
-        h += key[ i ] * 128 * i;
+        m_Buckets[ b ] = -1;
     }
     
-    h = h % m_Size;
-    
-    return h;
+    for ( int i = 0; i < m_Items.Length(); i++ )
+    {
+        int bucket = ( int )( m_Hashes[ i ] & ( m_Size - 1 ) );
+        
+        m_Next[ i ] = m_Buckets[ bucket ];
+        m_Buckets[ bucket ] = i;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////
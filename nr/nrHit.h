@@ -23,6 +23,7 @@
 // Classes
 ////////////////////////////////////////////////////////////////////////////
 
+class nrMaterial;
 class nrSurface;
 
 ////////////////////////////////////////////////////////////////////////////
@@ -33,6 +34,7 @@ public:
     
     inline nrHit( void );
     inline nrHit( const nrSurface* surface, float t );
+    inline nrHit( const nrSurface* surface, float t, const nrVector3& normal, const nrMaterial* material );
     inline ~nrHit( void );
     
 public:
@@ -41,8 +43,16 @@ public:
     
 public:
     
-    float            t;
-    const nrSurface* m_Surface;
+    // Everything shading needs is filled in by the surface that was hit,
+    // so shading doesn't have to go back to the surface for it.
+    float             t;
+    float             u;            // Barycentric coordinates (triangles).
+    float             v;
+    nrVector3         m_Normal;     // Geometric normal (unit length).
+    nrVector3         m_Shading;    // Shading normal (unit length).
+    int               m_ID;         // Primitive ID (see nrPrimitives), or -1.
+    const nrMaterial* m_Material;
+    const nrSurface*  m_Surface;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -33,6 +33,26 @@ inline nrHit::nrHit( const nrSurface* surface, float _t )
     assert( surface != 0 );
 
     t = _t;
+    u = 0.0f;
+    v = 0.0f;
+    m_ID = -1;
+    m_Material = 0;
+    m_Surface = surface;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline nrHit::nrHit( const nrSurface* surface, float _t, const nrVector3& normal, const nrMaterial* material )
+{
+    assert( surface != 0 );
+
+    t = _t;
+    u = 0.0f;
+    v = 0.0f;
+    m_Normal = normal;
+    m_Shading = normal;
+    m_ID = -1;
+    m_Material = material;
     m_Surface = surface;
 }
 
@@ -46,10 +46,17 @@ nrImage::~nrImage( void )
 bool nrImage::CreateFromFile( const char* file_name )
 {
     delete [] m_Image;
+    m_Image = NULL;
     
-    char* extension = strrchr( file_name, '.' );
+    const char* extension = strrchr( file_name, '.' );
     
-    if ( stricmp( extension, ".ppm" ) == 0 )
+    if ( extension == NULL )
+    {
+        g_Log.Write( "nrImage::CreateFromFile() : %s: Unrecognized image format.\n", file_name );
+        assert( 0 );
+        return false;
+    }
+    else if ( stricmp( extension, ".ppm" ) == 0 )
     {
         return ReadPPM( file_name );
     }
@@ -580,31 +587,47 @@ void nrImage::CopySub( const nrImage& src, int src_x, int src_y, int src_w, int
 {
     assert( m_Depth == src.Depth() );
     
-    int y = dst_y;
-    for ( int j = src_y; j < src_h; j++ )
+    // Clip the portion to the source, then to this image.
+    if ( src_x < 0 )
     {
-        if ( y >= m_Height )
-        {
-            continue;
-        }
-        
-        int x = dst_x;
-        for ( int i = src_x; i < src_w; i++ )
-        {
-            if ( x >= m_Width )
-            {
-                continue;
-            }
-            
-            int pixel = ( y * m_Width + x ) * m_Depth;
-            int src_pixel = ( j * src.m_Width + i ) * src.m_Depth;
-            
-            memcpy( &( m_Image[ pixel ] ), &( src.m_Image[ src_pixel ] ), m_Depth );
-            
-            x++;
-        }
+        src_w += src_x;
+        dst_x -= src_x;
+        src_x = 0;
+    }
+    if ( src_y < 0 )
+    {
+        src_h += src_y;
+        dst_y -= src_y;
+        src_y = 0;
+    }
+    if ( dst_x < 0 )
+    {
+        src_w += dst_x;
+        src_x -= dst_x;
+        dst_x = 0;
+    }
+    if ( dst_y < 0 )
+    {
+        src_h += dst_y;
+        src_y -= dst_y;
+        dst_y = 0;
+    }
+    
+    int w = nrMath::Min3( src_w, src.m_Width - src_x, m_Width - dst_x );
+    int h = nrMath::Min3( src_h, src.m_Height - src_y, m_Height - dst_y );
+    
+    if ( w <= 0 || h <= 0 )
+    {
+        return;
+    }
+    
+    // A row at a time.
+    for ( int j = 0; j < h; j++ )
+    {
+        int pixel = ( ( dst_y + j ) * m_Width + dst_x ) * m_Depth;
+        int src_pixel = ( ( src_y + j ) * src.m_Width + src_x ) * src.m_Depth;
         
-        y++;
+        memcpy( &( m_Image[ pixel ] ), &( src.m_Image[ src_pixel ] ), w * m_Depth );
     }
 }
 
@@ -185,10 +185,11 @@ public:
     
     ////////////////////////////////////////////////////////////////////////
     
-    // Copy a portion of another image to this image.
+    // Copy the portion src_w x src_h at ( src_x, src_y ) of another image
+    // to ( dst_x, dst_y ) in this image.
     //
-    // Both images must be the same depth.  The source image is clipped by 
-    // the destination image.
+    // Both images must be the same depth.  The portion is clipped by both
+    // images.
     void CopySub( const nrImage& src, int src_x, int src_y, int src_w, int src_h, int dst_x = 0, int dst_y = 0 );
         
     ////////////////////////////////////////////////////////////////////////
@@ -234,7 +235,8 @@ private:
     
     // Read a TGA file (Truvision Targa).
     //
-    // Only type 2 (uncompressed 16/24/32 bit) files are supported.
+    // Only types 2 and 10 ((run length encoded) 16/24/32 bit) files are
+    // supported.
     //
     // If an error occurs, an error message is logged and false is returned.
     bool ReadTGA( const char* filename );
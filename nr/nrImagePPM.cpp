@@ -76,6 +76,14 @@ bool nrImage::ReadPPM( const char* file_name )
         }
     }
     
+    // Components of 2 bytes (a maxval over 255) can't be read as bytes.
+    if ( d > 255 )
+    {
+        g_Log.Write( "nrImage::ReadPPM() : %s: Only 8 bit PPM files are supported.\n", file_name );
+        fclose( file );
+        return false;
+    }
+    
     // grab all the image data in one fell swoop.
     unsigned char* image = new unsigned char[ w * h * 3 ];
     
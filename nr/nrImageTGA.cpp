@@ -4,7 +4,8 @@
 //
 // A class for TGA (Truvision Targa) images.
 //
-// Only type 2 (uncompressed 16/24/32 bit) files are supported.
+// Only types 2 and 10 ((run length encoded) 16/24/32 bit) files are
+// supported (type 10 for reading only, see nrImageWriter).
 //
 // See:  http://www.cica.indiana.edu/graphics/image_specs/tga.format.txt
 //
@@ -18,43 +19,14 @@
 ////////////////////////////////////////////////////////////////////////////
 
 #include "nrImage.h"
+#include "nrImageTGA.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "nrLog.h"
 
 
-////////////////////////////////////////////////////////////////////////////
-// Classes
-////////////////////////////////////////////////////////////////////////////
-
-#pragma pack( 1 )
-
-class nrImageTGA
-{
-public:
-
-    unsigned char id_field_size;
-    unsigned char colormap_type;
-    unsigned char image_type_code;
-    struct {
-        unsigned short colormap_origin;
-        unsigned short colormap_length;
-        unsigned char  colormap_entry_size;
-    } colormap_specification;
-    struct {
-        unsigned short x_origin;
-        unsigned short y_origin;
-        unsigned short width;
-        unsigned short height;
-        unsigned char  num_bits_per_pixel;
-        unsigned char  descriptor_byte;
-    } image_specification;
-};
-
-#pragma pack()
-
-
 ////////////////////////////////////////////////////////////////////////////
 // Private
 ////////////////////////////////////////////////////////////////////////////
@@ -78,10 +50,10 @@ bool nrImage::ReadTGA( const char* file_name )
         return false;
     }
     
-    // check the image type (only supports type 2 for now).
-    if ( tga.image_type_code != 2 )
+    // check the image type (only supports types 2 and 10 for now).
+    if ( tga.image_type_code != 2 && tga.image_type_code != 10 )
     {
-        g_Log.Write( "nrImage::ReadTGA() : %s: Not a type 2 (uncompressed 16/24/32 bit) TGA file.\n", file_name );
+        g_Log.Write( "nrImage::ReadTGA() : %s: Not a type 2 or 10 ((run length encoded) 16/24/32 bit) TGA file.\n", file_name );
         assert( 0 );
         return false;
     }
@@ -119,7 +91,43 @@ bool nrImage::ReadTGA( const char* file_name )
         return false;
     }
     
-    if ( fread( image, w * h * d, 1, file ) != 1 )
+    if ( tga.image_type_code == 10 )
+    {
+        // run length encoded: each packet is a pixel repeated (high bit
+        // set) or a number of raw pixels.
+        int n = 0;
+        while ( n < w * h )
+        {
+            int packet = fgetc( file );
+            if ( packet == EOF )
+            {
+                g_Log.Write( "nrImage::ReadTGA() : %s: File may be truncated.\n", file_name );
+                break;
+            }
+            
+            int count = ( packet & 0x7F ) + 1;
+            if ( count > w * h - n )
+            {
+                count = w * h - n;
+            }
+            
+            if ( packet & 0x80 )
+            {
+                fread( &( image[ n * d ] ), d, 1, file );
+                for ( int k = 1; k < count; k++ )
+                {
+                    memcpy( &( image[ ( n + k ) * d ] ), &( image[ n * d ] ), d );
+                }
+            }
+            else
+            {
+                fread( &( image[ n * d ] ), count * d, 1, file );
+            }
+            
+            n += count;
+        }
+    }
+    else if ( fread( image, w * h * d, 1, file ) != 1 )
     {
         g_Log.Write( "nrImage::ReadTGA() : %s: File may be truncated.\n", file_name );
         // not a fatal error, no need to return.
@@ -223,6 +231,12 @@ bool nrImage::ReadTGA( const char* file_name )
     m_Depth  = d;
     m_Image  = image;
     
+    // images are bottom up, so flip those stored top down.
+    if ( tga.image_specification.descriptor_byte & NR_TGA_TOP_LEFT )
+    {
+        FlipVertical();
+    }
+    
     return true;
 }
 
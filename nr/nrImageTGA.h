@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrImageTGA.h
+//
+// The header of a TGA (Truvision Targa) image.
+//
+// See:  http://www.cica.indiana.edu/graphics/image_specs/tga.format.txt
+//
+// Nate Robins, December 2001.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRIMAGETGA_H
+#define NRIMAGETGA_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// The bit of the descriptor byte which is set if the first row in the
+// file is the top of the image (rather than the bottom).
+#define NR_TGA_TOP_LEFT 0x20
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+#pragma pack( 1 )
+
+class nrImageTGA
+{
+public:
+
+    unsigned char id_field_size;
+    unsigned char colormap_type;
+    unsigned char image_type_code;
+    struct {
+        unsigned short colormap_origin;
+        unsigned short colormap_length;
+        unsigned char  colormap_entry_size;
+    } colormap_specification;
+    struct {
+        unsigned short x_origin;
+        unsigned short y_origin;
+        unsigned short width;
+        unsigned short height;
+        unsigned char  num_bits_per_pixel;
+        unsigned char  descriptor_byte;
+    } image_specification;
+};
+
+#pragma pack()
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRIMAGETGA_H
@@ -0,0 +1,396 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrImageWriter.cpp
+//
+// A class for writing an image to a file a band of rows at a time.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrImageWriter.h"
+
+#include "nrImageTGA.h"
+#include "nrLog.h"
+#include "nrMath.h"
+#include "nrThread.h"
+
+#include <assert.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrImageWriter::nrImageWriter( void ) : m_Free( NR_IMAGEWRITER_QUEUE ), m_Full( 0 )
+{
+    m_File = 0;
+    m_FileName[ 0 ] = '\0';
+    m_TGA = false;
+    m_Compress = false;
+    m_Bits = 8;
+    m_Exposure = 0.0f;
+    m_Gamma = 1.0f;
+    m_Dither = false;
+    m_Width = 0;
+    m_Height = 0;
+    m_Rows = 0;
+    m_Size = 0;
+    m_Buffer = 0;
+    m_Y = 0;
+    m_NumRows = 0;
+    m_Next = 0;
+    m_Encoded = 0;
+    m_Sizes = 0;
+    m_RowSize = 0;
+    m_Head = 0;
+    m_Tail = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrImageWriter::~nrImageWriter( void )
+{
+    if ( m_File )
+    {
+        fclose( m_File );
+    }
+    
+    delete [] m_Encoded;
+    delete [] m_Sizes;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrImageWriter::Open( const char* file_name, int width, int height, bool compress, int bits )
+{
+    assert( m_File == 0 );
+    
+    const char* extension = strrchr( file_name, '.' );
+    
+    if ( extension && stricmp( extension, ".ppm" ) == 0 )
+    {
+        m_TGA = false;
+    }
+    else if ( extension && stricmp( extension, ".tga" ) == 0 )
+    {
+        m_TGA = true;
+    }
+    else
+    {
+        g_Log.Write( "nrImageWriter::Open() : %s: Unsupported output format.\n", file_name );
+        return false;
+    }
+    
+    if ( compress && ! m_TGA )
+    {
+        g_Log.Write( "nrImageWriter::Open() : %s: Only TGA files can be compressed.\n", file_name );
+        compress = false;
+    }
+    
+    if ( bits != 8 && ( bits != 16 || m_TGA ) )
+    {
+        g_Log.Write( "nrImageWriter::Open() : %s: %d bits per component not supported, using 8.\n", file_name, bits );
+        bits = 8;
+    }
+    
+    m_File = fopen( file_name, "wb" );
+    if ( m_File == NULL )
+    {
+        g_Log.Write( "nrImageWriter::Open() : %s: Failed to open file.\n", file_name );
+        return false;
+    }
+    
+    strncpy( m_FileName, file_name, sizeof ( m_FileName ) - 1 );
+    m_FileName[ sizeof ( m_FileName ) - 1 ] = '\0';
+    m_Compress = compress;
+    m_Bits = bits;
+    m_Width = width;
+    m_Height = height;
+    m_Rows = 0;
+    
+    // PPM rows are resolved in place.  TGA rows are resolved after the
+    // space for the encoded row (every packet of a run length encoded row
+    // has at least one pixel, so a row is never more than a byte per pixel
+    // bigger), and encoded from there.
+    m_RowSize = m_TGA ? width * 4 + width * 3 : width * 3 * ( bits / 8 );
+    
+    delete [] m_Encoded;
+    delete [] m_Sizes;
+    m_Encoded = new unsigned char[ NR_IMAGEWRITER_ROWS * m_RowSize ];
+    m_Sizes = new int[ NR_IMAGEWRITER_ROWS ];
+    
+    if ( m_TGA )
+    {
+        // cobble up a tga header (see nrImage::WriteTGA()), top down.
+        nrImageTGA tga;
+        
+        tga.id_field_size = 0;
+        tga.colormap_type = 0;
+        tga.image_type_code = compress ? 10 : 2;
+        tga.colormap_specification.colormap_origin = 0;
+        tga.colormap_specification.colormap_length = 0;
+        tga.colormap_specification.colormap_entry_size = 0;
+        tga.image_specification.x_origin = 0;
+        tga.image_specification.y_origin = 0;
+        tga.image_specification.width = width;
+        tga.image_specification.height = height;
+        tga.image_specification.num_bits_per_pixel = 24;
+        tga.image_specification.descriptor_byte = NR_TGA_TOP_LEFT;
+        
+        if ( fwrite( &tga, sizeof ( nrImageTGA ), 1, m_File ) != 1 )
+        {
+            g_Log.Write( "nrImageWriter::Open() : %s: Failed to write header.\n", file_name );
+            return false;
+        }
+        
+        m_Size = sizeof ( nrImageTGA );
+    }
+    else
+    {
+        // spit out binary PPM header (see nrImage::WritePPM()).
+        m_Size = fprintf( m_File, "P6\n# Created by nrImage tools.\n%d %d\n%d\n", width, height, ( 1 << bits ) - 1 );
+    }
+    
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrImageWriter::SetResolve( float exposure, float gamma, bool dither )
+{
+    m_Exposure = exposure;
+    m_Gamma = gamma;
+    m_Dither = dither;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrImageWriter::Write( const nrFrameBuffer& buffer, int y, int num_rows )
+{
+    assert( m_File );
+    assert( buffer.Width() == m_Width );
+    assert( y >= 0 && y + num_rows <= buffer.Height() );
+    assert( m_Rows + num_rows <= m_Height );
+    
+    // Resolve and encode (and write) a few rows at a time, from the top
+    // down.
+    for ( int j = y + num_rows; j > y; j -= m_NumRows )
+    {
+        m_Buffer = &buffer;
+        m_NumRows = nrMath::Min( j - y, NR_IMAGEWRITER_ROWS );
+        m_Y = j - m_NumRows;
+        m_Next = 0;
+        
+        // A row or two isn't worth starting threads for.
+        nrThread::Run( EncodeRows, this, m_NumRows > 2 ? 0 : 1 );
+        
+        for ( int r = 0; r < m_NumRows; r++ )
+        {
+            if ( fwrite( m_Encoded + r * m_RowSize, m_Sizes[ r ], 1, m_File ) != 1 )
+            {
+                g_Log.Write( "nrImageWriter::Write() : %s: Failed to write image.\n", m_FileName );
+                return false;
+            }
+            
+            m_Size += m_Sizes[ r ];
+            m_Rows++;
+        }
+    }
+    
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrImageWriter::Post( const nrFrameBuffer& buffer, int y, int num_rows )
+{
+    assert( num_rows > 0 );
+    
+    m_Free.Wait();
+    
+    int slot = m_Tail % NR_IMAGEWRITER_QUEUE;
+    
+    nrFrameBuffer& band = m_Queue[ slot ];
+    if ( band.Width() != buffer.Width() || band.Height() < num_rows )
+    {
+        band.Create( buffer.Width(), num_rows );
+    }
+    
+    memcpy( band.Pixel( 0, 0 ), buffer.Pixel( 0, y ), num_rows * buffer.Width() * 4 * sizeof ( float ) );
+    m_QueueRows[ slot ] = num_rows;
+    
+    m_Tail++;
+    m_Full.Signal();
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrImageWriter::Finish( void )
+{
+    m_Free.Wait();
+    
+    m_QueueRows[ m_Tail % NR_IMAGEWRITER_QUEUE ] = 0;
+    
+    m_Tail++;
+    m_Full.Signal();
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrImageWriter::Serve( void )
+{
+    for ( ;; )
+    {
+        m_Full.Wait();
+        
+        int slot = m_Head % NR_IMAGEWRITER_QUEUE;
+        int num_rows = m_QueueRows[ slot ];
+        
+        // Errors are logged, and found by Close() (as missing rows).
+        if ( num_rows > 0 )
+        {
+            Write( m_Queue[ slot ], 0, num_rows );
+        }
+        
+        m_Head++;
+        m_Free.Signal();
+        
+        if ( num_rows == 0 )
+        {
+            break;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrImageWriter::Close( void )
+{
+    assert( m_File );
+    
+    bool complete = ( m_Rows == m_Height );
+    if ( ! complete )
+    {
+        g_Log.Write( "nrImageWriter::Close() : %s: Only %d of %d rows written.\n", m_FileName, m_Rows, m_Height );
+    }
+    
+    fclose( m_File );
+    m_File = 0;
+    
+    return complete;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+double nrImageWriter::Size( void ) const
+{
+    return m_Size;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+void nrImageWriter::EncodeRows( void* data, int thread, int num_threads )
+{
+    nrImageWriter* writer = ( nrImageWriter* )data;
+    
+    int w = writer->m_Width;
+    int r;
+    
+    // The r-th row of the file is the r-th from the top of the band.
+    while ( ( r = nrThread::Next( writer->m_Next ) ) < writer->m_NumRows )
+    {
+        int j = writer->m_Y + writer->m_NumRows - 1 - r;
+        unsigned char* dst = writer->m_Encoded + r * writer->m_RowSize;
+        
+        if ( writer->m_TGA )
+        {
+            unsigned char* src = dst + w * 4;
+            
+            writer->m_Buffer->Resolve( j, writer->m_Exposure, writer->m_Gamma, writer->m_Dither, 8, src );
+            writer->m_Sizes[ r ] = writer->EncodeRow( src, dst );
+        }
+        else
+        {
+            writer->m_Buffer->Resolve( j, writer->m_Exposure, writer->m_Gamma, writer->m_Dither, writer->m_Bits, dst );
+            writer->m_Sizes[ r ] = writer->m_RowSize;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrImageWriter::EncodeRow( const unsigned char* src, unsigned char* dst ) const
+{
+    int w = m_Width;
+    int i;
+    
+    // internal image format is rgb - targa needs bgr.
+    if ( ! m_Compress )
+    {
+        for ( i = 0; i < w; i++ )
+        {
+            dst[ i * 3 + 0 ] = src[ i * 3 + 2 ];
+            dst[ i * 3 + 1 ] = src[ i * 3 + 1 ];
+            dst[ i * 3 + 2 ] = src[ i * 3 + 0 ];
+        }
+        
+        return w * 3;
+    }
+    
+    // Run length encode the row in packets of up to 128 pixels: a run
+    // packet (high bit set) of a pixel repeated, or a raw packet of
+    // pixels up to the next run.  Packets don't cross rows, so rows (and
+    // bands) are encoded independently.
+    int n = 0;
+    
+    i = 0;
+    while ( i < w )
+    {
+        const unsigned char* p = src + i * 3;
+        
+        int run = 1;
+        while ( i + run < w && run < 128 && memcmp( p, p + run * 3, 3 ) == 0 )
+        {
+            run++;
+        }
+        
+        int count = run;
+        
+        if ( run > 1 )
+        {
+            dst[ n++ ] = ( unsigned char )( 0x80 | ( run - 1 ) );
+            count = 1;
+        }
+        else
+        {
+            while ( i + count < w && count < 128 &&
+                    ! ( i + count + 1 < w && memcmp( p + count * 3, p + count * 3 + 3, 3 ) == 0 ) )
+            {
+                count++;
+            }
+            
+            dst[ n++ ] = ( unsigned char )( count - 1 );
+        }
+        
+        for ( int k = 0; k < count; k++ )
+        {
+            dst[ n++ ] = p[ k * 3 + 2 ];
+            dst[ n++ ] = p[ k * 3 + 1 ];
+            dst[ n++ ] = p[ k * 3 + 0 ];
+        }
+        
+        i += run > 1 ? run : count;
+    }
+    
+    return n;
+}
+
+////////////////////////////////////////////////////////////////////////////
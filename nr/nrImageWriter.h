@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrImageWriter.h
+//
+// A class for writing an image to a file a band of rows at a time.
+//
+// The image is written from a (floating point) frame buffer, each row
+// resolved (see nrFrameBuffer::Resolve()) as it is written, with the
+// exposure, gamma and dither given by SetResolve().  PPM files may have
+// 16 bits per component.
+//
+// The whole image never has to be in memory: each band is appended to the
+// file as soon as it is written, so an image of any size can be written
+// from a few rows at a time.  Bands are written from the top of the image
+// down.  As in nrImage (and TGA), rows are numbered from the bottom up,
+// so the rows of each band are written from the last to the first; the
+// files are stored top down (TGA files with NR_TGA_TOP_LEFT set), so no
+// flip is needed.
+//
+// TGA files may be run length encoded.  The rows of a band are resolved
+// and encoded on several threads at once (see nrThread), and written in
+// order.
+//
+// The bands may also be written on another thread, so that rendering
+// doesn't wait for the disk: the renderer Post()s each band (which only
+// copies it into a queue) while the other thread Serve()s the queue,
+// encoding and writing the bands in the order they were posted.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRIMAGEWRITER_H
+#define NRIMAGEWRITER_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrFrameBuffer.h"
+#include "nrSemaphore.h"
+
+#include <stdio.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// Number of bands which may be posted but not yet written.
+#define NR_IMAGEWRITER_QUEUE 4
+
+// Number of rows encoded at a time (see Write()).
+#define NR_IMAGEWRITER_ROWS 64
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrImageWriter
+{
+public:
+    
+    nrImageWriter( void );
+    ~nrImageWriter( void );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
+    // Create the file, and write the header for a 3 component image of
+    // the specified dimensions, with bits (8 or 16) per component.
+    //
+    // The type of file to write is determined by the extension of the
+    // filename (PPM or TGA, as nrImage::WriteToFile()).  If compress is
+    // true, TGA files are run length encoded (PPM files can't be).  Only
+    // PPM files may have 16 bits per component.
+    //
+    // If successful, returns true, otherwise returns false and writes an
+    // error message to the global log.
+    bool Open( const char* file_name, int width, int height, bool compress = false, int bits = 8 );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
+    // Set how the rows are resolved (see nrFrameBuffer::Resolve()).  The
+    // defaults (0, 1 and false) truncate each color to bits.
+    void SetResolve( float exposure, float gamma, bool dither );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
+    // Write the rows [ y, y + num_rows ) of a frame buffer (of the same
+    // width) as the next num_rows rows of the file, from the top (y +
+    // num_rows - 1) down.
+    //
+    // If successful, returns true, otherwise returns false and writes an
+    // error message to the global log.
+    bool Write( const nrFrameBuffer& buffer, int y, int num_rows );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
+    // Copy the rows [ y, y + num_rows ) of a frame buffer to the queue, to
+    // be written (as Write()) by Serve() on another thread.  Waits if the
+    // queue is full.
+    void Post( const nrFrameBuffer& buffer, int y, int num_rows );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
+    // Tell Serve() that no more bands will be posted.
+    void Finish( void );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
+    // Write the posted bands, as they are posted, until Finish() is
+    // called.
+    void Serve( void );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
+    // Close the file.
+    //
+    // If all of the rows were written, returns true, otherwise returns
+    // false and writes an error message to the global log.
+    bool Close( void );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
+    // Returns the number of bytes written to the file so far.
+    double Size( void ) const;
+    
+private:
+    
+    // Resolve and encode the rows of the band being written, on each
+    // thread (see nrThread::Run()).
+    static void EncodeRows( void* data, int thread, int num_threads );
+    
+    // Encode a resolved row of width pixels (rgb, 8 bits) for a TGA file,
+    // and return the number of bytes encoded.
+    int EncodeRow( const unsigned char* src, unsigned char* dst ) const;
+    
+private:
+    
+    FILE* m_File;
+    char m_FileName[ 256 ];
+    bool m_TGA;                 // Otherwise PPM.
+    bool m_Compress;            // Run length encoded (TGA).
+    int m_Bits;                 // Per component.
+    float m_Exposure;
+    float m_Gamma;
+    bool m_Dither;
+    int m_Width;
+    int m_Height;
+    int m_Rows;                 // Number of rows written so far.
+    double m_Size;              // Number of bytes written so far.
+    
+    // The rows being encoded, [ m_Y, m_Y + m_NumRows ) of m_Buffer: the
+    // r-th from the top is encoded at m_Encoded + r * m_RowSize, in
+    // m_Sizes[ r ] bytes.
+    const nrFrameBuffer* m_Buffer;
+    int m_Y;
+    int m_NumRows;
+    volatile int m_Next;        // Next row to encode (see EncodeRows()).
+    unsigned char* m_Encoded;
+    int* m_Sizes;
+    int m_RowSize;
+    
+    // The posted bands, in a ring: Post() adds at m_Tail, and Serve()
+    // removes at m_Head.  A band of 0 rows marks the end.
+    nrFrameBuffer m_Queue[ NR_IMAGEWRITER_QUEUE ];
+    int m_QueueRows[ NR_IMAGEWRITER_QUEUE ];
+    int m_Head;
+    int m_Tail;
+    nrSemaphore m_Free;         // Number of free places in the queue.
+    nrSemaphore m_Full;         // Number of bands in the queue.
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRIMAGEWRITER_H
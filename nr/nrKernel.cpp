@@ -0,0 +1,453 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrKernel.cpp
+//
+// A class for convolutions.
+//
+// Nate Robins, March 2001.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrKernel.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "nrFrameBuffer.h"
+#include "nrImage.h"
+#include "nrMath.h"
+#include "nrSimd.h"
+#include "nrThread.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+// A pass of a convolution (see nrKernel::ConvolveRows()): the weights
+// across x (a horizontal pass, over each row of src) or down y (a
+// vertical pass, over each column), from src into dst, both width x
+// height pixels of 4 floats.
+struct nrKernelPass
+{
+    const float* src;
+    float*       dst;
+    int          width;
+    int          height;
+    const float* weights;
+    int          size;
+    bool         horizontal;
+    int          mode;
+    
+    // The pixel beyond the edges (horizontal), or the row (vertical), in
+    // Border mode.
+    const float* border;
+    
+    // The pixels (of the image being convolved) copied to the edges, in
+    // Confine mode (vertical).
+    const float* original;
+    
+    volatile int next;          // Next band of rows to convolve.
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+// Sum the products of the weights and the floats [ 0, n ) of each of
+// the inputs, into dst.
+static inline void nrKernelCombine( const float* const* inputs, const float* weights, int size, int n, float* dst )
+{
+    int i = 0;
+    int k;
+    
+#ifdef NR_AVX2
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __m256 s = _mm256_mul_ps( _mm256_set1_ps( weights[ 0 ] ), _mm256_loadu_ps( inputs[ 0 ] + i ) );
+        
+        for ( k = 1; k < size; k++ )
+        {
+            s = _mm256_add_ps( s, _mm256_mul_ps( _mm256_set1_ps( weights[ k ] ), _mm256_loadu_ps( inputs[ k ] + i ) ) );
+        }
+        
+        _mm256_storeu_ps( dst + i, s );
+    }
+#endif
+    
+    for ( ; i < n; i++ )
+    {
+        float s = weights[ 0 ] * inputs[ 0 ][ i ];
+        
+        for ( k = 1; k < size; k++ )
+        {
+            s = s + weights[ k ] * inputs[ k ][ i ];
+        }
+        
+        dst[ i ] = s;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrKernel::nrKernel( void )
+{
+    m_Size = 0;
+    m_Row = 0;
+    m_Column = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrKernel::~nrKernel( void )
+{
+    delete [] m_Row;
+    delete [] m_Column;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void nrKernel::CreateGaussian( int size, float sigma )
+{
+    float* weights = new float[ size ];
+    
+    for ( int i = 0; i < size; i++ )
+    {
+        weights[ i ] = Gaussian( i - size / 2, sigma );
+    }
+    
+    Normalize( weights, size );
+    
+    Create( weights, weights, size );
+    
+    delete [] weights;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void nrKernel::CreateSobel( int mode )
+{
+    // The outer products are
+    //
+    //   Vertical      Horizontal
+    //   -1  0  1       1  2  1
+    //   -2  0  2       0  0  0
+    //   -1  0  1      -1 -2 -1
+    //
+    // (with row 0 at the top), which sum to 0, so aren't normalized.
+    static const float smooth[ 3 ] = {  1.0f, 2.0f,  1.0f };
+    static const float slope[ 3 ]  = { -1.0f, 0.0f,  1.0f };
+    static const float drop[ 3 ]   = {  1.0f, 0.0f, -1.0f };
+    
+    if ( mode == Vertical )
+    {
+        Create( slope, smooth, 3 );
+    }
+    else
+    {
+        Create( smooth, drop, 3 );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void nrKernel::Create( const float* row, const float* column, int size )
+{
+    assert( size > 0 );
+    
+    delete [] m_Row;
+    delete [] m_Column;
+    
+    m_Size = size;
+    m_Row = new float[ size ];
+    m_Column = new float[ size ];
+    
+    memcpy( m_Row, row, size * sizeof ( float ) );
+    memcpy( m_Column, column, size * sizeof ( float ) );
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void nrKernel::Convolve( const nrFrameBuffer& src, nrFrameBuffer& dst, int mode, const nrColor& color ) const
+{
+    float pixel[ 4 ] = { color.r, color.g, color.b, 1.0f };
+    
+    Convolve( src, dst, mode, pixel );
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+nrImage* nrKernel::Convolve( const nrImage* src, int mode, const nrPixel& color ) const
+{
+    int w = src->Width();
+    int h = src->Height();
+    int d = src->Depth();
+    int i, j;
+    
+    // Convolve the components (0 to 255) as the floats of a frame buffer.
+    nrFrameBuffer buffer;
+    buffer.Create( w, h );
+    
+    nrPixel pixel;
+    
+    for ( j = 0; j < h; j++ )
+    {
+        for ( i = 0; i < w; i++ )
+        {
+            src->GetPixel( i, j, pixel );
+            
+            float* p = buffer.Pixel( i, j );
+            
+            p[ 0 ] = ( float )pixel.r;
+            p[ 1 ] = ( float )pixel.g;
+            p[ 2 ] = ( float )pixel.b;
+            p[ 3 ] = ( float )pixel.a;
+        }
+    }
+    
+    float border[ 4 ] = { ( float )color.r, ( float )color.g, ( float )color.b, ( float )color.a };
+    
+    Convolve( buffer, buffer, mode, border );
+    
+    nrImage* dst = new nrImage;
+    dst->CreateBlank( w, h, d );
+    
+    for ( j = 0; j < h; j++ )
+    {
+        for ( i = 0; i < w; i++ )
+        {
+            const float* p = buffer.Pixel( i, j );
+            
+            pixel.r = ( unsigned char )nrMath::Clamp( p[ 0 ] + 0.5f, 0.0f, 255.0f );
+            pixel.g = ( unsigned char )nrMath::Clamp( p[ 1 ] + 0.5f, 0.0f, 255.0f );
+            pixel.b = ( unsigned char )nrMath::Clamp( p[ 2 ] + 0.5f, 0.0f, 255.0f );
+            pixel.a = ( unsigned char )nrMath::Clamp( p[ 3 ] + 0.5f, 0.0f, 255.0f );
+            
+            dst->SetPixel( i, j, pixel );
+        }
+    }
+    
+    return dst;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+int nrKernel::Size( void ) const
+{
+    return m_Size;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Private
+///////////////////////////////////////////////////////////////////////////
+
+void nrKernel::Convolve( const nrFrameBuffer& src, nrFrameBuffer& dst, int mode, const float* border ) const
+{
+    assert( m_Size > 0 );
+    
+    int w = src.Width();
+    int h = src.Height();
+    int i;
+    
+    if ( &dst != &src && ( dst.Width() != w || dst.Height() != h ) )
+    {
+        dst.Create( w, h );
+    }
+    
+    float* temp = new float[ w * h * 4 ];
+    
+    // The row beyond the edges, after the horizontal pass.
+    float* row = new float[ w * 4 ];
+    
+    float sum = 0.0f;
+    for ( i = 0; i < m_Size; i++ )
+    {
+        sum += m_Row[ i ];
+    }
+    for ( i = 0; i < w * 4; i++ )
+    {
+        row[ i ] = border[ i & 3 ] * sum;
+    }
+    
+    nrKernelPass pass;
+    
+    pass.width = w;
+    pass.height = h;
+    pass.size = m_Size;
+    pass.mode = mode;
+    pass.original = src.Pixel( 0, 0 );
+    
+    pass.src = src.Pixel( 0, 0 );
+    pass.dst = temp;
+    pass.weights = m_Row;
+    pass.horizontal = true;
+    pass.border = border;
+    pass.next = 0;
+    
+    nrThread::Run( ConvolveRows, &pass );
+    
+    pass.src = temp;
+    pass.dst = dst.Pixel( 0, 0 );
+    pass.weights = m_Column;
+    pass.horizontal = false;
+    pass.border = row;
+    pass.next = 0;
+    
+    nrThread::Run( ConvolveRows, &pass );
+    
+    delete [] row;
+    delete [] temp;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void nrKernel::ConvolveRows( void* data, int thread, int num_threads )
+{
+    nrKernelPass* pass = ( nrKernelPass* )data;
+    
+    int w = pass->width;
+    int h = pass->height;
+    int size = pass->size;
+    int half = size / 2;
+    int n = w * 4;
+    int k;
+    
+    const float** inputs = new const float*[ size ];
+    
+    // A row with half a kernel of pixels beyond each edge.
+    float* padded = pass->horizontal ? new float[ ( w + size - 1 ) * 4 ] : 0;
+    
+    int band;
+    while ( ( band = nrThread::Next( pass->next ) * NR_KERNEL_ROWS ) < h )
+    {
+        int end = nrMath::Min( band + NR_KERNEL_ROWS, h );
+        
+        for ( int y = band; y < end; y++ )
+        {
+            const float* src = pass->src + y * n;
+            float* dst = pass->dst + y * n;
+            
+            if ( pass->horizontal )
+            {
+                const float* left  = ( pass->mode == Border ) ? pass->border : src;
+                const float* right = ( pass->mode == Border ) ? pass->border : src + n - 4;
+                
+                for ( k = 0; k < half; k++ )
+                {
+                    memcpy( padded + k * 4, left, 4 * sizeof ( float ) );
+                }
+                
+                memcpy( padded + half * 4, src, n * sizeof ( float ) );
+                
+                for ( k = half + w; k < w + size - 1; k++ )
+                {
+                    memcpy( padded + k * 4, right, 4 * sizeof ( float ) );
+                }
+                
+                for ( k = 0; k < size; k++ )
+                {
+                    inputs[ k ] = padded + k * 4;
+                }
+                
+                nrKernelCombine( inputs, pass->weights, size, n, dst );
+                
+                continue;
+            }
+            
+            // Confined, the pixels within half a kernel of an edge are
+            // copied as they are (but src may be dst).
+            int x0 = 0;
+            int x1 = w;
+            
+            if ( pass->mode == Confine )
+            {
+                const float* original = pass->original + y * n;
+                
+                if ( y < half || y >= h - half || w <= 2 * half )
+                {
+                    memmove( dst, original, n * sizeof ( float ) );
+                    continue;
+                }
+                
+                x0 = half;
+                x1 = w - half;
+                
+                memmove( dst, original, x0 * 4 * sizeof ( float ) );
+                memmove( dst + x1 * 4, original + x1 * 4, ( w - x1 ) * 4 * sizeof ( float ) );
+            }
+            
+            for ( k = 0; k < size; k++ )
+            {
+                int j = y + k - half;
+                
+                if ( pass->mode == Border && ( j < 0 || j >= h ) )
+                {
+                    inputs[ k ] = pass->border + x0 * 4;
+                }
+                else
+                {
+                    inputs[ k ] = pass->src + nrMath::Clamp( j, 0, h - 1 ) * n + x0 * 4;
+                }
+            }
+            
+            nrKernelCombine( inputs, pass->weights, size, ( x1 - x0 ) * 4, dst + x0 * 4 );
+        }
+    }
+    
+    delete [] padded;
+    delete [] inputs;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+float nrKernel::Gaussian( int x, float sigma )
+{
+    float dx = 0.1f;
+    
+    float two_sigma_squared = 2.0f * sigma * sigma;
+    
+    float g = 0.0f;
+    int count = 0;
+    for ( float xx = x - 0.5f; xx < x + 0.5f + dx / 2; xx += dx )
+    {
+        g += nrMath::Pow( 2.718282f, -( xx * xx ) / two_sigma_squared );
+        count++;
+    }
+    
+    return g / ( float )count;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrKernel::Normalize( float* weights, int size )
+{
+    int i;
+    
+    float sum = 0.0f;
+    for ( i = 0; i < size; i++ )
+    {
+        sum += weights[ i ];
+    }
+    
+    if ( nrMath::Equal( sum, 0.0f ) )
+    {
+        return;
+    }
+    
+    sum = 1.0f / sum;
+    for ( i = 0; i < size; i++ )
+    {
+        weights[ i ] *= sum;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
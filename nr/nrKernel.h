@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrKernel.h
+//
+// A class for convolutions.
+//
+// Kernels are separable: the outer product of a row (of weights across x)
+// and a column (down y) of the same size, so an image is convolved with
+// a pass of the row over each row of pixels, then a pass of the column
+// over the result, in 2 * size rather than size^2 multiplies a pixel.
+// Each pass works on bands of rows on several threads at once (see
+// nrThread) and, if AVX2 is available (see nrSimd.h), on 8 floats (2
+// pixels) at a time, with the same results.
+//
+// Frame buffers are convolved in all four floats of each pixel, so the
+// weights of the samples (see nrFrameBuffer) are filtered with the colors
+// and a resolved pixel is the weighted average of the samples around it.
+//
+// Nate Robins, March 2001.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRKERNEL_H
+#define NRKERNEL_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrColor.h"
+#include "nrPixel.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// Number of rows a thread convolves at a time.
+#define NR_KERNEL_ROWS 16
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrFrameBuffer;
+class nrImage;
+
+class nrKernel
+{
+public:
+    
+    enum
+    {
+        Horizontal,
+        Vertical
+    };
+    
+    enum
+    {
+        Confine,	// Kernel never extends beyond edges of the data.
+        Clamp,		// Elements outside the edges are clamped to closest edge values.
+        Border		// Elements outside the edges are set to border color.
+    };
+    
+    
+public:
+    
+    nrKernel( void );
+    ~nrKernel( void );
+    
+    // Create a gaussian kernel of the specified size (best if odd) and
+    // sigma.
+    void CreateGaussian( int size = 5, float sigma = 1.4f );
+    
+    // Create a 3x3 sobel kernel to detect the class of edges specified.
+    void CreateSobel( int edges = Horizontal );
+    
+    // Create a kernel from a row and a column of size (best if odd)
+    // weights each.
+    void Create( const float* row, const float* column, int size );
+    
+    // Convolve a frame buffer by the kernel into dst (which may be src),
+    // of the same dimensions.  The color parameter (a sample of weight 1)
+    // is only used in Border mode.
+    void Convolve( const nrFrameBuffer& src, nrFrameBuffer& dst, int mode = Clamp, const nrColor& color = nrColor( 0.0f, 0.0f, 0.0f ) ) const;
+    
+    // Returns a new image containing the specified image convolved by the
+    // kernel (rounded, and clamped to [ 0, 255 ]).
+    // The color parameter is only used in Border mode.
+    nrImage* Convolve( const nrImage* image, int mode = Confine, const nrPixel& color = nrPixel( 255, 255, 255 ) ) const;
+    
+    // Returns the size of the kernel.
+    int Size( void ) const;
+    
+private:
+    
+    // Convolve a frame buffer, with the border pixel (4 floats).
+    void Convolve( const nrFrameBuffer& src, nrFrameBuffer& dst, int mode, const float* border ) const;
+    
+    // Convolve the bands of rows of a pass, on each thread (see
+    // nrThread::Run()).
+    static void ConvolveRows( void* data, int thread, int num_threads );
+    
+    // Evaluate the gaussian function, averaged over the pixel at x.
+    static float Gaussian( int x, float sigma );
+    
+    // Normalize size weights (to sum to 1).
+    static void Normalize( float* weights, int size );
+    
+    // Not copyable.
+    nrKernel( const nrKernel& );
+    nrKernel& operator=( const nrKernel& );
+    
+private:
+    
+    int m_Size;
+    float* m_Row;
+    float* m_Column;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRKERNEL_H
@@ -16,7 +16,7 @@
 // Includes
 ////////////////////////////////////////////////////////////////////////////
 
-#include "nrArray.h"
+#include "nrHash.h"
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -45,10 +45,12 @@ public:
     // If the item couldn't be found, 0 is returned.
     inline T* Find( const char* key ) const;
     
+    // Return the number of items in the library.
+    inline int Length( void ) const;
+    
 private:
 	
-    nrArray< char* > m_Keys;
-    nrArray< T* > m_Items;
+    nrHash< T* > m_Items;
 };
 
 ////////////////////////////////////////////////////////////////////////////
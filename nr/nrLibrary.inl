@@ -28,10 +28,8 @@ template <class T> inline nrLibrary<T>::nrLibrary( void )
 
 template <class T> inline nrLibrary<T>::~nrLibrary( void )
 {
-	for ( int i = 0; i < m_Keys.Length(); i++ )
-	{
-		delete [] m_Keys[ i ];
-	}
+    // The items are not owned by the library (the keys are freed by the
+    // hash table).
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -40,12 +38,9 @@ template <class T> inline void nrLibrary<T>::Add( const char* key, T* item )
 {
     assert( item );
 	
-    if ( Find( key ) == 0 )
+    if ( key && Find( key ) == 0 )
     {
-		char* k = new char[ strlen( key ) + 1 ];
-		strcpy( k, key );
-		m_Keys.Add( k );
-        m_Items.Add( item );
+        m_Items.Add( key, item );
     }
 }
 
@@ -53,15 +48,16 @@ template <class T> inline void nrLibrary<T>::Add( const char* key, T* item )
 
 template <class T> inline T* nrLibrary<T>::Find( const char* key ) const
 {
-	for ( int i = 0; i < m_Keys.Length(); i++ )
-	{
-		if ( key && m_Keys[ i ] && ( strcmp( key, m_Keys[ i ] ) == 0 ) )
-		{
-			return m_Items[ i ];
-		}
-	}
+    T** item = m_Items.Find( key );
     
-    return 0;
+    return item ? *item : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <class T> inline int nrLibrary<T>::Length( void ) const
+{
+    return m_Items.Length();
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -21,6 +21,10 @@
 #include "nrLibrary.h"
 #include "nrNoise.h"
 #include "nrParser.h"
+#include "nrProgram.h"
+#include "nrVector3.h"
+
+#include <stdio.h>
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -28,6 +32,10 @@
 ////////////////////////////////////////////////////////////////////////////
 
 nrLibrary<nrMaterial> nrMaterial::m_Library;
+nrHash<nrMaterial*> nrMaterial::m_Interned;
+int nrMaterial::m_NumMaterials = 0;
+int nrMaterial::m_NumShared = 0;
+int nrMaterial::m_NextID = 1;
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -36,20 +44,27 @@ nrLibrary<nrMaterial> nrMaterial::m_Library;
 
 nrMaterial::nrMaterial( void )
 {
+    m_NumMaterials++;
+    
+    m_ID = m_NextID++;
     m_Name = 0;
     m_Ambient = 0;
     m_Diffuse = 0;
     m_Specular = 0;
+    m_Program = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
 nrMaterial::~nrMaterial( void )
 {
+    m_NumMaterials--;
+    
     delete [] m_Name;
-	delete m_Ambient;
-	delete m_Diffuse;
-	delete m_Specular;
+	nrChannel::Release( m_Ambient );
+	nrChannel::Release( m_Diffuse );
+	nrChannel::Release( m_Specular );
+    delete m_Program;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -75,11 +90,25 @@ const char* nrMaterial::GetName( void ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrColor nrMaterial::Ambient( const nrVector3& point ) const
+int nrMaterial::NumMaterials( void )
+{
+    return m_NumMaterials;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrMaterial::NumShared( void )
+{
+    return m_NumShared;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrColor nrMaterial::Ambient( const nrVector3& point, float footprint ) const
 {
 	if ( m_Ambient != 0 )
 	{
-		return m_Ambient->Color( point );
+		return m_Ambient->Color( point, footprint );
 	}
 	else
 	{
@@ -89,11 +118,11 @@ nrColor nrMaterial::Ambient( const nrVector3& point ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrColor nrMaterial::Diffuse( const nrVector3& point ) const
+nrColor nrMaterial::Diffuse( const nrVector3& point, float footprint ) const
 {
 	if ( m_Diffuse != 0 )
 	{
-		return m_Diffuse->Color( point );
+		return m_Diffuse->Color( point, footprint );
 	}
 	else
 	{
@@ -103,11 +132,11 @@ nrColor nrMaterial::Diffuse( const nrVector3& point ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrColor nrMaterial::Specular( const nrVector3& point ) const
+nrColor nrMaterial::Specular( const nrVector3& point, float footprint ) const
 {
 	if ( m_Specular != 0 )
 	{
-		return m_Specular->Color( point );
+		return m_Specular->Color( point, footprint );
 	}
 	else
 	{
@@ -117,6 +146,87 @@ nrColor nrMaterial::Specular( const nrVector3& point ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
+void nrMaterial::Evaluate( const nrVector3& point, float footprint, nrColor& ambient, nrColor& diffuse, nrColor& specular ) const
+{
+	// Channels are interned, so identical channels are the same channel.
+	if ( m_Ambient != 0 )
+	{
+		ambient = m_Ambient->Color( point, footprint );
+	}
+	else
+	{
+		ambient = nrColor( 0, 0, 0 );
+	}
+	
+	if ( m_Diffuse != 0 && m_Diffuse == m_Ambient )
+	{
+		diffuse = ambient;
+	}
+	else if ( m_Diffuse != 0 )
+	{
+		diffuse = m_Diffuse->Color( point, footprint );
+	}
+	else
+	{
+		diffuse = nrColor( 1, 1, 1 );
+	}
+	
+	if ( m_Specular != 0 && m_Specular == m_Ambient )
+	{
+		specular = ambient;
+	}
+	else if ( m_Specular != 0 && m_Specular == m_Diffuse )
+	{
+		specular = diffuse;
+	}
+	else if ( m_Specular != 0 )
+	{
+		specular = m_Specular->Color( point, footprint );
+	}
+	else
+	{
+		specular = nrColor( 0, 0, 0 );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrMaterial::Evaluate( const float* x, const float* y, const float* z, const float* footprint, int count,
+                           nrColor* ambient, nrColor* diffuse, nrColor* specular ) const
+{
+	if ( m_Program != 0 )
+	{
+		m_Program->Run( x, y, z, footprint, count, ambient, diffuse, specular );
+	}
+	else
+	{
+		for ( int i = 0; i < count; i++ )
+		{
+			Evaluate( nrVector3( x[ i ], y[ i ], z[ i ] ), footprint[ i ], ambient[ i ], diffuse[ i ], specular[ i ] );
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrMaterial::Bake( const nrBound& bound ) const
+{
+	if ( m_Ambient != 0 )
+	{
+		m_Ambient->Bake( bound );
+	}
+	if ( m_Diffuse != 0 )
+	{
+		m_Diffuse->Bake( bound );
+	}
+	if ( m_Specular != 0 )
+	{
+		m_Specular->Bake( bound );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 nrMaterial* nrMaterial::ParseColor( nrParser& parser )
 {
     nrColor color;
@@ -132,11 +242,25 @@ nrMaterial* nrMaterial::ParseColor( nrParser& parser )
         return 0;
     }
     
-    nrMaterial* material = new nrMaterial();
-	material->m_Ambient = new nrChannelColor( color );
-	material->m_Diffuse = new nrChannelColor( color );
+    nrChannelColor* channel = nrChannelColor::Intern( color );
     
-    m_Library.Add( material->m_Name, material );
+    char key[ 64 ];
+    sprintf( key, "%p %p %p", channel, channel, ( void* )0 );
+    
+    nrMaterial** m = m_Interned.Find( key );
+    if ( m )
+    {
+        m_NumShared++;
+        return *m;
+    }
+    
+    // The material has no name, so there's no point in adding it to the
+    // library (it couldn't be found again).
+    nrMaterial* material = new nrMaterial();
+	material->m_Ambient = channel;
+	material->m_Diffuse = channel;
+    material->Compile();
+    m_Interned.Add( key, material );
     
     return material;
 }
@@ -160,11 +284,11 @@ nrMaterial* nrMaterial::Parse( nrParser& parser )
 			nrMaterial* m = m_Library.Find( name );
 			if ( m )
 			{
+				delete material;
 				return m;
 			}
 			
 			material->SetName( name );
-			m_Library.Add( name, material );
 		}
     }
     
@@ -186,7 +310,7 @@ nrMaterial* nrMaterial::Parse( nrParser& parser )
                 float r = parser.ReadFloat();
                 float g = parser.ReadFloat();
                 float b = parser.ReadFloat();
-				material->m_Ambient = new nrChannelColor( nrColor( r, g, b ) );
+				material->m_Ambient = nrChannelColor::Intern( nrColor( r, g, b ) );
 				parser.ReadToken( nrParser::TOKEN_LIST_END );
 			}
         }
@@ -202,7 +326,7 @@ nrMaterial* nrMaterial::Parse( nrParser& parser )
                 float r = parser.ReadFloat();
                 float g = parser.ReadFloat();
                 float b = parser.ReadFloat();
-				material->m_Diffuse = new nrChannelColor( nrColor( r, g, b ) );
+				material->m_Diffuse = nrChannelColor::Intern( nrColor( r, g, b ) );
 				parser.ReadToken( nrParser::TOKEN_LIST_END );
 			}
         }
@@ -218,7 +342,7 @@ nrMaterial* nrMaterial::Parse( nrParser& parser )
                 float r = parser.ReadFloat();
                 float g = parser.ReadFloat();
                 float b = parser.ReadFloat();
-				material->m_Specular = new nrChannelColor( nrColor( r, g, b ) );
+				material->m_Specular = nrChannelColor::Intern( nrColor( r, g, b ) );
 				parser.ReadToken( nrParser::TOKEN_LIST_END );
 			}
         }
@@ -232,10 +356,67 @@ nrMaterial* nrMaterial::Parse( nrParser& parser )
     
     if ( parser.Error() )
     {
+        delete material;
         return 0;
     }
     
+    // If an identical material already exists, use it instead (the 
+    // channels are shared, so deleting this one leaves them alone).
+    char key[ 64 ];
+    if ( material->Key( key ) )
+    {
+        nrMaterial** m = m_Interned.Find( key );
+        if ( m )
+        {
+            if ( material->GetName() )
+            {
+                m_Library.Add( material->GetName(), *m );
+            }
+            
+            delete material;
+            m_NumShared++;
+            
+            return *m;
+        }
+        
+        m_Interned.Add( key, material );
+    }
+    
+    material->Compile();
+    
+    if ( material->GetName() )
+    {
+        m_Library.Add( material->GetName(), material );
+    }
+    
     return material;
 }
 
 ////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+bool nrMaterial::Key( char* key ) const
+{
+    // Shared channels are identical only if they are the same channel.
+    if ( ( m_Ambient && ! m_Ambient->Shared() ) ||
+         ( m_Diffuse && ! m_Diffuse->Shared() ) ||
+         ( m_Specular && ! m_Specular->Shared() ) )
+    {
+        return false;
+    }
+    
+    sprintf( key, "%p %p %p", m_Ambient, m_Diffuse, m_Specular );
+    
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrMaterial::Compile( void )
+{
+    delete m_Program;
+    m_Program = nrProgram::Create( m_Ambient, m_Diffuse, m_Specular );
+}
+
+////////////////////////////////////////////////////////////////////////////
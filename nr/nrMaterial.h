@@ -17,6 +17,7 @@
 ////////////////////////////////////////////////////////////////////////////
 
 #include "nrColor.h"
+#include "nrHash.h"
 #include "nrLibrary.h"
 
 
@@ -24,8 +25,10 @@
 // Classes
 ////////////////////////////////////////////////////////////////////////////
 
+class nrBound;
 class nrChannel;
 class nrParser;
+class nrProgram;
 class nrVector3;
 
 ////////////////////////////////////////////////////////////////////////////
@@ -38,13 +41,32 @@ public:
     ~nrMaterial( void );
     
     // Return the ambient color (at a point on the surface, if applicable).
-    nrColor Ambient( const nrVector3& p ) const;
+    // The footprint is passed on to the channels (see nrChannel::Color()).
+    nrColor Ambient( const nrVector3& p, float footprint = 0.0f ) const;
     
     // Return the diffuse color (at a point on the surface, if applicable).
-    nrColor Diffuse( const nrVector3& p ) const;
+    nrColor Diffuse( const nrVector3& p, float footprint = 0.0f ) const;
     
     // Return the specular color (at a point on the surface, if applicable).
-    nrColor Specular( const nrVector3& p ) const;
+    nrColor Specular( const nrVector3& p, float footprint = 0.0f ) const;
+    
+    // Return the ambient, diffuse and specular colors at once.  A channel
+    // used for more than one of them (e.g., the same marble for ambient
+    // and diffuse) is only evaluated once, so shading a hit with all of
+    // the colors costs no more than the distinct channels do.
+    void Evaluate( const nrVector3& p, float footprint, nrColor& ambient, nrColor& diffuse, nrColor& specular ) const;
+    
+    // Return the ambient, diffuse and specular colors at a batch of count
+    // (at most NR_PROGRAM_BATCH) points with the given footprints.  The 
+    // channels are evaluated by the program compiled from them, if there
+    // is one (see nrProgram), one instruction for the whole batch at a 
+    // time.  The results are the same as Evaluate() at each point.
+    void Evaluate( const float* x, const float* y, const float* z, const float* footprint, int count,
+                   nrColor* ambient, nrColor* diffuse, nrColor* specular ) const;
+    
+    // Bake the channels over the bound of the surfaces the material is
+    // used on (see nrChannel::Bake()).
+    void Bake( const nrBound& bound ) const;
     
     // Return a new material parsed from a file.  The material directive 
     // has the following form:
@@ -56,19 +78,41 @@ public:
     //   specular < r g b >
     // }
     // 
-    // elements in ()'s are optional.
+    // elements in ()'s are optional.  Materials are interned by name and
+    // by content: a material with the name of one already parsed is not
+    // parsed again, and a new material made entirely of shared channels 
+    // is replaced by an identical material, if there is one.
     static nrMaterial* Parse( nrParser& parser );
     
     // Return a new material parsed from a color directive.  The color 
     // directive has the following form:
     // 
     // color < r g b >
-    static nrMaterial* nrMaterial::ParseColor( nrParser& parser );
+    // 
+    // The material is interned by content, so every surface of the same
+    // color shares one material.
+    static nrMaterial* ParseColor( nrParser& parser );
     
     // Set/Get the material name.
     void SetName( const char* name );
     const char* GetName( void ) const;
     
+    // Return the number of materials created, and the number of times an
+    // existing material was shared instead of creating an identical one.
+    static int NumMaterials( void );
+    static int NumShared( void );
+    
+private:
+    
+    // Write the key materials are interned by (the addresses of the
+    // channels) into key, which must hold at least 64 characters.  Return
+    // false if the material can't be interned (it has channels which 
+    // aren't shared, so identical materials can't be recognized).
+    bool Key( char* key ) const;
+    
+    // Compile the channels into a program.
+    void Compile( void );
+    
 public:
     
     char* m_Name;
@@ -77,7 +121,20 @@ public:
 	nrChannel* m_Diffuse;
 	nrChannel* m_Specular;
 	
+    nrProgram* m_Program;
+    
+    // A number no other material has (and never 0), to tell materials
+    // apart in a G-buffer (see nrDenoiser).
+    int m_ID;
+	
     static nrLibrary<nrMaterial> m_Library;
+    
+private:
+    
+    static nrHash<nrMaterial*> m_Interned;
+    static int m_NumMaterials;
+    static int m_NumShared;
+    static int m_NextID;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -70,6 +70,11 @@ public:
     
     ////////////////////////////////////////////////////////////////////////
     
+    // Return the base 2 logarithm of x.
+    inline static float Log2( float x );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
     // Return the next highest power of two (i.e., NextPowerOfTwo( 5 ) 
     // would return 8, NextPowerOfTwo( 16 ) would return 16). 
     inline static int NextPowerOfTwo( int x );
@@ -87,6 +92,12 @@ public:
     
     ////////////////////////////////////////////////////////////////////////
     
+    // Return 0 if x <= min, 1 if x >= max, and a smooth (cubic) ramp from
+    // 0 to 1 in between.
+    inline static float SmoothStep( float min, float max, float x );
+    
+    ////////////////////////////////////////////////////////////////////////
+    
     // Return the argument x wrapped in the range [0, period].
     inline static float Wrap( float x, float period = 1.0f );
     inline static int Wrap( int x, int period = 100 );
@@ -161,6 +172,8 @@ public:
     ////////////////////////////////////////////////////////////////////////
     
     // Return a random floating point number in the range [min, max]. 
+    // This is rand(), which isn't thread safe or repeatable across
+    // threads; samples for rendering come from nrSampler instead.
     inline static float Random_f( float min = 0.0f, float max = 1.0f );
     
     ////////////////////////////////////////////////////////////////////////
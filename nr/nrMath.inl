@@ -93,6 +93,13 @@ inline float nrMath::Pow( float x, float y )
 
 ////////////////////////////////////////////////////////////////////////////
 
+inline float nrMath::Log2( float x )
+{
+    return logf( x ) * 1.44269504f;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 inline float nrMath::Ceil( float x )
 {
     return ceilf( x );
@@ -236,6 +243,15 @@ inline int nrMath::Clamp( int x, int min, int max )
 
 ////////////////////////////////////////////////////////////////////////////
 
+inline float nrMath::SmoothStep( float min, float max, float x )
+{
+    float t = Clamp( ( x - min ) / ( max - min ) );
+    
+    return t * t * ( 3.0f - 2.0f * t );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 inline float nrMath::Wrap( float x, float period )
 {
     float y = Mod( x, period );
@@ -17,6 +17,13 @@
 #define NRNOISE_H
 
 
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSimd.h"
+
+
 ////////////////////////////////////////////////////////////////////////////
 // Classes
 ////////////////////////////////////////////////////////////////////////////
@@ -36,11 +43,20 @@ public:
     inline static float Noise2( const nrVector2& v );
     inline static float Noise3( const nrVector3& v );
     
+    // Compute noise at 8 points at once (v[ n ][ i ] is component n of
+    // point i).
+    inline static void Noise3( const float v[ 3 ][ 8 ], float noise[ 8 ] );
+    
     // Compute fractal noise (sums of octaves of noise).
     inline static float Fractal1( const float v, int octaves = 8 );
     inline static float Fractal2( const nrVector2& v, int octaves = 8 );
     inline static float Fractal3( const nrVector3& v, int octaves = 8 );
     
+    // Compute fractal noise with a fractional number of octaves.  The 
+    // last, partial octave is faded in smoothly, so the noise doesn't pop
+    // as the number of octaves changes.
+    inline static float Fractal3( const nrVector3& v, float octaves );
+    
     // Compute turbulence (sums of absolute values of octaves of noise).
     inline static float Turbulence1( const float v, int octaves = 8 );
     inline static float Turbulence2( const nrVector2& v, int octaves = 8 );
@@ -62,6 +78,10 @@ private:
     nrNoise( void );
     ~nrNoise( void );
     
+    // Compute 8 octaves of noise at once, starting with octave first.
+    // The frequency of each octave is returned in o.
+    inline static void Octaves3( const nrVector3& v, int first, float noise[ 8 ], float o[ 8 ] );
+    
 private:
     
     static nrNoiseN<1> m_Noise1;
@@ -81,10 +101,24 @@ public:
     // Return noise based on input vector.
     inline float Get( const float v[ N ] ) const;
     
+    // Return noise at 8 points at once (v[ n ][ i ] is component n of
+    // point i).
+    inline void Get( const float v[ N ][ 8 ], float noise[ 8 ] ) const;
+    
+    // Return noise based on input vector, computed by the general 
+    // (recursive) code.  Get() is hand specialized for N = 3, and returns
+    // the same results.
+    inline float GetRecursive( const float v[ N ] ) const;
+    
 private:
     // Recursive noise function which computes noise in N dimensions.
 	inline float Get( int p[ N ], float r[ N ], float s[ N ], int cumulative_p, int n ) const;
     
+#ifdef NR_AVX2
+    // Return the dot products of 8 gradients and vectors.
+    inline __m256 Gradient( __m256i g, __m256 x, __m256 y, __m256 z ) const;
+#endif
+    
     // Cubic spline interpolation.
 	inline float CubicSpline( float t ) const;
     
@@ -25,6 +25,316 @@
 #include "nrVector3.h"
 
 
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+template <int N> inline nrNoiseN<N>::nrNoiseN( void )
+{
+    int i;
+    
+    for ( i = 0; i < NUM; i++ )
+    {
+        int n;
+        
+        // Compute a random direction (gradient).
+        float l = 0.0f;
+        for ( n = 0; n < N; n++ )
+        {
+            float& g = m_Gradients[ i ][ n ];
+            
+            g = nrMath::Random_f( -1.0f, 1.0f );
+            
+            l += g * g;
+        }
+        
+        // Normalize the gradient.
+        l = 1.0f / nrMath::Sqrt( l );
+        for ( n = 0; n < N; n++ )
+        {
+            m_Gradients[ i ][ n ] *= l;
+        }
+    }
+    
+    // Create pointers into the gradient table and randomize them.
+    for ( i = 0; i < NUM; i++ )
+    {
+        m_Pointers[ i ] = i;
+    }
+    
+    for ( i = 0; i < NUM; i++ )
+    {
+        int j = nrMath::Random_i( 0, NUM - 1 );
+        int t = m_Pointers[ i ];
+        
+        m_Pointers[ i ] = m_Pointers[ j ];
+        m_Pointers[ j ] = t;
+    }
+    
+    // Copy the pointers and gradients to the second half of the array.
+    for ( i = 0; i < NUM + PAD; i++ )
+    {	
+        m_Pointers[ NUM + i ] = m_Pointers[ i ];
+        
+        for ( int n = 0; n < N; n++ )
+        {
+            m_Gradients[ NUM + i ][ n ] = m_Gradients[ i ][ n ];
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <int N> inline nrNoiseN<N>::~nrNoiseN( void )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <int N> inline float nrNoiseN<N>::Get( const float v[ N ] ) const
+{
+    return GetRecursive( v );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <int N> inline void nrNoiseN<N>::Get( const float v[ N ][ 8 ], float noise[ 8 ] ) const
+{
+    for ( int i = 0; i < 8; i++ )
+    {
+        float w[ N ];
+        for ( int n = 0; n < N; n++ )
+        {
+            w[ n ] = v[ n ][ i ];
+        }
+        
+        noise[ i ] = Get( w );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <int N> inline float nrNoiseN<N>::GetRecursive( const float v[ N ] ) const
+{
+    int offsets[ N ];   // Grid (indices into gradients) offsets.
+    float grid[ N ];    // The original vector clamped to a grid point.
+    float r[ N ];       // Vector from grid point to the actual point.
+    float t[ N ];       // Interpolation values.
+    
+    for ( int i = 0; i < N; i++ )
+    {
+        grid[ i ] = nrMath::Floor( v[ i ] );
+        offsets[ i ] = ( ( int )grid[ i ] ) & MASK;
+        r[ i ] = v[ i ] - grid[ i ];
+        t[ i ] = CubicSpline( r[ i ] );
+    }
+    
+    return Get( offsets, r, t, 0, 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <> inline float nrNoiseN<3>::Get( const float v[ 3 ] ) const
+{
+    // This is the recursive Get() unrolled for 3 dimensions.  The vector
+    // from the grid point is stepped back and forth in the same order, so
+    // the rounding (and thus the result) is the same.
+    float gx = nrMath::Floor( v[ 0 ] );
+    float gy = nrMath::Floor( v[ 1 ] );
+    float gz = nrMath::Floor( v[ 2 ] );
+    
+    int px = ( ( int )gx ) & MASK;
+    int py = ( ( int )gy ) & MASK;
+    int pz = ( ( int )gz ) & MASK;
+    
+    float rx = v[ 0 ] - gx;
+    float ry = v[ 1 ] - gy;
+    float rz = v[ 2 ] - gz;
+    
+    float tx = CubicSpline( rx );
+    float ty = CubicSpline( ry );
+    float tz = CubicSpline( rz );
+    
+    float rx1 = rx - 1.0f;
+    float ry1 = ry - 1.0f;
+    float rz1 = rz - 1.0f;
+    float ry0 = ry1 + 1.0f;
+    float rz0 = rz1 + 1.0f;
+    
+    int a = m_Pointers[ px ];
+    int b = m_Pointers[ px + 1 ];
+    int aa = m_Pointers[ a + py ];
+    int ab = m_Pointers[ a + py + 1 ];
+    int ba = m_Pointers[ b + py ];
+    int bb = m_Pointers[ b + py + 1 ];
+    
+    const float* g;
+    
+    g = m_Gradients[ m_Pointers[ aa + pz ] ];
+    float aaa = rx * g[ 0 ] + ry * g[ 1 ] + rz * g[ 2 ];
+    g = m_Gradients[ m_Pointers[ aa + pz + 1 ] ];
+    float aab = rx * g[ 0 ] + ry * g[ 1 ] + rz1 * g[ 2 ];
+    g = m_Gradients[ m_Pointers[ ab + pz ] ];
+    float aba = rx * g[ 0 ] + ry1 * g[ 1 ] + rz0 * g[ 2 ];
+    g = m_Gradients[ m_Pointers[ ab + pz + 1 ] ];
+    float abb = rx * g[ 0 ] + ry1 * g[ 1 ] + rz1 * g[ 2 ];
+    g = m_Gradients[ m_Pointers[ ba + pz ] ];
+    float baa = rx1 * g[ 0 ] + ry0 * g[ 1 ] + rz0 * g[ 2 ];
+    g = m_Gradients[ m_Pointers[ ba + pz + 1 ] ];
+    float bab = rx1 * g[ 0 ] + ry0 * g[ 1 ] + rz1 * g[ 2 ];
+    g = m_Gradients[ m_Pointers[ bb + pz ] ];
+    float bba = rx1 * g[ 0 ] + ry1 * g[ 1 ] + rz0 * g[ 2 ];
+    g = m_Gradients[ m_Pointers[ bb + pz + 1 ] ];
+    float bbb = rx1 * g[ 0 ] + ry1 * g[ 1 ] + rz1 * g[ 2 ];
+    
+    float x0 = nrMath::Lerp( nrMath::Lerp( aaa, aab, tz ), nrMath::Lerp( aba, abb, tz ), ty );
+    float x1 = nrMath::Lerp( nrMath::Lerp( baa, bab, tz ), nrMath::Lerp( bba, bbb, tz ), ty );
+    
+    return nrMath::Lerp( x0, x1, tx );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <> inline void nrNoiseN<3>::Get( const float v[ 3 ][ 8 ], float noise[ 8 ] ) const
+{
+#ifdef NR_AVX2
+    // The same as Get() above, 8 points at a time, with the table lookups
+    // done by gathers.
+    const __m256 one = _mm256_set1_ps( 1.0f );
+    const __m256 two = _mm256_set1_ps( 2.0f );
+    const __m256 three = _mm256_set1_ps( 3.0f );
+    const __m256i mask = _mm256_set1_epi32( MASK );
+    const __m256i next = _mm256_set1_epi32( 1 );
+    
+    __m256 x = _mm256_loadu_ps( v[ 0 ] );
+    __m256 y = _mm256_loadu_ps( v[ 1 ] );
+    __m256 z = _mm256_loadu_ps( v[ 2 ] );
+    
+    __m256 gx = _mm256_floor_ps( x );
+    __m256 gy = _mm256_floor_ps( y );
+    __m256 gz = _mm256_floor_ps( z );
+    
+    __m256i px = _mm256_and_si256( _mm256_cvttps_epi32( gx ), mask );
+    __m256i py = _mm256_and_si256( _mm256_cvttps_epi32( gy ), mask );
+    __m256i pz = _mm256_and_si256( _mm256_cvttps_epi32( gz ), mask );
+    
+    __m256 rx = _mm256_sub_ps( x, gx );
+    __m256 ry = _mm256_sub_ps( y, gy );
+    __m256 rz = _mm256_sub_ps( z, gz );
+    
+    __m256 tx = _mm256_mul_ps( _mm256_mul_ps( rx, rx ), _mm256_sub_ps( three, _mm256_mul_ps( two, rx ) ) );
+    __m256 ty = _mm256_mul_ps( _mm256_mul_ps( ry, ry ), _mm256_sub_ps( three, _mm256_mul_ps( two, ry ) ) );
+    __m256 tz = _mm256_mul_ps( _mm256_mul_ps( rz, rz ), _mm256_sub_ps( three, _mm256_mul_ps( two, rz ) ) );
+    
+    __m256 rx1 = _mm256_sub_ps( rx, one );
+    __m256 ry1 = _mm256_sub_ps( ry, one );
+    __m256 rz1 = _mm256_sub_ps( rz, one );
+    __m256 ry0 = _mm256_add_ps( ry1, one );
+    __m256 rz0 = _mm256_add_ps( rz1, one );
+    
+    const int* p = m_Pointers;
+    
+    __m256i a = _mm256_i32gather_epi32( p, px, 4 );
+    __m256i b = _mm256_i32gather_epi32( p, _mm256_add_epi32( px, next ), 4 );
+    
+    __m256i aa = _mm256_i32gather_epi32( p, _mm256_add_epi32( a, py ), 4 );
+    __m256i ab = _mm256_i32gather_epi32( p, _mm256_add_epi32( _mm256_add_epi32( a, py ), next ), 4 );
+    __m256i ba = _mm256_i32gather_epi32( p, _mm256_add_epi32( b, py ), 4 );
+    __m256i bb = _mm256_i32gather_epi32( p, _mm256_add_epi32( _mm256_add_epi32( b, py ), next ), 4 );
+    
+    aa = _mm256_add_epi32( aa, pz );
+    ab = _mm256_add_epi32( ab, pz );
+    ba = _mm256_add_epi32( ba, pz );
+    bb = _mm256_add_epi32( bb, pz );
+    
+    __m256 aaa = Gradient( _mm256_i32gather_epi32( p, aa, 4 ), rx, ry, rz );
+    __m256 aab = Gradient( _mm256_i32gather_epi32( p, _mm256_add_epi32( aa, next ), 4 ), rx, ry, rz1 );
+    __m256 aba = Gradient( _mm256_i32gather_epi32( p, ab, 4 ), rx, ry1, rz0 );
+    __m256 abb = Gradient( _mm256_i32gather_epi32( p, _mm256_add_epi32( ab, next ), 4 ), rx, ry1, rz1 );
+    __m256 baa = Gradient( _mm256_i32gather_epi32( p, ba, 4 ), rx1, ry0, rz0 );
+    __m256 bab = Gradient( _mm256_i32gather_epi32( p, _mm256_add_epi32( ba, next ), 4 ), rx1, ry0, rz1 );
+    __m256 bba = Gradient( _mm256_i32gather_epi32( p, bb, 4 ), rx1, ry1, rz0 );
+    __m256 bbb = Gradient( _mm256_i32gather_epi32( p, _mm256_add_epi32( bb, next ), 4 ), rx1, ry1, rz1 );
+    
+    // Lerp( a, b, t ) = a * ( 1 - t ) + b * t.
+    __m256 sz = _mm256_sub_ps( one, tz );
+    __m256 sy = _mm256_sub_ps( one, ty );
+    __m256 sx = _mm256_sub_ps( one, tx );
+    
+    __m256 z00 = _mm256_add_ps( _mm256_mul_ps( aaa, sz ), _mm256_mul_ps( aab, tz ) );
+    __m256 z01 = _mm256_add_ps( _mm256_mul_ps( aba, sz ), _mm256_mul_ps( abb, tz ) );
+    __m256 z10 = _mm256_add_ps( _mm256_mul_ps( baa, sz ), _mm256_mul_ps( bab, tz ) );
+    __m256 z11 = _mm256_add_ps( _mm256_mul_ps( bba, sz ), _mm256_mul_ps( bbb, tz ) );
+    
+    __m256 x0 = _mm256_add_ps( _mm256_mul_ps( z00, sy ), _mm256_mul_ps( z01, ty ) );
+    __m256 x1 = _mm256_add_ps( _mm256_mul_ps( z10, sy ), _mm256_mul_ps( z11, ty ) );
+    
+    _mm256_storeu_ps( noise, _mm256_add_ps( _mm256_mul_ps( x0, sx ), _mm256_mul_ps( x1, tx ) ) );
+#else
+    for ( int i = 0; i < 8; i++ )
+    {
+        float w[ 3 ] = { v[ 0 ][ i ], v[ 1 ][ i ], v[ 2 ][ i ] };
+        
+        noise[ i ] = Get( w );
+    }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+template <int N> inline float nrNoiseN<N>::Get( int p[ N ], float r[ N ], float t[ N ], int m, int n ) const
+{
+    if ( n == N )
+    {
+        // Base case: return dot product of gradient and vector.
+        const float* g = m_Gradients[ m ];
+        
+        float v = 0.0f;
+        for ( int i = 0; i < N; i++ )
+        {
+            v += r[ i ] * g[ i ];
+        }
+        
+        return v;
+    }
+    else
+    {
+        // Recursive case: return interpolated of values.
+        float a = Get( p, r, t, m_Pointers[ m + p[ n ] ], n + 1 );
+        r[ n ] -= 1.0f;
+        float b = Get( p, r, t, m_Pointers[ m + p[ n ] + 1 ], n + 1 );
+        r[ n ] += 1.0f;
+        
+        return nrMath::Lerp( a, b, t[ n ] );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template <int N> inline float nrNoiseN<N>::CubicSpline( float t ) const
+{
+    return t * t * ( 3.0f - 2.0f * t );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+#ifdef NR_AVX2
+template <int N> inline __m256 nrNoiseN<N>::Gradient( __m256i g, __m256 x, __m256 y, __m256 z ) const
+{
+    const float* gradients = &m_Gradients[ 0 ][ 0 ];
+    
+    __m256i i = _mm256_mullo_epi32( g, _mm256_set1_epi32( N ) );
+    
+    __m256 gx = _mm256_i32gather_ps( gradients + 0, i, 4 );
+    __m256 gy = _mm256_i32gather_ps( gradients + 1, i, 4 );
+    __m256 gz = _mm256_i32gather_ps( gradients + 2, i, 4 );
+    
+    return _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, gx ), _mm256_mul_ps( y, gy ) ), _mm256_mul_ps( z, gz ) );
+}
+#endif
+
 ////////////////////////////////////////////////////////////////////////////
 // Public
 ////////////////////////////////////////////////////////////////////////////
@@ -53,6 +363,13 @@ inline float nrNoise::Noise3( const nrVector3& v )
 
 ////////////////////////////////////////////////////////////////////////////
 
+inline void nrNoise::Noise3( const float v[ 3 ][ 8 ], float noise[ 8 ] )
+{
+    m_Noise3.Get( v, noise );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 inline float nrNoise::Fractal1( const float v, int octaves )
 {
     float n = 0.0f;
@@ -86,18 +403,53 @@ inline float nrNoise::Fractal2( const nrVector2& v, int octaves )
 inline float nrNoise::Fractal3( const nrVector3& v, int octaves )
 {
     float n = 0.0f;
+#ifdef NR_AVX2
+    // Compute the octaves 8 at a time, but sum them in the same order.
+    for ( int j = 0; j < octaves; j += 8 )
+    {
+        float noise[ 8 ];
+        float o[ 8 ];
+        
+        Octaves3( v, j, noise, o );
+        
+        for ( int k = 0; k < 8 && j + k < octaves; k++ )
+        {
+            n += noise[ k ] / o[ k ];
+        }
+    }
+#else
     for ( int i = 0; i < octaves; i++ )
     {
         float o = ( float )( 1 << i );
 
         n += Noise3( v * o ) / o;
     }
+#endif
 
     return n;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
+inline float nrNoise::Fractal3( const nrVector3& v, float octaves )
+{
+    int full = ( int )octaves;
+    
+    float n = Fractal3( v, full );
+    
+    float fade = nrMath::SmoothStep( 0.3f, 0.7f, octaves - full );
+    if ( fade > 0.0f )
+    {
+        float o = ( float )( 1 << full );
+        
+        n += fade * Noise3( v * o ) / o;
+    }
+    
+    return n;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 inline float nrNoise::Turbulence1( const float v, int octaves )
 {
     float n = 0.0f;
@@ -131,12 +483,27 @@ inline float nrNoise::Turbulence2( const nrVector2& v, int octaves )
 inline float nrNoise::Turbulence3( const nrVector3& v, int octaves )
 {
     float n = 0.0f;
+#ifdef NR_AVX2
+    for ( int j = 0; j < octaves; j += 8 )
+    {
+        float noise[ 8 ];
+        float o[ 8 ];
+        
+        Octaves3( v, j, noise, o );
+        
+        for ( int k = 0; k < 8 && j + k < octaves; k++ )
+        {
+            n += nrMath::Abs( noise[ k ] / o[ k ] );
+        }
+    }
+#else
     for ( int i = 0; i < octaves; i++ )
     {
         float o = ( float )( 1 << i );
 
         n += nrMath::Abs( Noise3( v * o ) / o );
     }
+#endif
 
     return n;
 }
@@ -162,124 +529,24 @@ inline float nrNoise::Marble3( const nrVector3& v, float a, float b, int octaves
     return nrMath::Sin( 180.0f * ( a * v.x + b * Fractal3( v, octaves ) ) );
 }
 
-////////////////////////////////////////////////////////////////////////////
-
-template <int N> inline nrNoiseN<N>::nrNoiseN( void )
-{
-    int i;
-    
-    for ( i = 0; i < NUM; i++ )
-    {
-        int n;
-        
-        // Compute a random direction (gradient).
-        float l = 0.0f;
-        for ( n = 0; n < N; n++ )
-        {
-            float& g = m_Gradients[ i ][ n ];
-            
-            g = nrMath::Random_f( -1.0f, 1.0f );
-            
-            l += g * g;
-        }
-        
-        // Normalize the gradient.
-        l = 1.0f / nrMath::Sqrt( l );
-        for ( n = 0; n < N; n++ )
-        {
-            m_Gradients[ i ][ n ] *= l;
-        }
-    }
-    
-    // Create pointers into the gradient table and randomize them.
-    for ( i = 0; i < NUM; i++ )
-    {
-        m_Pointers[ i ] = i;
-    }
-    
-    for ( i = 0; i < NUM; i++ )
-    {
-        int j = nrMath::Random_i( 0, NUM - 1 );
-        int t = m_Pointers[ i ];
-        
-        m_Pointers[ i ] = m_Pointers[ j ];
-        m_Pointers[ j ] = t;
-    }
-    
-    // Copy the pointers and gradients to the second half of the array.
-    for ( i = 0; i < NUM + PAD; i++ )
-    {	
-        m_Pointers[ NUM + i ] = m_Pointers[ i ];
-        
-        for ( int n = 0; n < N; n++ )
-        {
-            m_Gradients[ NUM + i ][ n ] = m_Gradients[ i ][ n ];
-        }
-    }
-}
-
-////////////////////////////////////////////////////////////////////////////
-
-template <int N> inline nrNoiseN<N>::~nrNoiseN( void )
-{
-}
-
-////////////////////////////////////////////////////////////////////////////
-
-template <int N> inline float nrNoiseN<N>::Get( const float v[ N ] ) const
-{
-    int offsets[ N ];   // Grid (indices into gradients) offsets.
-    float grid[ N ];    // The original vector clamped to a grid point.
-    float r[ N ];       // Vector from grid point to the actual point.
-    float t[ N ];       // Interpolation values.
-    
-    for ( int i = 0; i < N; i++ )
-    {
-        grid[ i ] = nrMath::Floor( v[ i ] );
-        offsets[ i ] = ( ( int )grid[ i ] ) & MASK;
-        r[ i ] = v[ i ] - grid[ i ];
-        t[ i ] = CubicSpline( r[ i ] );
-    }
-    
-    return Get( offsets, r, t, 0, 0 );
-}
-
 ////////////////////////////////////////////////////////////////////////////
 // Private
 ////////////////////////////////////////////////////////////////////////////
 
-template <int N> inline float nrNoiseN<N>::Get( int p[ N ], float r[ N ], float t[ N ], int m, int n ) const
+inline void nrNoise::Octaves3( const nrVector3& v, int first, float noise[ 8 ], float o[ 8 ] )
 {
-    if ( n == N )
-    {
-        // Base case: return dot product of gradient and vector.
-        const float* g = m_Gradients[ m ];
-        
-        float v = 0.0f;
-        for ( int i = 0; i < N; i++ )
-        {
-            v += r[ i ] * g[ i ];
-        }
-        
-        return v;
-    }
-    else
+    float w[ 3 ][ 8 ];
+    
+    for ( int k = 0; k < 8; k++ )
     {
-        // Recursive case: return interpolated of values.
-        float a = Get( p, r, t, m_Pointers[ m + p[ n ] ], n + 1 );
-        r[ n ] -= 1.0f;
-        float b = Get( p, r, t, m_Pointers[ m + p[ n ] + 1 ], n + 1 );
-        r[ n ] += 1.0f;
+        o[ k ] = ( float )( 1 << ( first + k ) );
         
-        return nrMath::Lerp( a, b, t[ n ] );
+        w[ 0 ][ k ] = v.x * o[ k ];
+        w[ 1 ][ k ] = v.y * o[ k ];
+        w[ 2 ][ k ] = v.z * o[ k ];
     }
-}
-
-////////////////////////////////////////////////////////////////////////////
-
-template <int N> inline float nrNoiseN<N>::CubicSpline( float t ) const
-{
-    return t * t * ( 3.0f - 2.0f * t );
+    
+    m_Noise3.Get( w, noise );
 }
 
 ////////////////////////////////////////////////////////////////////////////
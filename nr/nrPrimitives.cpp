@@ -0,0 +1,850 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrPrimitives.cpp
+//
+// A class for batches of primitives stored as structures of arrays.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrPrimitives.h"
+
+#include "nrArena.h"
+#include "nrBound.h"
+#include "nrHit.h"
+#include "nrInterval.h"
+#include "nrMath.h"
+#include "nrRay.h"
+#include "nrSimd.h"
+#include "nrSurface.h"
+#include "nrSurfaceBatch.h"
+#include "nrSurfaceBox.h"
+#include "nrSurfaceBVH.h"
+#include "nrSurfaceSphere.h"
+#include "nrSurfaceTriangle.h"
+
+#include <assert.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+// Return the bound enclosing the (non-0) surfaces.
+static nrBound Enclose( nrSurface* const* surfaces, int count )
+{
+    assert( count > 0 && surfaces[ 0 ] != 0 );
+
+    nrBound bound = surfaces[ 0 ]->Bound();
+    for ( int i = 1; i < count; i++ )
+    {
+        if ( surfaces[ i ] == 0 )
+        {
+            continue;
+        }
+
+        const nrBound& b = surfaces[ i ]->Bound();
+
+        if ( b.m_Minimums.x < bound.m_Minimums.x )
+        {
+            bound.m_Minimums.x = b.m_Minimums.x;
+        }
+        if ( b.m_Minimums.y < bound.m_Minimums.y )
+        {
+            bound.m_Minimums.y = b.m_Minimums.y;
+        }
+        if ( b.m_Minimums.z < bound.m_Minimums.z )
+        {
+            bound.m_Minimums.z = b.m_Minimums.z;
+        }
+
+        if ( b.m_Maximums.x > bound.m_Maximums.x )
+        {
+            bound.m_Maximums.x = b.m_Maximums.x;
+        }
+        if ( b.m_Maximums.y > bound.m_Maximums.y )
+        {
+            bound.m_Maximums.y = b.m_Maximums.y;
+        }
+        if ( b.m_Maximums.z > bound.m_Maximums.z )
+        {
+            bound.m_Maximums.z = b.m_Maximums.z;
+        }
+    }
+
+    return bound;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+// Same epsilon as nrSurfaceSphere::Hit().
+static const float epsilon = 0.0001f;
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrPrimitives::nrPrimitives( void )
+{
+    for ( int i = 0; i < nrSurface::TYPE_COUNT; i++ )
+    {
+        m_Counts[ i ] = 0;
+        m_Firsts[ i ] = 0;
+    }
+
+    m_NumIDs = 0;
+    m_Surfaces = 0;
+    m_Materials = 0;
+
+    m_SphereX = 0;
+    m_SphereY = 0;
+    m_SphereZ = 0;
+    m_SphereR2 = 0;
+
+    m_BoxX0 = 0;
+    m_BoxY0 = 0;
+    m_BoxZ0 = 0;
+    m_BoxX1 = 0;
+    m_BoxY1 = 0;
+    m_BoxZ1 = 0;
+
+    m_TriangleX = 0;
+    m_TriangleY = 0;
+    m_TriangleZ = 0;
+    m_TriangleABX = 0;
+    m_TriangleABY = 0;
+    m_TriangleABZ = 0;
+    m_TriangleACX = 0;
+    m_TriangleACY = 0;
+    m_TriangleACZ = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrPrimitives::~nrPrimitives( void )
+{
+    // The surfaces are in the scene's arena.
+    delete [] m_Surfaces;
+    delete [] m_Materials;
+
+    delete [] m_SphereX;
+    delete [] m_SphereY;
+    delete [] m_SphereZ;
+    delete [] m_SphereR2;
+
+    delete [] m_BoxX0;
+    delete [] m_BoxY0;
+    delete [] m_BoxZ0;
+    delete [] m_BoxX1;
+    delete [] m_BoxY1;
+    delete [] m_BoxZ1;
+
+    delete [] m_TriangleX;
+    delete [] m_TriangleY;
+    delete [] m_TriangleZ;
+    delete [] m_TriangleABX;
+    delete [] m_TriangleABY;
+    delete [] m_TriangleABZ;
+    delete [] m_TriangleACX;
+    delete [] m_TriangleACY;
+    delete [] m_TriangleACZ;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrPrimitives::Hit( nrSurface::nrType type, int first, int count, const nrRay& ray, nrInterval& interval, nrHit& hit ) const
+{
+    switch ( type )
+    {
+    case nrSurface::TYPE_SPHERE:
+        return HitSpheres( first, count, ray, interval, hit );
+
+    case nrSurface::TYPE_BOX:
+        return HitBoxes( first, count, ray, interval, hit );
+
+    case nrSurface::TYPE_TRIANGLE:
+        return HitTriangles( first, count, ray, interval, hit );
+
+    default:
+        assert( 0 );
+        return false;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSurface::nrType nrPrimitives::Type( int id ) const
+{
+    assert( id >= 0 && id < m_NumIDs );
+
+    if ( id >= m_Firsts[ nrSurface::TYPE_TRIANGLE ] )
+    {
+        return nrSurface::TYPE_TRIANGLE;
+    }
+    else if ( id >= m_Firsts[ nrSurface::TYPE_BOX ] )
+    {
+        return nrSurface::TYPE_BOX;
+    }
+    else
+    {
+        return nrSurface::TYPE_SPHERE;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+const nrSurface* nrPrimitives::Surface( int id ) const
+{
+    assert( id >= 0 && id < m_NumIDs );
+
+    return m_Surfaces[ id ];
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+const nrMaterial* nrPrimitives::Material( int id ) const
+{
+    assert( id >= 0 && id < m_NumIDs );
+
+    return m_Materials[ id ];
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrVector3 nrPrimitives::Normal( int id, const nrVector3& point ) const
+{
+    assert( m_Surfaces[ id ] != 0 );
+
+    // Qualified calls, so there is no virtual dispatch.
+    switch ( Type( id ) )
+    {
+    case nrSurface::TYPE_SPHERE:
+        return ( ( const nrSurfaceSphere* )m_Surfaces[ id ] )->nrSurfaceSphere::Normal( point );
+
+    case nrSurface::TYPE_BOX:
+        return ( ( const nrSurfaceBox* )m_Surfaces[ id ] )->nrSurfaceBox::Normal( point );
+
+    default:
+        return ( ( const nrSurfaceTriangle* )m_Surfaces[ id ] )->nrSurfaceTriangle::Normal( point );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrPrimitives::Count( nrSurface::nrType type ) const
+{
+    return m_Counts[ type ];
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+inline bool nrPrimitives::HitSpheres( int first, int count, const nrRay& ray, nrInterval& interval, nrHit& hit ) const
+{
+    assert( first % NR_SIMD_WIDTH == 0 );
+
+    const nrVector3& d = ray.d;
+    const nrVector3& o = ray.o;
+
+    // The same arithmetic as nrSurfaceSphere::Hit(), one sphere per lane.
+    float A = d.Dot( d );       assert( ! nrMath::Equal( A, 0.0f ) );
+    float maximum = interval.m_Maximum;
+    int closest = -1;
+
+    int offset = m_Firsts[ nrSurface::TYPE_SPHERE ];
+
+#ifdef NR_AVX2
+
+    __m256 dx = _mm256_set1_ps( d.x );
+    __m256 dy = _mm256_set1_ps( d.y );
+    __m256 dz = _mm256_set1_ps( d.z );
+    __m256 ox = _mm256_set1_ps( o.x );
+    __m256 oy = _mm256_set1_ps( o.y );
+    __m256 oz = _mm256_set1_ps( o.z );
+    __m256 two = _mm256_set1_ps( 2.0f );
+    __m256 two_a = _mm256_set1_ps( 2 * A );
+    __m256 four_a = _mm256_set1_ps( 4 * A );
+    __m256 zero = _mm256_setzero_ps();
+    __m256 lanes = _mm256_setr_ps( 0, 1, 2, 3, 4, 5, 6, 7 );
+    __m256 minimums = _mm256_set1_ps( interval.m_Minimum );
+    __m256 eps = _mm256_set1_ps( epsilon );
+
+    for ( int i = 0; i < count; i += NR_SIMD_WIDTH )
+    {
+        int j = first + i - offset;
+
+        __m256 cox = _mm256_sub_ps( ox, _mm256_loadu_ps( m_SphereX + j ) );
+        __m256 coy = _mm256_sub_ps( oy, _mm256_loadu_ps( m_SphereY + j ) );
+        __m256 coz = _mm256_sub_ps( oz, _mm256_loadu_ps( m_SphereZ + j ) );
+
+        __m256 B = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dx, cox ), _mm256_mul_ps( dy, coy ) ), _mm256_mul_ps( dz, coz ) );
+        B = _mm256_mul_ps( two, B );
+        __m256 C = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( cox, cox ), _mm256_mul_ps( coy, coy ) ), _mm256_mul_ps( coz, coz ) );
+        C = _mm256_sub_ps( C, _mm256_loadu_ps( m_SphereR2 + j ) );
+        __m256 discriminant = _mm256_sub_ps( _mm256_mul_ps( B, B ), _mm256_mul_ps( four_a, C ) );
+
+        __m256 valid = _mm256_cmp_ps( lanes, _mm256_set1_ps( ( float )( count - i ) ), _CMP_LT_OQ );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( discriminant, eps, _CMP_GE_OQ ) );
+        if ( _mm256_movemask_ps( valid ) == 0 )
+        {
+            continue;
+        }
+
+        __m256 s = _mm256_sqrt_ps( _mm256_max_ps( discriminant, zero ) );
+        __m256 nb = _mm256_sub_ps( zero, B );
+        __m256 t0 = _mm256_div_ps( _mm256_sub_ps( nb, s ), two_a );
+        __m256 t1 = _mm256_div_ps( _mm256_add_ps( nb, s ), two_a );
+
+        __m256 maximums = _mm256_set1_ps( maximum );
+        __m256 in0 = _mm256_and_ps( _mm256_cmp_ps( t0, minimums, _CMP_GT_OQ ), _mm256_cmp_ps( t0, maximums, _CMP_LT_OQ ) );
+        __m256 in1 = _mm256_and_ps( _mm256_cmp_ps( t1, minimums, _CMP_GT_OQ ), _mm256_cmp_ps( t1, maximums, _CMP_LT_OQ ) );
+
+        int mask = _mm256_movemask_ps( _mm256_and_ps( valid, _mm256_or_ps( in0, in1 ) ) );
+        if ( mask == 0 )
+        {
+            continue;
+        }
+
+        float t[ NR_SIMD_WIDTH ];
+        _mm256_storeu_ps( t, _mm256_blendv_ps( t1, t0, in0 ) );
+
+        for ( int k = 0; k < NR_SIMD_WIDTH; k++ )
+        {
+            if ( ( mask & ( 1 << k ) ) && t[ k ] < maximum )
+            {
+                maximum = t[ k ];
+                closest = first + i + k;
+            }
+        }
+    }
+
+#else
+
+    for ( int i = first; i < first + count; i++ )
+    {
+        int j = i - offset;
+
+        float cox = o.x - m_SphereX[ j ];
+        float coy = o.y - m_SphereY[ j ];
+        float coz = o.z - m_SphereZ[ j ];
+
+        float B = 2 * ( d.x * cox + d.y * coy + d.z * coz );
+        float C = ( cox * cox + coy * coy + coz * coz ) - m_SphereR2[ j ];
+        float discriminant = B * B - 4 * A * C;
+
+        if ( discriminant >= epsilon )
+        {
+            float s = nrMath::Sqrt( discriminant );
+
+            float t = ( -B - s ) / ( 2 * A );
+            if ( t > interval.m_Minimum && t < maximum )
+            {
+                maximum = t;
+                closest = i;
+                continue;
+            }
+
+            t = ( -B + s ) / ( 2 * A );
+            if ( t > interval.m_Minimum && t < maximum )
+            {
+                maximum = t;
+                closest = i;
+            }
+        }
+    }
+
+#endif
+
+    if ( closest >= 0 )
+    {
+        ( ( const nrSurfaceSphere* )m_Surfaces[ closest ] )->Fill( hit, ray, maximum );
+        hit.m_ID = closest;
+        return true;
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline bool nrPrimitives::HitBoxes( int first, int count, const nrRay& ray, nrInterval& interval, nrHit& hit ) const
+{
+    assert( first % NR_SIMD_WIDTH == 0 );
+
+    const nrVector3& d = ray.d;
+    const nrVector3& o = ray.o;
+
+    // The same arithmetic as nrSurfaceBox::Hit(), one box per lane.  The
+    // near and far distances of each slab are swapped by the sign of the
+    // direction, which is the same for every box.
+    float dx = 1.0f / d.x;
+    float dy = 1.0f / d.y;
+    float dz = 1.0f / d.z;
+
+    int offset = m_Firsts[ nrSurface::TYPE_BOX ];
+
+    const float* near_x = d.x > 0 ? m_BoxX0 : m_BoxX1;
+    const float* far_x  = d.x > 0 ? m_BoxX1 : m_BoxX0;
+    const float* near_y = d.y > 0 ? m_BoxY0 : m_BoxY1;
+    const float* far_y  = d.y > 0 ? m_BoxY1 : m_BoxY0;
+    const float* near_z = d.z > 0 ? m_BoxZ0 : m_BoxZ1;
+    const float* far_z  = d.z > 0 ? m_BoxZ1 : m_BoxZ0;
+
+    float maximum = interval.m_Maximum;
+    int closest = -1;
+
+#ifdef NR_AVX2
+
+    __m256 ox = _mm256_set1_ps( o.x );
+    __m256 oy = _mm256_set1_ps( o.y );
+    __m256 oz = _mm256_set1_ps( o.z );
+    __m256 idx = _mm256_set1_ps( dx );
+    __m256 idy = _mm256_set1_ps( dy );
+    __m256 idz = _mm256_set1_ps( dz );
+    __m256 lanes = _mm256_setr_ps( 0, 1, 2, 3, 4, 5, 6, 7 );
+    __m256 minimums = _mm256_set1_ps( interval.m_Minimum );
+
+    for ( int i = 0; i < count; i += NR_SIMD_WIDTH )
+    {
+        int j = first + i - offset;
+
+        __m256 tnear = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( near_x + j ), ox ), idx );
+        __m256 tfar  = _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( far_x  + j ), ox ), idx );
+
+        tnear = _mm256_max_ps( tnear, _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( near_y + j ), oy ), idy ) );
+        tfar  = _mm256_min_ps( tfar,  _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( far_y  + j ), oy ), idy ) );
+
+        tnear = _mm256_max_ps( tnear, _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( near_z + j ), oz ), idz ) );
+        tfar  = _mm256_min_ps( tfar,  _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( far_z  + j ), oz ), idz ) );
+
+        __m256 valid = _mm256_cmp_ps( lanes, _mm256_set1_ps( ( float )( count - i ) ), _CMP_LT_OQ );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( tnear, tfar, _CMP_LT_OQ ) );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( tnear, minimums, _CMP_GT_OQ ) );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( tnear, _mm256_set1_ps( maximum ), _CMP_LT_OQ ) );
+
+        int mask = _mm256_movemask_ps( valid );
+        if ( mask == 0 )
+        {
+            continue;
+        }
+
+        float t[ NR_SIMD_WIDTH ];
+        _mm256_storeu_ps( t, tnear );
+
+        for ( int k = 0; k < NR_SIMD_WIDTH; k++ )
+        {
+            if ( ( mask & ( 1 << k ) ) && t[ k ] < maximum )
+            {
+                maximum = t[ k ];
+                closest = first + i + k;
+            }
+        }
+    }
+
+#else
+
+    for ( int i = first; i < first + count; i++ )
+    {
+        int j = i - offset;
+
+        float tnear = ( near_x[ j ] - o.x ) * dx;
+        float tfar  = ( far_x[ j ]  - o.x ) * dx;
+
+        float a = ( near_y[ j ] - o.y ) * dy;
+        float b = ( far_y[ j ]  - o.y ) * dy;
+        tnear = a > tnear ? a : tnear;
+        tfar  = b < tfar  ? b : tfar;
+
+        a = ( near_z[ j ] - o.z ) * dz;
+        b = ( far_z[ j ]  - o.z ) * dz;
+        tnear = a > tnear ? a : tnear;
+        tfar  = b < tfar  ? b : tfar;
+
+        if ( tnear < tfar && tnear > interval.m_Minimum && tnear < maximum )
+        {
+            maximum = tnear;
+            closest = i;
+        }
+    }
+
+#endif
+
+    if ( closest >= 0 )
+    {
+        ( ( const nrSurfaceBox* )m_Surfaces[ closest ] )->Fill( hit, ray, maximum );
+        hit.m_ID = closest;
+        return true;
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline bool nrPrimitives::HitTriangles( int first, int count, const nrRay& ray, nrInterval& interval, nrHit& hit ) const
+{
+    assert( first % NR_SIMD_WIDTH == 0 );
+
+    // The same arithmetic (and names) as nrSurfaceTriangle::Hit(), one
+    // triangle per lane.
+    float g = ray.d.x;
+    float h = ray.d.y;
+    float i = ray.d.z;
+
+    float maximum = interval.m_Maximum;
+    float closest_beta = 0.0f;
+    float closest_gamma = 0.0f;
+    int closest = -1;
+
+    int offset = m_Firsts[ nrSurface::TYPE_TRIANGLE ];
+
+#ifdef NR_AVX2
+
+    __m256 G = _mm256_set1_ps( g );
+    __m256 H = _mm256_set1_ps( h );
+    __m256 I = _mm256_set1_ps( i );
+    __m256 ox = _mm256_set1_ps( ray.o.x );
+    __m256 oy = _mm256_set1_ps( ray.o.y );
+    __m256 oz = _mm256_set1_ps( ray.o.z );
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps( 1.0f );
+    __m256 sign = _mm256_set1_ps( -0.0f );
+    __m256 lanes = _mm256_setr_ps( 0, 1, 2, 3, 4, 5, 6, 7 );
+    __m256 minimums = _mm256_set1_ps( interval.m_Minimum );
+
+    for ( int n = 0; n < count; n += NR_SIMD_WIDTH )
+    {
+        int s = first + n - offset;
+
+        __m256 a = _mm256_loadu_ps( m_TriangleABX + s );
+        __m256 b = _mm256_loadu_ps( m_TriangleABY + s );
+        __m256 c = _mm256_loadu_ps( m_TriangleABZ + s );
+        __m256 d = _mm256_loadu_ps( m_TriangleACX + s );
+        __m256 e = _mm256_loadu_ps( m_TriangleACY + s );
+        __m256 f = _mm256_loadu_ps( m_TriangleACZ + s );
+        __m256 j = _mm256_sub_ps( _mm256_loadu_ps( m_TriangleX + s ), ox );
+        __m256 k = _mm256_sub_ps( _mm256_loadu_ps( m_TriangleY + s ), oy );
+        __m256 l = _mm256_sub_ps( _mm256_loadu_ps( m_TriangleZ + s ), oz );
+
+        __m256 ei_minus_hf = _mm256_sub_ps( _mm256_mul_ps( e, I ), _mm256_mul_ps( H, f ) );
+        __m256 gf_minus_di = _mm256_sub_ps( _mm256_mul_ps( G, f ), _mm256_mul_ps( d, I ) );
+        __m256 dh_minus_eg = _mm256_sub_ps( _mm256_mul_ps( d, H ), _mm256_mul_ps( e, G ) );
+        __m256 ak_minus_jb = _mm256_sub_ps( _mm256_mul_ps( a, k ), _mm256_mul_ps( j, b ) );
+        __m256 jc_minus_al = _mm256_sub_ps( _mm256_mul_ps( j, c ), _mm256_mul_ps( a, l ) );
+        __m256 bl_minus_kc = _mm256_sub_ps( _mm256_mul_ps( b, l ), _mm256_mul_ps( k, c ) );
+
+        __m256 m = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( a, ei_minus_hf ), _mm256_mul_ps( b, gf_minus_di ) ), _mm256_mul_ps( c, dh_minus_eg ) );
+        m = _mm256_div_ps( one, m );
+
+        __m256 beta = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( j, ei_minus_hf ), _mm256_mul_ps( k, gf_minus_di ) ), _mm256_mul_ps( l, dh_minus_eg ) );
+        beta = _mm256_mul_ps( beta, m );
+
+        __m256 gamma = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( I, ak_minus_jb ), _mm256_mul_ps( H, jc_minus_al ) ), _mm256_mul_ps( G, bl_minus_kc ) );
+        gamma = _mm256_mul_ps( gamma, m );
+
+        __m256 t = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( f, ak_minus_jb ), _mm256_mul_ps( e, jc_minus_al ) ), _mm256_mul_ps( d, bl_minus_kc ) );
+        t = _mm256_mul_ps( _mm256_xor_ps( t, sign ), m );
+
+        __m256 valid = _mm256_cmp_ps( lanes, _mm256_set1_ps( ( float )( count - n ) ), _CMP_LT_OQ );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( beta, zero, _CMP_GE_OQ ) );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( gamma, zero, _CMP_GE_OQ ) );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( _mm256_add_ps( beta, gamma ), one, _CMP_LE_OQ ) );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( t, minimums, _CMP_GT_OQ ) );
+        valid = _mm256_and_ps( valid, _mm256_cmp_ps( t, _mm256_set1_ps( maximum ), _CMP_LT_OQ ) );
+
+        int mask = _mm256_movemask_ps( valid );
+        if ( mask == 0 )
+        {
+            continue;
+        }
+
+        float ts[ NR_SIMD_WIDTH ];
+        float betas[ NR_SIMD_WIDTH ];
+        float gammas[ NR_SIMD_WIDTH ];
+        _mm256_storeu_ps( ts, t );
+        _mm256_storeu_ps( betas, beta );
+        _mm256_storeu_ps( gammas, gamma );
+
+        for ( int q = 0; q < NR_SIMD_WIDTH; q++ )
+        {
+            if ( ( mask & ( 1 << q ) ) && ts[ q ] < maximum )
+            {
+                maximum = ts[ q ];
+                closest_beta = betas[ q ];
+                closest_gamma = gammas[ q ];
+                closest = first + n + q;
+            }
+        }
+    }
+
+#else
+
+    for ( int n = first; n < first + count; n++ )
+    {
+        int s = n - offset;
+
+        float a = m_TriangleABX[ s ];
+        float b = m_TriangleABY[ s ];
+        float c = m_TriangleABZ[ s ];
+        float d = m_TriangleACX[ s ];
+        float e = m_TriangleACY[ s ];
+        float f = m_TriangleACZ[ s ];
+        float j = m_TriangleX[ s ] - ray.o.x;
+        float k = m_TriangleY[ s ] - ray.o.y;
+        float l = m_TriangleZ[ s ] - ray.o.z;
+
+        float ei_minus_hf = e * i - h * f;
+        float gf_minus_di = g * f - d * i;
+        float dh_minus_eg = d * h - e * g;
+        float ak_minus_jb = a * k - j * b;
+        float jc_minus_al = j * c - a * l;
+        float bl_minus_kc = b * l - k * c;
+
+        float m = 1.0f / ( a * ei_minus_hf + b * gf_minus_di + c * dh_minus_eg );
+
+        float beta = ( j * ei_minus_hf + k * gf_minus_di + l * dh_minus_eg ) * m;
+
+        if ( beta >= 0 )
+        {
+            float gamma = ( i * ak_minus_jb + h * jc_minus_al + g * bl_minus_kc ) * m;
+
+            if ( gamma >= 0 && ( beta + gamma ) <= 1 )
+            {
+                float t = -( f * ak_minus_jb + e * jc_minus_al + d * bl_minus_kc ) * m;
+
+                if ( t > interval.m_Minimum && t < maximum )
+                {
+                    maximum = t;
+                    closest_beta = beta;
+                    closest_gamma = gamma;
+                    closest = n;
+                }
+            }
+        }
+    }
+
+#endif
+
+    if ( closest >= 0 )
+    {
+        ( ( const nrSurfaceTriangle* )m_Surfaces[ closest ] )->Fill( hit, maximum, closest_beta, closest_gamma );
+        hit.m_ID = closest;
+        return true;
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrPrimitives::Gather( nrArray< nrSurface* >& surfaces, nrArray< nrSurface* >& ordered, nrArray< int >& firsts, nrArray< int >& counts )
+{
+    assert( surfaces.Length() > 0 );
+
+    if ( surfaces.Length() <= NR_SIMD_WIDTH )
+    {
+        firsts.Add( ordered.Length() );
+        counts.Add( surfaces.Length() );
+
+        for ( int i = 0; i < surfaces.Length(); i++ )
+        {
+            ordered.Add( surfaces[ i ] );
+        }
+        for ( int p = surfaces.Length(); p < NR_SIMD_WIDTH; p++ )
+        {
+            ordered.Add( 0 );
+        }
+
+        return;
+    }
+
+    // Split the surfaces the same way the bounding volume hierarchy does,
+    // so each batch is spatially compact.
+    nrBound bound = Enclose( &surfaces[ 0 ], surfaces.Length() );
+    int split = nrSurfaceBVH::Split( surfaces, bound );
+
+    int num_left = split;
+    int num_right = surfaces.Length() - num_left;
+
+    nrArray< nrSurface* > left( num_left );
+    nrArray< nrSurface* > right( num_right );
+
+    for ( int l = 0; l < num_left; l++ )
+    {
+        left.Add( surfaces[ l ] );
+    }
+    for ( int r = 0; r < num_right; r++ )
+    {
+        right.Add( surfaces[ num_left + r ] );
+    }
+
+    Gather( left, ordered, firsts, counts );
+    Gather( right, ordered, firsts, counts );
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Static
+////////////////////////////////////////////////////////////////////////////
+
+nrPrimitives* nrPrimitives::Create( nrArray< nrSurface* >& surfaces, nrArena& arena )
+{
+    nrPrimitives* primitives = new nrPrimitives;
+    assert( primitives );
+
+    // Sort the surfaces by type.
+    nrArray< nrSurface* > typed[ nrSurface::TYPE_COUNT ];
+
+    for ( int i = 0; i < surfaces.Length(); i++ )
+    {
+        typed[ surfaces[ i ]->Type() ].Add( surfaces[ i ] );
+    }
+
+    // Group each type into spatially coherent batches, and lay the types
+    // out one after the other in ID order.
+    nrArray< nrSurface* > ordered;
+    nrArray< int > firsts[ nrSurface::TYPE_COUNT ];
+    nrArray< int > counts[ nrSurface::TYPE_COUNT ];
+
+    for ( int t = nrSurface::TYPE_SPHERE; t < nrSurface::TYPE_COUNT; t++ )
+    {
+        primitives->m_Firsts[ t ] = ordered.Length();
+        primitives->m_Counts[ t ] = typed[ t ].Length();
+
+        if ( typed[ t ].Length() > 0 )
+        {
+            Gather( typed[ t ], ordered, firsts[ t ], counts[ t ] );
+        }
+    }
+
+    // Fill the ID tables.  Padding slots are 0.
+    int n = ordered.Length();
+
+    primitives->m_NumIDs = n;
+    primitives->m_Surfaces = new nrSurface*[ n ];
+    primitives->m_Materials = new const nrMaterial*[ n ];
+
+    for ( int id = 0; id < n; id++ )
+    {
+        primitives->m_Surfaces[ id ] = ordered[ id ];
+        primitives->m_Materials[ id ] = ordered[ id ] ? ordered[ id ]->Material() : 0;
+    }
+
+    // Fill the structures of arrays.  Padding slots hold a degenerate
+    // primitive which is masked off by the batch counts anyway.
+    int num_spheres = primitives->m_Firsts[ nrSurface::TYPE_BOX ] - primitives->m_Firsts[ nrSurface::TYPE_SPHERE ];
+
+    if ( num_spheres > 0 )
+    {
+        primitives->m_SphereX = new float[ num_spheres ];
+        primitives->m_SphereY = new float[ num_spheres ];
+        primitives->m_SphereZ = new float[ num_spheres ];
+        primitives->m_SphereR2 = new float[ num_spheres ];
+
+        for ( int s = 0; s < num_spheres; s++ )
+        {
+            const nrSurfaceSphere* sphere = ( const nrSurfaceSphere* )ordered[ primitives->m_Firsts[ nrSurface::TYPE_SPHERE ] + s ];
+
+            nrVector3 center = sphere ? sphere->Center() : nrVector3( 0, 0, 0 );
+            float radius = sphere ? sphere->Radius() : 0.0f;
+
+            primitives->m_SphereX[ s ] = center.x;
+            primitives->m_SphereY[ s ] = center.y;
+            primitives->m_SphereZ[ s ] = center.z;
+            primitives->m_SphereR2[ s ] = radius * radius;
+        }
+    }
+
+    int num_boxes = primitives->m_Firsts[ nrSurface::TYPE_TRIANGLE ] - primitives->m_Firsts[ nrSurface::TYPE_BOX ];
+
+    if ( num_boxes > 0 )
+    {
+        primitives->m_BoxX0 = new float[ num_boxes ];
+        primitives->m_BoxY0 = new float[ num_boxes ];
+        primitives->m_BoxZ0 = new float[ num_boxes ];
+        primitives->m_BoxX1 = new float[ num_boxes ];
+        primitives->m_BoxY1 = new float[ num_boxes ];
+        primitives->m_BoxZ1 = new float[ num_boxes ];
+
+        for ( int b = 0; b < num_boxes; b++ )
+        {
+            const nrSurfaceBox* box = ( const nrSurfaceBox* )ordered[ primitives->m_Firsts[ nrSurface::TYPE_BOX ] + b ];
+
+            nrVector3 p0 = box ? box->m_P0 : nrVector3( 0, 0, 0 );
+            nrVector3 p1 = box ? box->m_P1 : nrVector3( 0, 0, 0 );
+
+            primitives->m_BoxX0[ b ] = p0.x;
+            primitives->m_BoxY0[ b ] = p0.y;
+            primitives->m_BoxZ0[ b ] = p0.z;
+            primitives->m_BoxX1[ b ] = p1.x;
+            primitives->m_BoxY1[ b ] = p1.y;
+            primitives->m_BoxZ1[ b ] = p1.z;
+        }
+    }
+
+    int num_triangles = n - primitives->m_Firsts[ nrSurface::TYPE_TRIANGLE ];
+
+    if ( num_triangles > 0 )
+    {
+        primitives->m_TriangleX = new float[ num_triangles ];
+        primitives->m_TriangleY = new float[ num_triangles ];
+        primitives->m_TriangleZ = new float[ num_triangles ];
+        primitives->m_TriangleABX = new float[ num_triangles ];
+        primitives->m_TriangleABY = new float[ num_triangles ];
+        primitives->m_TriangleABZ = new float[ num_triangles ];
+        primitives->m_TriangleACX = new float[ num_triangles ];
+        primitives->m_TriangleACY = new float[ num_triangles ];
+        primitives->m_TriangleACZ = new float[ num_triangles ];
+
+        for ( int r = 0; r < num_triangles; r++ )
+        {
+            const nrSurfaceTriangle* triangle = ( const nrSurfaceTriangle* )ordered[ primitives->m_Firsts[ nrSurface::TYPE_TRIANGLE ] + r ];
+
+            nrVector3 a = triangle ? triangle->A() : nrVector3( 0, 0, 0 );
+            nrVector3 b = triangle ? triangle->B() : nrVector3( 0, 0, 0 );
+            nrVector3 c = triangle ? triangle->C() : nrVector3( 0, 0, 0 );
+
+            primitives->m_TriangleX[ r ] = a.x;
+            primitives->m_TriangleY[ r ] = a.y;
+            primitives->m_TriangleZ[ r ] = a.z;
+            primitives->m_TriangleABX[ r ] = a.x - b.x;
+            primitives->m_TriangleABY[ r ] = a.y - b.y;
+            primitives->m_TriangleABZ[ r ] = a.z - b.z;
+            primitives->m_TriangleACX[ r ] = a.x - c.x;
+            primitives->m_TriangleACY[ r ] = a.y - c.y;
+            primitives->m_TriangleACZ[ r ] = a.z - c.z;
+        }
+    }
+
+    // Replace the batched surfaces with leaves that refer to the batches.
+    surfaces.Clear();
+
+    for ( int type = nrSurface::TYPE_SPHERE; type < nrSurface::TYPE_COUNT; type++ )
+    {
+        for ( int j = 0; j < firsts[ type ].Length(); j++ )
+        {
+            int first = firsts[ type ][ j ];
+            int count = counts[ type ][ j ];
+
+            nrBound bound = Enclose( primitives->m_Surfaces + first, count );
+            surfaces.Add( new ( arena ) nrSurfaceBatch( primitives, ( nrSurface::nrType )type, first, count, bound ) );
+        }
+    }
+
+    for ( int k = 0; k < typed[ nrSurface::TYPE_OTHER ].Length(); k++ )
+    {
+        surfaces.Add( typed[ nrSurface::TYPE_OTHER ][ k ] );
+    }
+
+    surfaces.Compress();
+
+    return primitives;
+}
+
+////////////////////////////////////////////////////////////////////////////
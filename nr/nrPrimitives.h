@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrPrimitives.h
+//
+// A class for primitives sorted by type and stored as structures of
+// arrays.
+//
+// The spheres, boxes and triangles of a scene are gathered by type into
+// spatially coherent batches of up to NR_SIMD_WIDTH primitives.  Every
+// primitive gets a compact integer ID; the IDs of each type are
+// contiguous, and a batch is a range of IDs of a single type.  The
+// geometry of each type is kept in separate float arrays, so a whole
+// batch can be intersected at once (with AVX2 if available, see nrSimd.h)
+// and the type is only dispatched on once per batch, not once per
+// primitive.  Each batch is handed to the accelerators as an
+// nrSurfaceBatch leaf.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRPRIMITIVES_H
+#define NRPRIMITIVES_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrArray.h"
+#include "nrSurface.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrArena;
+class nrHit;
+class nrInterval;
+class nrMaterial;
+class nrRay;
+
+////////////////////////////////////////////////////////////////////////////
+
+class nrPrimitives
+{
+public:
+
+    ~nrPrimitives( void );
+
+    // Return true if the ray hit any of the primitives with IDs in
+    // [first, first + count), false otherwise.  All of the primitives in
+    // the range must be of the given type.  The closest hit is returned.
+    bool Hit( nrSurface::nrType type, int first, int count, const nrRay& ray, nrInterval& interval, nrHit& hit ) const;
+
+    // Return the type of a primitive.
+    nrSurface::nrType Type( int id ) const;
+
+    // Return the surface a primitive was created from.
+    const nrSurface* Surface( int id ) const;
+
+    // Return the material of a primitive.
+    const nrMaterial* Material( int id ) const;
+
+    // Return the normal to a primitive at the point (on the primitive).
+    nrVector3 Normal( int id, const nrVector3& point ) const;
+
+    // Return the number of primitives of a type.
+    int Count( nrSurface::nrType type ) const;
+
+    // Gather the spheres, boxes and triangles in the surfaces array into
+    // batches.
+    //
+    // The surfaces array is rebuilt to contain an nrSurfaceBatch leaf for
+    // each batch, followed by the surfaces which could not be batched.
+    // The leaves are allocated from the arena (which holds the surfaces
+    // as well).
+    static nrPrimitives* Create( nrArray< nrSurface* >& surfaces, nrArena& arena );
+
+private:
+
+    nrPrimitives( void );
+
+    // Intersect a range of primitives of a single type.
+    inline bool HitSpheres( int first, int count, const nrRay& ray, nrInterval& interval, nrHit& hit ) const;
+    inline bool HitBoxes( int first, int count, const nrRay& ray, nrInterval& interval, nrHit& hit ) const;
+    inline bool HitTriangles( int first, int count, const nrRay& ray, nrInterval& interval, nrHit& hit ) const;
+
+    // Append the surfaces to the ordered array in spatially coherent
+    // groups of at most NR_SIMD_WIDTH, each padded out to NR_SIMD_WIDTH
+    // with empty (0) slots.  The range of each group is recorded.
+    static void Gather( nrArray< nrSurface* >& surfaces, nrArray< nrSurface* >& ordered, nrArray< int >& firsts, nrArray< int >& counts );
+
+private:
+
+    // Number of primitives of each type, and the first ID of each type.
+    int                m_Counts[ nrSurface::TYPE_COUNT ];
+    int                m_Firsts[ nrSurface::TYPE_COUNT ];
+
+    // Indexed by ID (including the padding, which is 0).
+    int                m_NumIDs;
+    nrSurface**        m_Surfaces;
+    const nrMaterial** m_Materials;
+
+    // Indexed by ID - m_Firsts[ TYPE_SPHERE ].
+    float*             m_SphereX;
+    float*             m_SphereY;
+    float*             m_SphereZ;
+    float*             m_SphereR2;
+
+    // Indexed by ID - m_Firsts[ TYPE_BOX ].
+    float*             m_BoxX0;
+    float*             m_BoxY0;
+    float*             m_BoxZ0;
+    float*             m_BoxX1;
+    float*             m_BoxY1;
+    float*             m_BoxZ1;
+
+    // Indexed by ID - m_Firsts[ TYPE_TRIANGLE ].  The vertex A, and the
+    // edges A - B and A - C.
+    float*             m_TriangleX;
+    float*             m_TriangleY;
+    float*             m_TriangleZ;
+    float*             m_TriangleABX;
+    float*             m_TriangleABY;
+    float*             m_TriangleABZ;
+    float*             m_TriangleACX;
+    float*             m_TriangleACY;
+    float*             m_TriangleACZ;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRPRIMITIVES_H
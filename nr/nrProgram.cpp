@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrProgram.cpp
+//
+// A class for channel programs (the channels of a material compiled into
+// a flat list of instructions, evaluated over batches of points).
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrProgram.h"
+
+#include "nrChannel.h"
+#include "nrChannelMarble.h"
+#include "nrColorRamp.h"
+#include "nrVector3.h"
+
+#include <assert.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrProgram::~nrProgram( void )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrProgram::Run( const float* x, const float* y, const float* z, const float* footprint, int count,
+                     nrColor* ambient, nrColor* diffuse, nrColor* specular ) const
+{
+    assert( count <= NR_PROGRAM_BATCH );
+
+    float r[ NR_PROGRAM_REGISTERS ][ NR_PROGRAM_BATCH ];
+
+    for ( int i = 0; i < m_Instructions.Length(); i++ )
+    {
+        const nrInstruction& instruction = m_Instructions[ i ];
+
+        float* d = r[ instruction.destination ];
+
+        switch ( instruction.opcode )
+        {
+        case OP_CONSTANT:
+            {
+                for ( int j = 0; j < count; j++ )
+                {
+                    d[ j ] = instruction.color.r;
+                    d[ j + NR_PROGRAM_BATCH ] = instruction.color.g;
+                    d[ j + NR_PROGRAM_BATCH * 2 ] = instruction.color.b;
+                }
+            }
+            break;
+
+        case OP_MARBLE:
+            {
+                const nrChannelMarble* channel = ( const nrChannelMarble* )instruction.data;
+                channel->Marble( x, y, z, footprint, count, d );
+            }
+            break;
+
+        case OP_RAMP:
+            {
+                const nrColorRamp* ramp = ( const nrColorRamp* )instruction.data;
+
+                ramp->Color( r[ instruction.source ], count, d, d + NR_PROGRAM_BATCH, d + NR_PROGRAM_BATCH * 2 );
+            }
+            break;
+
+        case OP_GRAY:
+            {
+                const float* s = r[ instruction.source ];
+
+                for ( int j = 0; j < count; j++ )
+                {
+                    d[ j ] = s[ j ];
+                    d[ j + NR_PROGRAM_BATCH ] = s[ j ];
+                    d[ j + NR_PROGRAM_BATCH * 2 ] = s[ j ];
+                }
+            }
+            break;
+
+        case OP_CHANNEL:
+            {
+                const nrChannel* channel = ( const nrChannel* )instruction.data;
+
+                for ( int j = 0; j < count; j++ )
+                {
+                    nrColor c = channel->Color( nrVector3( x[ j ], y[ j ], z[ j ] ), footprint[ j ] );
+
+                    d[ j ] = c.r;
+                    d[ j + NR_PROGRAM_BATCH ] = c.g;
+                    d[ j + NR_PROGRAM_BATCH * 2 ] = c.b;
+                }
+            }
+            break;
+        }
+    }
+
+    // Write out the colors.
+    nrColor* colors[ 3 ] = { ambient, diffuse, specular };
+
+    for ( int k = 0; k < 3; k++ )
+    {
+        const float* s = r[ m_Outputs[ k ] ];
+
+        for ( int j = 0; j < count; j++ )
+        {
+            colors[ k ][ j ] = nrColor( s[ j ], s[ j + NR_PROGRAM_BATCH ], s[ j + NR_PROGRAM_BATCH * 2 ] );
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrProgram::Constant( const nrColor& color )
+{
+    nrInstruction instruction;
+    instruction.opcode = OP_CONSTANT;
+    instruction.destination = Allocate( 3 );
+    instruction.source = -1;
+    instruction.data = 0;
+    instruction.color = color;
+
+    if ( instruction.destination < 0 )
+    {
+        return -1;
+    }
+
+    m_Instructions.Add( instruction );
+
+    return instruction.destination;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrProgram::Marble( const nrChannelMarble* channel )
+{
+    nrInstruction instruction;
+    instruction.opcode = OP_MARBLE;
+    instruction.destination = Allocate( 1 );
+    instruction.source = -1;
+    instruction.data = channel;
+
+    if ( instruction.destination < 0 )
+    {
+        return -1;
+    }
+
+    m_Instructions.Add( instruction );
+
+    return instruction.destination;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrProgram::Ramp( const nrColorRamp* ramp, int value )
+{
+    nrInstruction instruction;
+    instruction.opcode = OP_RAMP;
+    instruction.destination = Allocate( 3 );
+    instruction.source = value;
+    instruction.data = ramp;
+
+    if ( instruction.destination < 0 || value < 0 )
+    {
+        return -1;
+    }
+
+    m_Instructions.Add( instruction );
+
+    return instruction.destination;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrProgram::Gray( int value )
+{
+    nrInstruction instruction;
+    instruction.opcode = OP_GRAY;
+    instruction.destination = Allocate( 3 );
+    instruction.source = value;
+    instruction.data = 0;
+
+    if ( instruction.destination < 0 || value < 0 )
+    {
+        return -1;
+    }
+
+    m_Instructions.Add( instruction );
+
+    return instruction.destination;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrProgram::Channel( const nrChannel* channel )
+{
+    nrInstruction instruction;
+    instruction.opcode = OP_CHANNEL;
+    instruction.destination = Allocate( 3 );
+    instruction.source = -1;
+    instruction.data = channel;
+
+    if ( instruction.destination < 0 )
+    {
+        return -1;
+    }
+
+    m_Instructions.Add( instruction );
+
+    return instruction.destination;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrProgram::Length( void ) const
+{
+    return m_Instructions.Length();
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrProgram* nrProgram::Create( const nrChannel* ambient, const nrChannel* diffuse, const nrChannel* specular )
+{
+    nrProgram* program = new nrProgram;
+
+    // The defaults are the same as nrMaterial's.
+    program->m_Outputs[ 0 ] = program->Compile( ambient,  nrColor( 0, 0, 0 ) );
+    program->m_Outputs[ 1 ] = program->Compile( diffuse,  nrColor( 1, 1, 1 ) );
+    program->m_Outputs[ 2 ] = program->Compile( specular, nrColor( 0, 0, 0 ) );
+
+    if ( program->m_Outputs[ 0 ] < 0 || program->m_Outputs[ 1 ] < 0 || program->m_Outputs[ 2 ] < 0 )
+    {
+        delete program;
+        return 0;
+    }
+
+    // Only the compiler needs these.
+    program->m_Channels.Clear();
+    program->m_Registers.Clear();
+
+    return program;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+nrProgram::nrProgram( void )
+{
+    m_NumRegisters = 0;
+    m_Outputs[ 0 ] = m_Outputs[ 1 ] = m_Outputs[ 2 ] = -1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrProgram::Compile( const nrChannel* channel, const nrColor& color )
+{
+    if ( channel == 0 )
+    {
+        return Constant( color );
+    }
+
+    for ( int i = 0; i < m_Channels.Length(); i++ )
+    {
+        if ( m_Channels[ i ] == channel )
+        {
+            return m_Registers[ i ];
+        }
+    }
+
+    int r = channel->Compile( *this );
+
+    m_Channels.Add( channel );
+    m_Registers.Add( r );
+
+    return r;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrProgram::Allocate( int count )
+{
+    if ( m_NumRegisters + count > NR_PROGRAM_REGISTERS )
+    {
+        return -1;
+    }
+
+    int r = m_NumRegisters;
+    m_NumRegisters += count;
+
+    return r;
+}
+
+////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrProgram.h
+//
+// A class for channel programs (the channels of a material compiled into
+// a flat list of instructions, evaluated over batches of points).
+//
+// The channels of a material form a (small) tree of nrChannel objects,
+// which would otherwise be evaluated one point at a time through virtual
+// calls.  A program flattens the tree into instructions over registers,
+// each of which holds one float for every point of a batch (a structure
+// of arrays).  Running a program dispatches on each instruction once per
+// batch, and the instructions themselves are tight loops over the batch
+// (with SIMD where the channel has a batched kernel, see
+// nrChannelMarble::Marble()).  Channels with no instruction of their own
+// are evaluated a point at a time by a generic instruction.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRPROGRAM_H
+#define NRPROGRAM_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrArray.h"
+#include "nrColor.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// Largest number of points a program is run over at once.  A multiple of
+// NR_SIMD_WIDTH.
+#define NR_PROGRAM_BATCH 64
+
+// Number of (float) registers a program may use.  A color takes three.
+#define NR_PROGRAM_REGISTERS 32
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrChannel;
+class nrChannelMarble;
+class nrColorRamp;
+
+////////////////////////////////////////////////////////////////////////////
+
+class nrProgram
+{
+public:
+
+    ~nrProgram( void );
+
+    // Run the program over a batch of count (at most NR_PROGRAM_BATCH)
+    // points with the given footprints (see nrChannel::Color()), and
+    // return the ambient, diffuse and specular colors at each point.
+    void Run( const float* x, const float* y, const float* z, const float* footprint, int count,
+              nrColor* ambient, nrColor* diffuse, nrColor* specular ) const;
+
+    // Emit an instruction, and return the (first) register it writes to,
+    // or -1 if the program has run out of registers.  These are called
+    // by the channels as they are compiled (see nrChannel::Compile()).
+    int Constant( const nrColor& color );
+    int Marble( const nrChannelMarble* channel );
+    int Ramp( const nrColorRamp* ramp, int value );
+    int Gray( int value );
+    int Channel( const nrChannel* channel );
+
+    // Return the number of instructions in the program.
+    int Length( void ) const;
+
+    // Return a new program which computes the ambient, diffuse and
+    // specular colors of a material with the given channels (any of
+    // which may be 0, for the default color), or 0 if the channels can't
+    // be compiled.  A channel used more than once is only compiled (and
+    // run) once.
+    static nrProgram* Create( const nrChannel* ambient, const nrChannel* diffuse, const nrChannel* specular );
+
+private:
+
+    nrProgram( void );
+
+    // Return the register holding the color of a channel, compiling it
+    // if it hasn't been already (or the default color if there is no
+    // channel), or -1 if the program has run out of registers.
+    int Compile( const nrChannel* channel, const nrColor& color );
+
+    // Allocate registers, and return the first one (or -1).
+    int Allocate( int count );
+
+private:
+
+    typedef enum
+    {
+        OP_CONSTANT,    // destination = color (3 registers)
+        OP_MARBLE,      // destination = marble (before the ramp)
+        OP_RAMP,        // destination = ramp( source ) (3 registers)
+        OP_GRAY,        // destination = source, source, source
+        OP_CHANNEL      // destination = channel( point ) (3 registers)
+    } nrOpcode;
+
+    typedef struct
+    {
+        nrOpcode    opcode;
+        int         destination;
+        int         source;
+        const void* data;
+        nrColor     color;
+    } nrInstruction;
+
+    nrArray< nrInstruction > m_Instructions;
+    int                      m_NumRegisters;
+
+    // The registers holding the ambient, diffuse and specular colors.
+    int                      m_Outputs[ 3 ];
+
+    // The channels compiled so far, and their registers.
+    nrArray< const nrChannel* > m_Channels;
+    nrArray< int >              m_Registers;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRPROGRAM_H
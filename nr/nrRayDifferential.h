@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrRayDifferential.h
+//
+// A class for ray differentials.
+//
+// The differentials are the rates of change of a ray's origin and 
+// direction with respect to the image plane (x and y, in pixels).
+// Carried to a hit, they give the footprint of a pixel on the surface,
+// which tells shading how much detail a pixel can show (see Igehy, 
+// "Tracing Ray Differentials", SIGGRAPH 1999).
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRRAYDIFFERENTIAL_H
+#define NRRAYDIFFERENTIAL_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrVector3.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrRay;
+
+////////////////////////////////////////////////////////////////////////////
+
+class nrRayDifferential
+{
+public:
+    
+    inline nrRayDifferential( void );
+    inline nrRayDifferential( const nrVector3& dDdx, const nrVector3& dDdy );
+    
+    // Return the width of the footprint of a pixel on the surface hit by
+    // the ray at distance t, with the given (geometric) normal.  The
+    // point is transferred to the plane of the hit, so the footprint 
+    // stretches out on surfaces seen at grazing angles.
+    inline float Footprint( const nrRay& ray, float t, const nrVector3& normal ) const;
+    
+public:
+    
+    nrVector3 m_dOdx;   // Origin (0 for a pinhole camera).
+    nrVector3 m_dOdy;
+    nrVector3 m_dDdx;   // Direction.
+    nrVector3 m_dDdy;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrRayDifferential.inl"
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRRAYDIFFERENTIAL_H
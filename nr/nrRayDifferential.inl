@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrRayDifferential.inl
+//
+// A class for ray differentials.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrRayDifferential.h"
+
+#include "nrMath.h"
+#include "nrRay.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+inline nrRayDifferential::nrRayDifferential( void )
+{
+    m_dOdx = nrVector3( 0, 0, 0 );
+    m_dOdy = nrVector3( 0, 0, 0 );
+    m_dDdx = nrVector3( 0, 0, 0 );
+    m_dDdy = nrVector3( 0, 0, 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline nrRayDifferential::nrRayDifferential( const nrVector3& dDdx, const nrVector3& dDdy )
+{
+    m_dOdx = nrVector3( 0, 0, 0 );
+    m_dOdy = nrVector3( 0, 0, 0 );
+    m_dDdx = dDdx;
+    m_dDdy = dDdy;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrRayDifferential::Footprint( const nrRay& ray, float t, const nrVector3& normal ) const
+{
+    float dn = ray.d.Dot( normal );
+    if ( dn == 0.0f )
+    {
+        return 0.0f;
+    }
+    
+    // Transfer the differentials to the hit: move along the ray to t, 
+    // then slide along the ray onto the tangent plane of the hit.
+    nrVector3 px = m_dOdx + m_dDdx * t;
+    nrVector3 py = m_dOdy + m_dDdy * t;
+    
+    nrVector3 dPdx = px - ray.d * ( px.Dot( normal ) / dn );
+    nrVector3 dPdy = py - ray.d * ( py.Dot( normal ) / dn );
+    
+    return nrMath::Sqrt( nrMath::Max( dPdx.Dot( dPdx ), dPdy.Dot( dPdy ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSampler.h
+//
+// A class for sample sequences.
+//
+// A sampler belongs to a pixel (and a seed, to tell apart several sets of
+// samples in the same pixel), and everything it returns is a function of
+// the pixel, the seed and the arguments alone.  There is no shared state
+// (unlike nrMath::Random_f(), which is rand()), so samplers may be used
+// from any number of threads, and the samples of a pixel don't depend on
+// which thread traces it or in what order.
+//
+// The sequences are the 2D Sobol sequence, scrambled per pixel with a
+// nested uniform (Owen) scramble (see Burley, "Practical Hash-based Owen
+// Scrambling", JCGT 2020), so that the first 4^n points of a pixel are
+// stratified in each of its 2^n x 2^n cells; and a blue noise dither (the
+// R2 sequence over the pixels, see Roberts, "The Unreasonable
+// Effectiveness of Quasirandom Sequences", 2018), which differs as much
+// as possible between neighboring pixels.  Each use of the samples in a
+// pixel (anti-aliasing, the lens, area lights) takes its own dimension,
+// which is scrambled independently of the others.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRSAMPLER_H
+#define NRSAMPLER_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrSampler
+{
+public:
+
+    typedef enum
+    {
+        DIMENSION_PIXEL,    // Position within the pixel.
+        DIMENSION_LENS,     // Position on the lens (depth of field).
+        DIMENSION_LIGHT     // Position on an area light (soft shadows).
+    } nrDimension;
+
+    inline nrSampler( int x, int y, unsigned int seed = 0 );
+    inline ~nrSampler( void );
+
+    // Return the index-th point of the scrambled Sobol sequence for the
+    // dimension, in [ 0, 1 ) x [ 0, 1 ).
+    inline void Sobol( unsigned int index, int dimension, float& u, float& v ) const;
+
+    // Return the blue noise dither of the pixel for the dimension, in
+    // [ 0, 1 ).
+    inline float BlueNoise( int dimension ) const;
+
+    // Return a uniformly distributed random number in [ 0, 1 ) for the
+    // index and dimension.
+    inline float Random( unsigned int index, int dimension ) const;
+
+    // Return a well mixed hash of x.
+    inline static unsigned int Hash( unsigned int x );
+
+private:
+
+    // Return the bits of x in reverse order.
+    inline static unsigned int Reverse( unsigned int x );
+
+    // Return x (reversed, as a fraction) with a nested uniform scramble.
+    inline static unsigned int Scramble( unsigned int x, unsigned int seed );
+
+    // Return 32 bits as a float in [ 0, 1 ).
+    inline static float Float( unsigned int x );
+
+private:
+
+    int          m_X;
+    int          m_Y;
+    unsigned int m_Seed;
+    unsigned int m_Scramble;    // Hash of the pixel and the seed.
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSampler.inl"
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRSAMPLER_H
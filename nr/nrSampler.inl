@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSampler.inl
+//
+// A class for sample sequences.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSampler.h"
+
+#include <math.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// The R2 sequence: 1 / g and 1 / g^2, where g is the plastic number.
+#define NR_SAMPLER_R2_X 0.7548776662466927
+#define NR_SAMPLER_R2_Y 0.5698402909980532
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+inline nrSampler::nrSampler( int x, int y, unsigned int seed )
+{
+    m_X = x;
+    m_Y = y;
+    m_Seed = seed;
+    m_Scramble = Hash( ( unsigned int )x ^ Hash( ( unsigned int )y ^ Hash( seed ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline nrSampler::~nrSampler( void )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline void nrSampler::Sobol( unsigned int index, int dimension, float& u, float& v ) const
+{
+    unsigned int seed = Hash( m_Scramble ^ Hash( ( unsigned int )dimension ) );
+
+    // The first dimension of the Sobol sequence is the van der Corput
+    // sequence (the index reversed), and the second is built up from its
+    // direction numbers, which are 1 / 2, then each is the previous one
+    // xor itself / 2.
+    unsigned int x = Reverse( index );
+    unsigned int y = 0;
+
+    for ( unsigned int d = 1u << 31; index != 0; index >>= 1, d ^= d >> 1 )
+    {
+        if ( index & 1 )
+        {
+            y ^= d;
+        }
+    }
+
+    u = Float( Scramble( x, seed ) );
+    v = Float( Scramble( y, Hash( seed ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrSampler::BlueNoise( int dimension ) const
+{
+    // Every pixel is shifted by the same amount, which keeps the dither
+    // blue.
+    double shift = Float( Hash( m_Seed ^ Hash( ( unsigned int )dimension ) ) );
+    double r = 0.5 + shift + NR_SAMPLER_R2_X * m_X + NR_SAMPLER_R2_Y * m_Y;
+
+    return ( float )( r - floor( r ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrSampler::Random( unsigned int index, int dimension ) const
+{
+    return Float( Hash( m_Scramble ^ Hash( index ^ Hash( ( unsigned int )dimension + 0x9e3779b9 ) ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline unsigned int nrSampler::Hash( unsigned int x )
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+
+    return x;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+inline unsigned int nrSampler::Reverse( unsigned int x )
+{
+    x = ( ( x >> 1 ) & 0x55555555 ) | ( ( x & 0x55555555 ) << 1 );
+    x = ( ( x >> 2 ) & 0x33333333 ) | ( ( x & 0x33333333 ) << 2 );
+    x = ( ( x >> 4 ) & 0x0f0f0f0f ) | ( ( x & 0x0f0f0f0f ) << 4 );
+    x = ( ( x >> 8 ) & 0x00ff00ff ) | ( ( x & 0x00ff00ff ) << 8 );
+    x = ( x >> 16 ) | ( x << 16 );
+
+    return x;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline unsigned int nrSampler::Scramble( unsigned int x, unsigned int seed )
+{
+    // The Laine-Karras permutation flips each bit depending only on the
+    // bits below it, so on the reversed fraction it flips each digit
+    // depending only on the digits above it, which is an Owen scramble.
+    x = Reverse( x );
+
+    x += seed;
+    x ^= x * 0x6c50b47c;
+    x ^= x * 0xb82f1e52;
+    x ^= x * 0xc7afe638;
+    x ^= x * 0x8d22f6e6;
+
+    return Reverse( x );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrSampler::Float( unsigned int x )
+{
+    // The top 24 bits, so the result rounds to less than 1.
+    return ( float )( x >> 8 ) * ( 1.0f / 16777216.0f );
+}
+
+////////////////////////////////////////////////////////////////////////////
@@ -14,18 +14,24 @@
 
 #include "nrScene.h"
 
+#include "nrBound.h"
+#include "nrChannelColor.h"
 #include "nrHit.h"
 #include "nrInterval.h"
 #include "nrLight.h"
 #include "nrList.h"
 #include "nrLog.h"
+#include "nrMaterial.h"
+#include "nrMath.h"
 #include "nrParser.h"
+#include "nrPrimitives.h"
 #include "nrRay.h"
 #include "nrSurface.h"
 #include "nrSurfaceBox.h"
 #include "nrSurfaceBVH.h"
 #include "nrSurfaceRGS.h"
 #include "nrSurfaceSphere.h"
+#include "nrSurfaceTBVH.h"
 #include "nrSurfaceTriangle.h"
 #include "nrVector3.h"
 #include "nrView.h"
@@ -43,6 +49,8 @@ nrScene::nrScene( void )
 {
     m_BVH = 0;
     m_RGS = 0;
+    m_TBVH = 0;
+    m_Primitives = 0;
     m_Cull = true;
     m_Ambient = nrColor( 0, 0, 0 );
     m_Background = nrColor( 0, 0, 0 );
@@ -54,30 +62,10 @@ nrScene::nrScene( void )
 
 nrScene::~nrScene( void )
 {
-    if ( m_BVH )
-    {
-        delete m_BVH;
-    }
-    else if ( m_RGS )
-    {
-        delete m_RGS;
-
-        for ( int i = 0; i < m_Surfaces.Length(); i++ )
-        {
-            nrSurface* surface = m_Surfaces[ i ];
-            
-            delete surface;
-        }
-    }
-    else
-    {
-        for ( int i = 0; i < m_Surfaces.Length(); i++ )
-        {
-            nrSurface* surface = m_Surfaces[ i ];
-            
-            delete surface;
-        }
-    }
+    // None of these own the surfaces.
+    delete m_TBVH;
+    delete m_RGS;
+    delete m_Primitives;
     
     for ( int i = 0; i < m_Lights.Length(); i++ )
     {
@@ -85,6 +73,10 @@ nrScene::~nrScene( void )
     }
     
     delete m_View;
+    
+    // The surfaces, the batch leaves and the hierarchy nodes all go at
+    // once.  The materials are interned, and outlive the scene.
+    m_Arena.Release();
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -128,6 +120,23 @@ bool nrScene::Hit( const nrRay& ray, nrInterval& interval, nrHit& hit ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
+bool nrScene::Occluded( const nrRay& ray, const nrInterval& interval ) const
+{
+    if ( m_TBVH != 0 )
+    {
+        return m_TBVH->Occluded( ray, interval );
+    }
+    else
+    {
+        nrInterval span = interval;
+        nrHit hit;
+        
+        return Hit( ray, span, hit );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 bool nrScene::Parse( const char* scene_file )
 {
     int num_spheres = 0;
@@ -149,7 +158,7 @@ bool nrScene::Parse( const char* scene_file )
         
         if ( parser.KeyMatches( key, "sphere" ) )
         {
-            nrSurfaceSphere* s = nrSurfaceSphere::Parse( parser );
+            nrSurfaceSphere* s = nrSurfaceSphere::Parse( parser, m_Arena );
             if ( s == 0 )
             {
                 parser.ParseError( "malformed sphere key" );
@@ -163,7 +172,7 @@ bool nrScene::Parse( const char* scene_file )
         }
         else if ( parser.KeyMatches( key, "box" ) )
         {
-            nrSurfaceBox* s = nrSurfaceBox::Parse( parser );
+            nrSurfaceBox* s = nrSurfaceBox::Parse( parser, m_Arena );
             if ( s == 0 )
             {
                 parser.ParseError( "malformed box key" );
@@ -177,7 +186,7 @@ bool nrScene::Parse( const char* scene_file )
         }
         else if ( parser.KeyMatches( key, "triangle" ) )
         {
-            nrSurfaceTriangle* s = nrSurfaceTriangle::Parse( parser );
+            nrSurfaceTriangle* s = nrSurfaceTriangle::Parse( parser, m_Arena );
             if ( s == 0 )
             {
                 parser.ParseError( "malformed triangle key" );
@@ -193,7 +202,7 @@ bool nrScene::Parse( const char* scene_file )
                     }
                     else
                     {
-                        delete s;
+                        m_Arena.Free( s );
                         num_culled++;
                     }
                 }
@@ -288,19 +297,45 @@ bool nrScene::Parse( const char* scene_file )
         g_Log.Write( "%4d box%s.\n", num_boxes, num_boxes == 1 ? "" : "es" );
     }
     g_Log.Write( "%4d light%s.\n", num_lights, num_lights == 1 ? "" : "s" );
+    g_Log.Write( "%4d material%s (%d shared, %d colors).\n", nrMaterial::NumMaterials(), 
+        nrMaterial::NumMaterials() == 1 ? "" : "s", nrMaterial::NumShared(), nrChannelColor::NumInterned() );
+    
+    Bake();
 
     return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
+void nrScene::CreateBatches( void )
+{
+    assert( m_BVH == 0 && m_RGS == 0 && m_TBVH == 0 );
+    assert( m_Primitives == 0 );
+    
+    int num_surfaces = m_Surfaces.Length();
+    
+    m_Primitives = nrPrimitives::Create( m_Surfaces, m_Arena );
+    
+    int num_spheres = m_Primitives->Count( nrSurface::TYPE_SPHERE );
+    int num_boxes = m_Primitives->Count( nrSurface::TYPE_BOX );
+    int num_triangles = m_Primitives->Count( nrSurface::TYPE_TRIANGLE );
+    
+    int num_batched = num_spheres + num_boxes + num_triangles;
+    int num_batches = m_Surfaces.Length() - ( num_surfaces - num_batched );
+    
+    g_Log.Write( "%4d batch%s (%d spheres, %d boxes, %d triangles).\n", num_batches, num_batches == 1 ? "" : "es", 
+        num_spheres, num_boxes, num_triangles );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 void nrScene::CreateBVH( bool sort )
 {
     assert( m_RGS == 0 );
 
     if ( m_Surfaces.Length() > 0 )
     {
-        m_BVH = nrSurfaceBVH::CreateTree( m_Surfaces, sort );
+        m_BVH = nrSurfaceBVH::CreateTree( m_Surfaces, m_Arena, sort );
     }
 }
 
@@ -318,6 +353,18 @@ void nrScene::CreateRGS( void )
 
 ////////////////////////////////////////////////////////////////////////////
 
+void nrScene::CreateTBVH( void )
+{
+    assert( m_TBVH == 0 );
+    
+    if ( m_Surfaces.Length() > 0 )
+    {
+        m_TBVH = nrSurfaceTBVH::CreateTree( m_Surfaces );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 nrColor& nrScene::Ambient( void )
 {
     return m_Ambient;
@@ -338,3 +385,61 @@ void nrScene::CullBackfaces( bool cull )
 }
 
 ////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+void nrScene::Bake( void )
+{
+    if ( m_Surfaces.Length() == 0 )
+    {
+        return;
+    }
+    
+    nrBound bound = m_Surfaces[ 0 ]->Bound();
+    
+    int i;
+    for ( i = 1; i < m_Surfaces.Length(); i++ )
+    {
+        nrBound b = m_Surfaces[ i ]->Bound();
+        
+        bound.m_Minimums.x = nrMath::Min( bound.m_Minimums.x, b.m_Minimums.x );
+        bound.m_Minimums.y = nrMath::Min( bound.m_Minimums.y, b.m_Minimums.y );
+        bound.m_Minimums.z = nrMath::Min( bound.m_Minimums.z, b.m_Minimums.z );
+        bound.m_Maximums.x = nrMath::Max( bound.m_Maximums.x, b.m_Maximums.x );
+        bound.m_Maximums.y = nrMath::Max( bound.m_Maximums.y, b.m_Maximums.y );
+        bound.m_Maximums.z = nrMath::Max( bound.m_Maximums.z, b.m_Maximums.z );
+    }
+    
+    // Each material only needs to be baked once (most surfaces share a
+    // handful of materials, so a linear search is fine).
+    nrArray<const nrMaterial*> baked;
+    const nrMaterial* last = 0;
+    
+    for ( int j = 0; j < m_Surfaces.Length(); j++ )
+    {
+        const nrMaterial* material = m_Surfaces[ j ]->Material();
+        if ( material == 0 || material == last )
+        {
+            continue;
+        }
+        last = material;
+        
+        bool found = false;
+        for ( int k = 0; k < baked.Length(); k++ )
+        {
+            if ( baked[ k ] == material )
+            {
+                found = true;
+                break;
+            }
+        }
+        
+        if ( ! found )
+        {
+            material->Bake( bound );
+            baked.Add( material );
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
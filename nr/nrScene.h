@@ -16,6 +16,7 @@
 // Includes
 ////////////////////////////////////////////////////////////////////////////
 
+#include "nrArena.h"
 #include "nrArray.h"
 #include "nrColor.h"
 
@@ -28,7 +29,9 @@ class nrHit;
 class nrInterval;
 class nrRay;
 class nrLight;
+class nrPrimitives;
 class nrSurface;
+class nrSurfaceTBVH;
 class nrVector3;
 class nrView;
 
@@ -44,12 +47,23 @@ public:
     // Return true if the ray hit something in the scene in the interval.
     bool Hit( const nrRay& ray, nrInterval& interval, nrHit& hit ) const;
     
+    // Return true if the ray hit anything in the scene in the interval.
+    // Only the existence of a hit is determined, so this is the query to
+    // use for shadow rays.  Uses the threaded hierarchy if one has been
+    // created, otherwise falls back on Hit().
+    bool Occluded( const nrRay& ray, const nrInterval& interval ) const;
+    
     // Adds a surface to the scene.
     //void Add( nrSurface* surface );
     
     // Parse a scene file.
     bool Parse( const char* scene_file );
     
+    // Gather the spheres, boxes and triangles in the scene into batches
+    // which are intersected several at a time (see nrPrimitives).  This
+    // must be done before any of the hierarchies or grids are created.
+    void CreateBatches( void );
+    
     // Create a bounding volume hierarchy with the surfaces in the scene.
     // See nrSurfaceBVH::CreateTree() for information on the sort parameter.
     void CreateBVH( bool sort = false );
@@ -57,6 +71,11 @@ public:
     // Create a regular grid subdivision of the surfaces in the scene.
     void CreateRGS( void );
     
+    // Create a threaded (stackless) bounding volume hierarchy with the 
+    // surfaces in the scene for occlusion queries.  This can be created
+    // in addition to either the BVH or the RGS.
+    void CreateTBVH( void );
+    
     // Cull backfacing triangles?
     void CullBackfaces( bool cull = true );
     
@@ -76,6 +95,12 @@ public:
     // The background defaults to < 0.0 0.0 0.0 >
     nrColor& Background( void );
     
+private:
+    
+    // Bake the channels of the materials in the scene over the bound of
+    // the surfaces (see nrChannel::Bake()).
+    void Bake( void );
+    
 public:
     
     nrArray<nrLight*>   m_Lights;
@@ -84,11 +109,17 @@ public:
     
     nrSurface*          m_BVH;
     nrSurface*          m_RGS;
+    nrSurfaceTBVH*      m_TBVH;
+    nrPrimitives*       m_Primitives;
     
     nrColor				m_Ambient;
     nrColor				m_Background;
     
     bool m_Cull;
+    
+    // Holds the surfaces, the batch leaves and the hierarchy nodes, which
+    // are all released at once when the scene is destroyed.
+    nrArena             m_Arena;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSemaphore.cpp
+//
+// A class for counting semaphores.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSemaphore.h"
+
+#include <assert.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrSemaphore::nrSemaphore( int count )
+{
+#ifdef _WIN32
+    m_Semaphore = CreateSemaphore( NULL, count, 0x7fffffff, NULL );
+    assert( m_Semaphore );
+#else
+    pthread_mutex_init( &m_Mutex, NULL );
+    pthread_cond_init( &m_Condition, NULL );
+    m_Count = count;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSemaphore::~nrSemaphore( void )
+{
+#ifdef _WIN32
+    CloseHandle( ( HANDLE )m_Semaphore );
+#else
+    pthread_cond_destroy( &m_Condition );
+    pthread_mutex_destroy( &m_Mutex );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrSemaphore::Wait( void )
+{
+#ifdef _WIN32
+    WaitForSingleObject( ( HANDLE )m_Semaphore, INFINITE );
+#else
+    pthread_mutex_lock( &m_Mutex );
+    
+    while ( m_Count <= 0 )
+    {
+        pthread_cond_wait( &m_Condition, &m_Mutex );
+    }
+    m_Count--;
+    
+    pthread_mutex_unlock( &m_Mutex );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrSemaphore::Signal( void )
+{
+#ifdef _WIN32
+    ReleaseSemaphore( ( HANDLE )m_Semaphore, 1, NULL );
+#else
+    pthread_mutex_lock( &m_Mutex );
+    
+    m_Count++;
+    pthread_cond_signal( &m_Condition );
+    
+    pthread_mutex_unlock( &m_Mutex );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
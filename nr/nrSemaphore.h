@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSemaphore.h
+//
+// A class for counting semaphores.
+//
+// Wait() takes one from the count, waiting (without spinning) until the
+// count is positive; Signal() adds one to it, waking a waiting thread.
+// Used to hand work from one thread to another (see nrImageWriter).
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRSEMAPHORE_H
+#define NRSEMAPHORE_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrSemaphore
+{
+public:
+    
+    nrSemaphore( int count = 0 );
+    ~nrSemaphore( void );
+    
+    // Wait until the count is positive, and decrement it.
+    void Wait( void );
+    
+    // Increment the count.
+    void Signal( void );
+    
+private:
+    
+    // Not copyable.
+    nrSemaphore( const nrSemaphore& );
+    nrSemaphore& operator=( const nrSemaphore& );
+    
+private:
+    
+#ifdef _WIN32
+    void* m_Semaphore;          // A HANDLE (without all of windows.h).
+#else
+    pthread_mutex_t m_Mutex;
+    pthread_cond_t m_Condition;
+    int m_Count;
+#endif
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRSEMAPHORE_H
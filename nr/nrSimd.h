@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSimd.h
+//
+// Switches for the SIMD code paths.
+//
+// NR_AVX2 is defined when the compiler targets AVX2 (e.g., /arch:AVX2 or
+// -mavx2 -mfma), unless NR_NO_SIMD is defined.  Every SIMD code path has
+// a scalar fallback which computes the same results.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRSIMD_H
+#define NRSIMD_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+#if defined( __AVX2__ ) && ! defined( NR_NO_SIMD )
+#define NR_AVX2
+#endif
+
+// Number of lanes processed together by the batched code paths.  Batches
+// are padded to a multiple of this, so a vector load never runs off the
+// end of an array.
+#define NR_SIMD_WIDTH 8
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#ifdef NR_AVX2
+#include <immintrin.h>
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRSIMD_H
@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSplatBuffer.cpp
+//
+// A class for adding samples up in a frame buffer through a
+// reconstruction filter.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSplatBuffer.h"
+
+#include "nrLog.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrSplatBuffer::nrSplatBuffer( void )
+{
+    m_Buffer = 0;
+    m_TileSize = 0;
+    m_NumTilesX = 0;
+    m_NumTilesY = 0;
+    m_Border = 0;
+    m_Filter = Box;
+    m_Radius = 0.5f;
+    m_Scale = 0.0f;
+    m_Rings = 0;
+    m_RingSize = 0;
+    m_Finished = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSplatBuffer::~nrSplatBuffer( void )
+{
+    delete [] m_Rings;
+    delete [] m_Finished;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrSplatBuffer::Create( nrFrameBuffer* buffer, int tile_size, int filter, float radius )
+{
+    if ( tile_size < 1 || tile_size > NR_SPLAT_TILE )
+    {
+        g_Log.Write( "nrSplatBuffer::Create() : Tiles must be 1 to %d pixels.\n", NR_SPLAT_TILE );
+        return false;
+    }
+    if ( radius <= 0.0f || radius > NR_SPLAT_RADIUS )
+    {
+        g_Log.Write( "nrSplatBuffer::Create() : Filter radius must be in ( 0, %d ].\n", NR_SPLAT_RADIUS );
+        return false;
+    }
+
+    m_Buffer = buffer;
+    m_TileSize = tile_size;
+    m_NumTilesX = ( buffer->Width() + tile_size - 1 ) / tile_size;
+    m_NumTilesY = ( buffer->Height() + tile_size - 1 ) / tile_size;
+
+    // A sample in a tile reaches the pixels closer than the radius to it,
+    // and it may be as far out as the edge of the tile.
+    m_Border = ( int )ceil( radius + 0.5f ) - 1;
+
+    m_Filter = filter;
+    m_Radius = radius;
+    m_Scale = NR_SPLAT_TABLE / radius;
+
+    for ( int k = 0; k <= NR_SPLAT_TABLE; k++ )
+    {
+        m_Table[ k ] = Filter( k / m_Scale );
+    }
+
+    // An offset which rounds up to the radius interpolates past it.
+    m_Table[ NR_SPLAT_TABLE + 1 ] = m_Table[ NR_SPLAT_TABLE ];
+
+    int side = tile_size + 2 * m_Border;
+    m_RingSize = side * side - tile_size * tile_size;
+
+    int n = m_NumTilesX * m_NumTilesY;
+
+    delete [] m_Rings;
+    delete [] m_Finished;
+
+    m_Rings = new float[ n * m_RingSize * 4 ];
+    m_Finished = new bool[ n ];
+
+    if ( ! m_Rings || ! m_Finished )
+    {
+        g_Log.Write( "nrSplatBuffer::Create() : Out of memory.\n" );
+        return false;
+    }
+
+    memset( m_Finished, 0, n * sizeof ( bool ) );
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrSplatBuffer::Begin( nrSplatTile& tile, int x0, int y0, int x1, int y1 ) const
+{
+    assert( x0 % m_TileSize == 0 && y0 % m_TileSize == 0 );
+    assert( x1 - x0 <= m_TileSize && y1 - y0 <= m_TileSize );
+
+    tile.m_X0 = x0;
+    tile.m_Y0 = y0;
+    tile.m_X1 = x1;
+    tile.m_Y1 = y1;
+    tile.m_Border = m_Border;
+    tile.m_Stride = x1 - x0 + 2 * m_Border;
+
+    memset( tile.m_Pixels, 0, tile.m_Stride * ( y1 - y0 + 2 * m_Border ) * 4 * sizeof ( float ) );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrSplatBuffer::End( const nrSplatTile& tile )
+{
+    int t = Tile( tile.m_X0, tile.m_Y0 );
+    float* ring = m_Rings + t * m_RingSize * 4;
+
+    const float* p = tile.m_Pixels;
+
+    for ( int y = tile.m_Y0 - m_Border; y < tile.m_Y1 + m_Border; y++ )
+    {
+        for ( int x = tile.m_X0 - m_Border; x < tile.m_X1 + m_Border; x++ )
+        {
+            if ( y >= tile.m_Y0 && y < tile.m_Y1 && x >= tile.m_X0 && x < tile.m_X1 )
+            {
+                // No other tile has this pixel (yet).
+                memcpy( m_Buffer->Pixel( x, y ), p, 4 * sizeof ( float ) );
+            }
+            else
+            {
+                memcpy( ring, p, 4 * sizeof ( float ) );
+                ring += 4;
+            }
+
+            p += 4;
+        }
+    }
+
+    m_Finished[ t ] = true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrSplatBuffer::Merge( void )
+{
+    int w = m_Buffer->Width();
+    int h = m_Buffer->Height();
+
+    // In the order of the tiles, and of their rings' pixels (as End()
+    // kept them), whatever order they were finished in.
+    for ( int ty = 0; ty < m_NumTilesY; ty++ )
+    {
+        for ( int tx = 0; tx < m_NumTilesX; tx++ )
+        {
+            int t = ty * m_NumTilesX + tx;
+
+            if ( ! m_Finished[ t ] )
+            {
+                continue;
+            }
+
+            int x0 = tx * m_TileSize;
+            int y0 = ty * m_TileSize;
+            int x1 = nrMath::Min( x0 + m_TileSize, w );
+            int y1 = nrMath::Min( y0 + m_TileSize, h );
+
+            const float* ring = m_Rings + t * m_RingSize * 4;
+
+            for ( int y = y0 - m_Border; y < y1 + m_Border; y++ )
+            {
+                for ( int x = x0 - m_Border; x < x1 + m_Border; x++ )
+                {
+                    if ( y >= y0 && y < y1 && x >= x0 && x < x1 )
+                    {
+                        continue;
+                    }
+
+                    // Pixels beyond the edges of the frame are dropped.
+                    if ( x >= 0 && x < w && y >= 0 && y < h )
+                    {
+                        float* p = m_Buffer->Pixel( x, y );
+
+                        p[ 0 ] += ring[ 0 ];
+                        p[ 1 ] += ring[ 1 ];
+                        p[ 2 ] += ring[ 2 ];
+                        p[ 3 ] += ring[ 3 ];
+                    }
+
+                    ring += 4;
+                }
+            }
+
+            m_Finished[ t ] = false;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+float nrSplatBuffer::Filter( float x ) const
+{
+    x = nrMath::Abs( x );
+
+    if ( x > m_Radius )
+    {
+        return 0.0f;
+    }
+
+    if ( m_Filter == Gaussian )
+    {
+        // With sigma a third of the radius, less its value at the radius
+        // (so it falls to 0 there, rather than stepping down).
+        float s = m_Radius / 3.0f;
+        float g = ( float )exp( -x * x / ( 2.0f * s * s ) ) - ( float )exp( -m_Radius * m_Radius / ( 2.0f * s * s ) );
+
+        return nrMath::Max( g, 0.0f );
+    }
+    else if ( m_Filter == Mitchell )
+    {
+        // Mitchell and Netravali's cubic, with B = C = 1/3, stretched
+        // from [ 0, 2 ] to the radius.
+        const float B = 1.0f / 3.0f;
+        const float C = 1.0f / 3.0f;
+
+        float t = 2.0f * x / m_Radius;
+
+        if ( t < 1.0f )
+        {
+            return ( ( 12.0f - 9.0f * B - 6.0f * C ) * t * t * t +
+                     ( -18.0f + 12.0f * B + 6.0f * C ) * t * t +
+                     ( 6.0f - 2.0f * B ) ) / 6.0f;
+        }
+        else
+        {
+            return ( ( -B - 6.0f * C ) * t * t * t +
+                     ( 6.0f * B + 30.0f * C ) * t * t +
+                     ( -12.0f * B - 48.0f * C ) * t +
+                     ( 8.0f * B + 24.0f * C ) ) / 6.0f;
+        }
+    }
+
+    return 1.0f;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+int nrSplatBuffer::Tile( int x, int y ) const
+{
+    assert( x >= 0 && y >= 0 && x / m_TileSize < m_NumTilesX && y / m_TileSize < m_NumTilesY );
+
+    return ( y / m_TileSize ) * m_NumTilesX + x / m_TileSize;
+}
+
+////////////////////////////////////////////////////////////////////////////
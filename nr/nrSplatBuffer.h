@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSplatBuffer.h
+//
+// A class for adding samples up in a frame buffer through a
+// reconstruction filter.
+//
+// Each sample is splatted into every pixel within the filter radius of
+// it, weighted by the filter at its offset from the pixel (the product of
+// the filter across x and down y, interpolated from a table, so a wide
+// filter costs no more per pixel than a box).  A resolved pixel is then the
+// filtered average of the samples around it (see nrFrameBuffer).
+//
+// The frame is splatted a tile at a time, each tile into its own
+// nrSplatTile, which has a border of the pixels around the tile that its
+// samples reach.  When a tile is finished, its pixels are stored in the
+// frame buffer (the tiles don't overlap) and its border is kept aside;
+// the borders are added in, in order, by Merge() once every tile is
+// finished.  So tiles may be splatted on any number of threads without
+// locks, and the results don't depend on the order they finish in.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRSPLATBUFFER_H
+#define NRSPLATBUFFER_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrColor.h"
+#include "nrFrameBuffer.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// Largest tile (in pixels on a side), and filter radius (in pixels).
+#define NR_SPLAT_TILE   32
+#define NR_SPLAT_RADIUS 4
+
+// Number of steps in the filter table (over [ 0, radius ]).
+#define NR_SPLAT_TABLE  64
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+// A tile being splatted (see nrSplatBuffer::Begin()), with a border.
+class nrSplatTile
+{
+public:
+
+    int m_X0;                   // The tile, [ m_X0, m_X1 ) x [ m_Y0, m_Y1 ).
+    int m_Y0;
+    int m_X1;
+    int m_Y1;
+    int m_Border;               // Pixels around it.
+    int m_Stride;               // Pixels across, with the border.
+
+    // The pixels from ( m_X0 - m_Border, m_Y0 - m_Border ), 4 floats each.
+    float m_Pixels[ ( NR_SPLAT_TILE + 2 * NR_SPLAT_RADIUS ) * ( NR_SPLAT_TILE + 2 * NR_SPLAT_RADIUS ) * 4 ];
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+class nrSplatBuffer
+{
+public:
+
+    enum
+    {
+        Box,
+        Gaussian,
+        Mitchell
+    };
+
+public:
+
+    nrSplatBuffer( void );
+    ~nrSplatBuffer( void );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Create a splat buffer for a frame buffer, splatted in tiles of
+    // tile_size (at most NR_SPLAT_TILE) pixels on a side from 0, 0, with
+    // a filter (Box, Gaussian or Mitchell) of the given radius (at most
+    // NR_SPLAT_RADIUS).
+    //
+    // If successful, returns true, otherwise returns false and writes an
+    // error message to the global log.
+    bool Create( nrFrameBuffer* buffer, int tile_size, int filter, float radius );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Start splatting the tile [ x0, x1 ) x [ y0, y1 ), one of those of
+    // tile_size (see Create()).
+    void Begin( nrSplatTile& tile, int x0, int y0, int x1, int y1 ) const;
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Splat a sample at ( x, y ) (pixel i is centered on i) of the given
+    // color and weight (the area it stands for) into a tile.  The sample
+    // must be in the tile.
+    inline void Splat( nrSplatTile& tile, float x, float y, const nrColor& color, float weight ) const;
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Store a finished tile in the frame buffer (replacing the pixels
+    // there), and keep its border for Merge().
+    void End( const nrSplatTile& tile );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Add the borders of the finished tiles to the frame buffer.
+    void Merge( void );
+
+    ////////////////////////////////////////////////////////////////////////
+
+    // Return the filter at an offset of x pixels (either way).
+    float Filter( float x ) const;
+
+private:
+
+    // Return the filter at an offset of x (at most the radius) pixels,
+    // interpolated from the table.
+    inline float Lookup( float x ) const;
+
+    // Return the index of the tile at x, y (in pixels).
+    int Tile( int x, int y ) const;
+
+    // Not copyable.
+    nrSplatBuffer( const nrSplatBuffer& );
+    nrSplatBuffer& operator=( const nrSplatBuffer& );
+
+private:
+
+    nrFrameBuffer* m_Buffer;
+    int m_TileSize;
+    int m_NumTilesX;
+    int m_NumTilesY;
+    int m_Border;               // Pixels around each tile.
+
+    int m_Filter;
+    float m_Radius;
+    float m_Scale;              // Table steps per pixel.
+    float m_Table[ NR_SPLAT_TABLE + 2 ];
+
+    // The borders of the finished tiles, m_RingSize pixels each, and
+    // whether each tile is finished.
+    float* m_Rings;
+    int m_RingSize;
+    bool* m_Finished;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSplatBuffer.inl"
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRSPLATBUFFER_H
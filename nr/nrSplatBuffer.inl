@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSplatBuffer.inl
+//
+// A class for adding samples up in a frame buffer through a
+// reconstruction filter.
+//
+// Nate Robins, March 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSplatBuffer.h"
+
+#include "nrMath.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+inline void nrSplatBuffer::Splat( nrSplatTile& tile, float x, float y, const nrColor& color, float weight ) const
+{
+    // The pixels closer than the radius, which are all in the tile or
+    // its border (but clip them to it, in case of rounding).
+    int x0 = nrMath::Max( ( int )nrMath::Floor( x - m_Radius ) + 1, tile.m_X0 - tile.m_Border );
+    int x1 = nrMath::Min( ( int )nrMath::Ceil( x + m_Radius ) - 1, tile.m_X1 - 1 + tile.m_Border );
+    int y0 = nrMath::Max( ( int )nrMath::Floor( y - m_Radius ) + 1, tile.m_Y0 - tile.m_Border );
+    int y1 = nrMath::Min( ( int )nrMath::Ceil( y + m_Radius ) - 1, tile.m_Y1 - 1 + tile.m_Border );
+
+    // The filter across x, once for all of the rows.
+    float fx[ 2 * NR_SPLAT_RADIUS + 1 ];
+
+    int i;
+    for ( i = x0; i <= x1; i++ )
+    {
+        fx[ i - x0 ] = Lookup( nrMath::Abs( ( float )i - x ) );
+    }
+
+    for ( int j = y0; j <= y1; j++ )
+    {
+        float fy = weight * Lookup( nrMath::Abs( ( float )j - y ) );
+
+        float* p = tile.m_Pixels + ( ( j - tile.m_Y0 + tile.m_Border ) * tile.m_Stride + ( x0 - tile.m_X0 + tile.m_Border ) ) * 4;
+
+        for ( i = x0; i <= x1; i++ )
+        {
+            float w = fx[ i - x0 ] * fy;
+
+            p[ 0 ] += color.r * w;
+            p[ 1 ] += color.g * w;
+            p[ 2 ] += color.b * w;
+            p[ 3 ] += w;
+
+            p += 4;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+inline float nrSplatBuffer::Lookup( float x ) const
+{
+    float t = x * m_Scale;
+    int k = ( int )t;
+
+    return m_Table[ k ] + ( m_Table[ k + 1 ] - m_Table[ k ] ) * ( t - ( float )k );
+}
+
+////////////////////////////////////////////////////////////////////////////
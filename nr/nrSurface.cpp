@@ -30,3 +30,10 @@ nrSurface::~nrSurface( void )
 }
 
 ////////////////////////////////////////////////////////////////////////////
+
+nrSurface::nrType nrSurface::Type( void ) const
+{
+    return TYPE_OTHER;
+}
+
+////////////////////////////////////////////////////////////////////////////
@@ -33,6 +33,18 @@ class nrRay;
 
 class nrSurface
 {
+public:
+    
+    typedef enum
+    {
+        TYPE_OTHER,
+        TYPE_SPHERE,
+        TYPE_BOX,
+        TYPE_TRIANGLE,
+        
+        TYPE_COUNT,
+    } nrType;
+    
 public:
     
     nrSurface( void );
@@ -50,6 +62,10 @@ public:
     // Return the material of the surface.
     virtual const nrMaterial* Material( void ) const = 0;
     
+    // Return the type of the surface.  Surfaces of the same type can be
+    // gathered into batches (see nrPrimitives).
+    virtual nrType Type( void ) const;
+    
 protected:
     
     char* m_Name;
@@ -14,6 +14,7 @@
 
 #include "nrSurfaceBVH.h"
 
+#include "nrArena.h"
 #include "nrHit.h"
 #include "nrInterval.h"
 #include "nrRay.h"
@@ -35,8 +36,7 @@ nrSurfaceBVH::nrSurfaceBVH( const nrBound& bound )
 
 nrSurfaceBVH::~nrSurfaceBVH( void )
 {
-    delete m_Left;
-    delete m_Right;
+    // The children are in the arena.
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -313,7 +313,7 @@ int nrSurfaceBVH::Split( const nrArray< nrSurface* >& surfaces, const nrBound& b
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrSurface* nrSurfaceBVH::CreateTree( nrArray< nrSurface* >& surfaces, bool sort )
+nrSurface* nrSurfaceBVH::CreateTree( nrArray< nrSurface* >& surfaces, nrArena& arena, bool sort )
 {
     assert( surfaces.Length() > 0 );
     
@@ -356,7 +356,7 @@ nrSurface* nrSurfaceBVH::CreateTree( nrArray< nrSurface* >& surfaces, bool sort
         }
     }
     
-    nrSurfaceBVH* parent = new nrSurfaceBVH( bound );
+    nrSurfaceBVH* parent = new ( arena ) nrSurfaceBVH( bound );
     assert( parent );
     
     // Sort/Split the array of surfaces.
@@ -388,8 +388,8 @@ nrSurface* nrSurfaceBVH::CreateTree( nrArray< nrSurface* >& surfaces, bool sort
     }
     
     // Create the children.
-    parent->m_Left = CreateTree( left, sort );
-    parent->m_Right = CreateTree( right, sort );
+    parent->m_Left = CreateTree( left, arena, sort );
+    parent->m_Right = CreateTree( right, arena, sort );
     
     return parent;
 }
@@ -25,6 +25,7 @@
 // Classes
 ////////////////////////////////////////////////////////////////////////////
 
+class nrArena;
 class nrBound;
 class nrHit;
 class nrInterval;
@@ -34,6 +35,11 @@ class nrRay;
 
 class nrSurfaceBVH : public nrSurface
 {
+    // The threaded hierarchy and the primitive batches split surfaces 
+    // the same way.
+    friend class nrPrimitives;
+    friend class nrSurfaceTBVH;
+    
 public:
 
     virtual ~nrSurfaceBVH( void );
@@ -55,7 +61,9 @@ public:
     // If the sort parameter is true, a sort will be performed to arrange 
     // the surfaces array instead of a simple split.  The split is 
     // generally much faster to compute and to render.
-    static nrSurface* CreateTree( nrArray< nrSurface* >& surfaces, bool sort = false );
+    //
+    // The nodes of the hierarchy are allocated from the arena.
+    static nrSurface* CreateTree( nrArray< nrSurface* >& surfaces, nrArena& arena, bool sort = false );
     
 private:
     
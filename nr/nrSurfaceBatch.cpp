@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSurfaceBatch.cpp
+//
+// A class for a batch of primitives of the same type (a leaf that refers
+// to a range of an nrPrimitives).
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSurfaceBatch.h"
+
+#include "nrHit.h"
+#include "nrInterval.h"
+#include "nrPrimitives.h"
+#include "nrRay.h"
+
+#include <assert.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceBatch::nrSurfaceBatch( const nrPrimitives* primitives, nrType type, int first, int count, const nrBound& bound )
+{
+    m_Primitives = primitives;
+    m_Type = type;
+    m_First = first;
+    m_Count = count;
+    m_Bound = bound;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceBatch::~nrSurfaceBatch( void )
+{
+    // The primitives are owned by the nrPrimitives.
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrSurfaceBatch::Hit( const nrRay& ray, nrInterval& interval, nrHit& hit ) const
+{
+    return m_Primitives->Hit( m_Type, m_First, m_Count, ray, interval, hit );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrBound nrSurfaceBatch::Bound( void ) const
+{
+    return m_Bound;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrVector3 nrSurfaceBatch::Normal( const nrVector3& point ) const
+{
+    // This function should never be called (hits refer to the primitive).
+    assert( 0 );
+
+    return nrVector3( 0, 0, 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+const nrMaterial* nrSurfaceBatch::Material( void ) const
+{
+    // This function should never be called (hits refer to the primitive).
+    assert( 0 );
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSurfaceBatch.h
+//
+// A class for a batch of primitives of the same type (a leaf that refers
+// to a range of an nrPrimitives).
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRSURFACEBATCH_H
+#define NRSURFACEBATCH_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSurface.h"
+#include "nrVector3.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrBound;
+class nrHit;
+class nrInterval;
+class nrPrimitives;
+class nrRay;
+
+////////////////////////////////////////////////////////////////////////////
+
+class nrSurfaceBatch : public nrSurface
+{
+public:
+
+    nrSurfaceBatch( const nrPrimitives* primitives, nrType type, int first, int count, const nrBound& bound );
+    virtual ~nrSurfaceBatch( void );
+
+    // Return true if the ray hit a primitive in the batch, false
+    // otherwise.  The hit refers to the primitive, not the batch.
+    virtual bool Hit( const nrRay& ray, nrInterval& interval, nrHit& hit ) const;
+
+    // Return the bound of the surface.
+    virtual nrBound Bound() const;
+
+    // Return the normal to the surface at the point (on the surface).
+    virtual nrVector3 Normal( const nrVector3& point ) const;
+
+    // Return the material of the surface.
+    virtual const nrMaterial* Material( void ) const;
+
+private:
+
+    const nrPrimitives* m_Primitives;
+    nrType              m_Type;
+    int                 m_First;
+    int                 m_Count;
+    nrBound             m_Bound;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRSURFACEBATCH_H
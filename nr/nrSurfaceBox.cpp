@@ -14,6 +14,7 @@
 
 #include "nrSurfaceBox.h"
 
+#include "nrArena.h"
 #include "nrHit.h"
 #include "nrInterval.h"
 #include "nrLog.h"
@@ -128,7 +129,7 @@ bool nrSurfaceBox::Hit( const nrRay& ray, nrInterval& interval, nrHit& hit ) con
         float t = xyz.m_Minimum;
         if ( interval.Includes( t ) )
         {
-            hit = nrHit( this, t );
+            Fill( hit, ray, t );
             return true;
         }
         
@@ -192,7 +193,21 @@ const nrMaterial* nrSurfaceBox::Material( void  ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrSurfaceBox* nrSurfaceBox::Parse( nrParser& parser )
+nrSurface::nrType nrSurfaceBox::Type( void ) const
+{
+    return TYPE_BOX;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrSurfaceBox::Fill( nrHit& hit, const nrRay& ray, float t ) const
+{
+    hit = nrHit( this, t, nrSurfaceBox::Normal( ray.Point( t ) ), m_Material );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceBox* nrSurfaceBox::Parse( nrParser& parser, nrArena& arena )
 {
     nrVector3   p0, p1;
     nrMaterial* material = 0;
@@ -270,7 +285,7 @@ nrSurfaceBox* nrSurfaceBox::Parse( nrParser& parser )
         return 0;
     }
     
-    nrSurfaceBox* box = new nrSurfaceBox( p0, p1, material );
+    nrSurfaceBox* box = new ( arena ) nrSurfaceBox( p0, p1, material );
     
     return box;
 }
@@ -25,6 +25,7 @@
 // Classes
 ////////////////////////////////////////////////////////////////////////////
 
+class nrArena;
 class nrHit;
 class nrInterval;
 class nrParser;
@@ -51,6 +52,12 @@ public:
     // Return the material of the surface.
     virtual const nrMaterial* Material( void ) const;
     
+    // Return the type of the surface.
+    virtual nrType Type( void ) const;
+    
+    // Fill in the hit for the ray hitting the box at distance t.
+    void Fill( nrHit& hit, const nrRay& ray, float t ) const;
+    
     // Return a new box parsed from a file.  The box directive has the
     // following form:
     // 
@@ -61,8 +68,10 @@ public:
     //   color < r g b >
     // }
     // 
-    // elements in ()'s are optional.
-    static nrSurfaceBox* Parse( nrParser& parser );
+    // elements in ()'s are optional.  The box is allocated from the arena.
+    // A material given as a color is shared with every other surface of
+    // that color (see nrMaterial::ParseColor()).
+    static nrSurfaceBox* Parse( nrParser& parser, nrArena& arena );
     
 public:
     
@@ -14,6 +14,7 @@
 
 #include "nrSurfaceSphere.h"
 
+#include "nrArena.h"
 #include "nrHit.h"
 #include "nrInterval.h"
 #include "nrLog.h"
@@ -64,14 +65,14 @@ bool nrSurfaceSphere::Hit( const nrRay& ray, nrInterval& interval, nrHit& hit )
         float t = ( -B - s ) / ( 2 * A );
         if ( interval.Includes( t ) ) 
         {
-            hit = nrHit( this, t );
+            Fill( hit, ray, t );
             return true;
         }
         
         t = ( -B + s ) / ( 2 * A );
         if ( interval.Includes( t ) )
         {
-            hit = nrHit( this, t );
+            Fill( hit, ray, t );
             return true;
         }
     }
@@ -109,7 +110,23 @@ const nrMaterial* nrSurfaceSphere::Material( void ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrSurfaceSphere* nrSurfaceSphere::Parse( nrParser& parser )
+nrSurface::nrType nrSurfaceSphere::Type( void ) const
+{
+    return TYPE_SPHERE;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrSurfaceSphere::Fill( nrHit& hit, const nrRay& ray, float t ) const
+{
+    nrVector3 point = ray.Point( t );
+    
+    hit = nrHit( this, t, ( point - m_Center ).Unit(), m_Material );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceSphere* nrSurfaceSphere::Parse( nrParser& parser, nrArena& arena )
 {
     nrVector3   center = nrVector3( 0, 0, 0 );
     float       radius = 0;
@@ -184,7 +201,7 @@ nrSurfaceSphere* nrSurfaceSphere::Parse( nrParser& parser )
         return 0;
     }
     
-    nrSurfaceSphere* sphere = new nrSurfaceSphere( center, radius, material );
+    nrSurfaceSphere* sphere = new ( arena ) nrSurfaceSphere( center, radius, material );
     
     return sphere;
 }
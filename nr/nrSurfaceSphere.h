@@ -25,6 +25,7 @@
 // Classes
 ////////////////////////////////////////////////////////////////////////////
 
+class nrArena;
 class nrHit;
 class nrInterval;
 class nrParser;
@@ -51,6 +52,9 @@ public:
     // Return the material of the surface.
     virtual const nrMaterial* Material( void ) const;
     
+    // Return the type of the surface.
+    virtual nrType Type( void ) const;
+    
     // Return a new sphere parsed from a file.  The sphere directive has the
     // following form:
     // 
@@ -61,8 +65,19 @@ public:
     //   color < r g b >
     // }
     // 
-    // elements in ()'s are optional.
-    static nrSurfaceSphere* Parse( nrParser& parser );
+    // elements in ()'s are optional.  The sphere is allocated from the
+    // arena.  A material given as a color is shared with every other
+    // surface of that color (see nrMaterial::ParseColor()).
+    static nrSurfaceSphere* Parse( nrParser& parser, nrArena& arena );
+    
+    // Fill in the hit for the ray hitting the sphere at distance t.
+    void Fill( nrHit& hit, const nrRay& ray, float t ) const;
+    
+    // Return the center of the sphere.
+    const nrVector3& Center( void ) const { return m_Center; }
+    
+    // Return the radius of the sphere.
+    float Radius( void ) const { return m_Radius; }
     
 private:
     
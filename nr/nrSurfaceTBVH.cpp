@@ -0,0 +1,327 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSurfaceTBVH.cpp
+//
+// A class for a threaded (stackless) bounding volume hierarchy of
+// surfaces.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrSurfaceTBVH.h"
+
+#include "nrHit.h"
+#include "nrInterval.h"
+#include "nrRay.h"
+#include "nrSurfaceBVH.h"
+
+#include <assert.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceTBVH::nrSurfaceTBVH( int num_surfaces )
+{
+    // A binary tree with n leaves has exactly 2n - 1 nodes.
+    m_Nodes = new nrTBVHNode[ 2 * num_surfaces - 1 ];
+    assert( m_Nodes );
+
+    m_NumNodes = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceTBVH::~nrSurfaceTBVH( void )
+{
+    delete [] m_Nodes;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrSurfaceTBVH::Hit( const nrRay& ray, nrInterval& interval, nrHit& hit ) const
+{
+    nrVector3 inverse = nrVector3( 1.0f / ray.d.x, 1.0f / ray.d.y, 1.0f / ray.d.z );
+
+    bool hit_something = false;
+
+    int i = 0;
+    while ( i < m_NumNodes )
+    {
+        const nrTBVHNode& node = m_Nodes[ i ];
+
+        if ( node.m_Surface )
+        {
+            nrHit h;
+            if ( node.m_Surface->Hit( ray, interval, h ) )
+            {
+                hit = h;
+                interval.m_Maximum = h.t;
+                hit_something = true;
+            }
+
+            i++;
+        }
+        else if ( Hit( node, ray.o, inverse, interval ) )
+        {
+            i++;
+        }
+        else
+        {
+            i = node.m_Miss;
+        }
+    }
+
+    return hit_something;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool nrSurfaceTBVH::Occluded( const nrRay& ray, const nrInterval& interval ) const
+{
+    nrVector3 inverse = nrVector3( 1.0f / ray.d.x, 1.0f / ray.d.y, 1.0f / ray.d.z );
+
+    // The surfaces may narrow the interval, so hand them a copy.
+    nrInterval span = interval;
+
+    int i = 0;
+    while ( i < m_NumNodes )
+    {
+        const nrTBVHNode& node = m_Nodes[ i ];
+
+        if ( node.m_Surface )
+        {
+            nrHit h;
+            if ( node.m_Surface->Hit( ray, span, h ) )
+            {
+                return true;
+            }
+
+            i++;
+        }
+        else if ( Hit( node, ray.o, inverse, interval ) )
+        {
+            i++;
+        }
+        else
+        {
+            i = node.m_Miss;
+        }
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrBound nrSurfaceTBVH::Bound( void ) const
+{
+    assert( m_NumNodes > 0 );
+
+    return nrBound( m_Nodes[ 0 ].m_Minimums, m_Nodes[ 0 ].m_Maximums );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrVector3 nrSurfaceTBVH::Normal( const nrVector3& point ) const
+{
+    // This function should never be called.
+    assert( 0 );
+
+    return nrVector3( 0, 0, 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+const nrMaterial* nrSurfaceTBVH::Material( void ) const
+{
+    // This function should never be called.
+    assert( 0 );
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+inline bool nrSurfaceTBVH::Hit( const nrTBVHNode& node, const nrVector3& o, const nrVector3& inverse, const nrInterval& interval ) const
+{
+    // Slab test clipped to the interval.  An axis parallel ray yields an
+    // infinite (or NaN) slab which never narrows the span, so it is
+    // treated conservatively.
+    float t0 = interval.m_Minimum;
+    float t1 = interval.m_Maximum;
+
+    float a = ( node.m_Minimums.x - o.x ) * inverse.x;
+    float b = ( node.m_Maximums.x - o.x ) * inverse.x;
+    if ( a > b )
+    {
+        float t = a;
+        a = b;
+        b = t;
+    }
+    if ( a > t0 )
+    {
+        t0 = a;
+    }
+    if ( b < t1 )
+    {
+        t1 = b;
+    }
+
+    a = ( node.m_Minimums.y - o.y ) * inverse.y;
+    b = ( node.m_Maximums.y - o.y ) * inverse.y;
+    if ( a > b )
+    {
+        float t = a;
+        a = b;
+        b = t;
+    }
+    if ( a > t0 )
+    {
+        t0 = a;
+    }
+    if ( b < t1 )
+    {
+        t1 = b;
+    }
+
+    a = ( node.m_Minimums.z - o.z ) * inverse.z;
+    b = ( node.m_Maximums.z - o.z ) * inverse.z;
+    if ( a > b )
+    {
+        float t = a;
+        a = b;
+        b = t;
+    }
+    if ( a > t0 )
+    {
+        t0 = a;
+    }
+    if ( b < t1 )
+    {
+        t1 = b;
+    }
+
+    return t0 <= t1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrBound nrSurfaceTBVH::Build( nrArray< nrSurface* >& surfaces )
+{
+    assert( surfaces.Length() > 0 );
+
+    int index = m_NumNodes++;
+    nrTBVHNode& node = m_Nodes[ index ];
+
+    // A single surface becomes a leaf, which is always "missed" onto the
+    // next node once it has been tested.
+    if ( surfaces.Length() == 1 )
+    {
+        nrBound bound = surfaces[ 0 ]->Bound();
+
+        node.m_Minimums = bound.m_Minimums;
+        node.m_Maximums = bound.m_Maximums;
+        node.m_Miss = index + 1;
+        node.m_Surface = surfaces[ 0 ];
+
+        return bound;
+    }
+
+    // Compute the bounding volume of the parent (must enclose all children).
+    nrBound bound = surfaces[ 0 ]->Bound();
+    for ( int i = 1; i < surfaces.Length(); i++ )
+    {
+        const nrBound& b = surfaces[ i ]->Bound();
+
+        if ( b.m_Minimums.x < bound.m_Minimums.x )
+        {
+            bound.m_Minimums.x = b.m_Minimums.x;
+        }
+        if ( b.m_Minimums.y < bound.m_Minimums.y )
+        {
+            bound.m_Minimums.y = b.m_Minimums.y;
+        }
+        if ( b.m_Minimums.z < bound.m_Minimums.z )
+        {
+            bound.m_Minimums.z = b.m_Minimums.z;
+        }
+
+        if ( b.m_Maximums.x > bound.m_Maximums.x )
+        {
+            bound.m_Maximums.x = b.m_Maximums.x;
+        }
+        if ( b.m_Maximums.y > bound.m_Maximums.y )
+        {
+            bound.m_Maximums.y = b.m_Maximums.y;
+        }
+        if ( b.m_Maximums.z > bound.m_Maximums.z )
+        {
+            bound.m_Maximums.z = b.m_Maximums.z;
+        }
+    }
+
+    node.m_Minimums = bound.m_Minimums;
+    node.m_Maximums = bound.m_Maximums;
+    node.m_Surface = 0;
+
+    // Split the surfaces the same way the pointer based hierarchy does.
+    int split = nrSurfaceBVH::Split( surfaces, bound );
+
+    int num_left = split;
+    int num_right = surfaces.Length() - num_left;
+
+    nrArray< nrSurface* > left( num_left );
+    nrArray< nrSurface* > right( num_right );
+
+    for ( int l = 0; l < num_left; l++ )
+    {
+        left.Add( surfaces[ l ] );
+    }
+    for ( int r = 0; r < num_right; r++ )
+    {
+        right.Add( surfaces[ num_left + r ] );
+    }
+
+    // The left child is the next node (the "hit" link), and the right
+    // child follows the left subtree.
+    Build( left );
+    Build( right );
+
+    node.m_Miss = m_NumNodes;
+
+    return bound;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Static
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceTBVH* nrSurfaceTBVH::CreateTree( const nrArray< nrSurface* >& surfaces )
+{
+    assert( surfaces.Length() > 0 );
+
+    // Work on a copy so that the order of the caller's array is kept.
+    nrArray< nrSurface* > copy( surfaces.Length() );
+    for ( int i = 0; i < surfaces.Length(); i++ )
+    {
+        copy.Add( surfaces[ i ] );
+    }
+
+    nrSurfaceTBVH* tree = new nrSurfaceTBVH( surfaces.Length() );
+    assert( tree );
+
+    tree->Build( copy );
+    assert( tree->m_NumNodes == 2 * surfaces.Length() - 1 );
+
+    return tree;
+}
+
+////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrSurfaceTBVH.h
+//
+// A class for a threaded (stackless) bounding volume hierarchy of
+// surfaces.
+//
+// The hierarchy is flattened into a single array of nodes in depth first
+// order.  Each node carries a "miss" link to the node which follows its
+// subtree; the "hit" link is implicitly the next node in the array.  A
+// traversal is then a single forward loop over the array which never
+// needs a stack, which makes it well suited to occlusion (shadow) rays
+// that only need to find any hit.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRSURFACETBVH_H
+#define NRSURFACETBVH_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrArray.h"
+#include "nrSurface.h"
+#include "nrVector3.h"
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrBound;
+class nrHit;
+class nrInterval;
+class nrRay;
+
+////////////////////////////////////////////////////////////////////////////
+
+class nrTBVHNode
+{
+public:
+
+    nrVector3        m_Minimums;
+    nrVector3        m_Maximums;
+
+    // Index of the node to visit if the bound is missed (the node that
+    // follows this subtree).  The end of the array is m_NumNodes.
+    int              m_Miss;
+
+    // The surface of a leaf node, 0 for an interior node.
+    const nrSurface* m_Surface;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+class nrSurfaceTBVH : public nrSurface
+{
+public:
+
+    virtual ~nrSurfaceTBVH( void );
+
+    // Return true if the ray hit the surface, false otherwise.
+    virtual bool Hit( const nrRay& ray, nrInterval& interval, nrHit& hit ) const;
+
+    // Return the bound of the surface.
+    virtual nrBound Bound() const;
+
+    // Return the normal to the surface at the point (on the surface).
+    virtual nrVector3 Normal( const nrVector3& point ) const;
+
+    // Return the material of the surface.
+    virtual const nrMaterial* Material( void ) const;
+
+    // Return true if the ray hit any surface in the interval, false
+    // otherwise.  Traversal stops at the first hit found.
+    bool Occluded( const nrRay& ray, const nrInterval& interval ) const;
+
+    // Create a threaded hierarchy from a list of surfaces.
+    //
+    // The surfaces are not owned by the hierarchy and must outlive it.
+    static nrSurfaceTBVH* CreateTree( const nrArray< nrSurface* >& surfaces );
+
+private:
+
+    nrSurfaceTBVH( int num_surfaces );
+
+    // Append the subtree for the surfaces to the node array, and return
+    // the bound of the subtree.
+    nrBound Build( nrArray< nrSurface* >& surfaces );
+
+    // Return true if the ray hit the bound of the node in the interval.
+    inline bool Hit( const nrTBVHNode& node, const nrVector3& o, const nrVector3& inverse, const nrInterval& interval ) const;
+
+private:
+
+    nrTBVHNode* m_Nodes;
+    int         m_NumNodes;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRSURFACETBVH_H
@@ -14,6 +14,7 @@
 
 #include "nrSurfaceTriangle.h"
 
+#include "nrArena.h"
 #include "nrHit.h"
 #include "nrInterval.h"
 #include "nrLog.h"
@@ -34,6 +35,26 @@ nrSurfaceTriangle::nrSurfaceTriangle( const nrVector3& a, const nrVector3& b, co
     m_A = a;
     m_B = b;
     m_C = c;
+    m_Normal = ( ( m_B - m_A ).Cross( m_C - m_A ) ).Unit();
+    
+    m_Smooth = false;
+    
+    m_Material = material;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceTriangle::nrSurfaceTriangle( const nrVector3& a, const nrVector3& b, const nrVector3& c, const nrVector3& na, const nrVector3& nb, const nrVector3& nc, const nrMaterial* material )
+{
+    m_A = a;
+    m_B = b;
+    m_C = c;
+    m_Normal = ( ( m_B - m_A ).Cross( m_C - m_A ) ).Unit();
+    
+    m_Smooth = true;
+    m_NA = na.Unit();
+    m_NB = nb.Unit();
+    m_NC = nc.Unit();
     
     m_Material = material;
 }
@@ -61,7 +82,7 @@ nrBound nrSurfaceTriangle::Bound( void ) const
 
 nrVector3 nrSurfaceTriangle::Normal( const nrVector3& point ) const
 {
-    return ( ( m_B - m_A ).Cross( m_C - m_A ) ).Unit();
+    return m_Normal;
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -74,6 +95,13 @@ const nrMaterial* nrSurfaceTriangle::Material( void  ) const
 
 ////////////////////////////////////////////////////////////////////////////
 
+nrSurface::nrType nrSurfaceTriangle::Type( void ) const
+{
+    return TYPE_TRIANGLE;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 bool nrSurfaceTriangle::Hit( const nrRay& ray, nrInterval& interval, nrHit& hit ) const
 {
     float a = m_A.x - m_B.x;
@@ -112,7 +140,7 @@ bool nrSurfaceTriangle::Hit( const nrRay& ray, nrInterval& interval, nrHit& hit
                 
                 if ( interval.Includes( t ) )
                 {
-                    hit = nrHit( this, t );
+                    Fill( hit, t, beta, gamma );
                     return true;
                 }
             }
@@ -124,14 +152,34 @@ bool nrSurfaceTriangle::Hit( const nrRay& ray, nrInterval& interval, nrHit& hit
 
 ////////////////////////////////////////////////////////////////////////////
 
-nrSurfaceTriangle* nrSurfaceTriangle::Parse( nrParser& parser )
+void nrSurfaceTriangle::Fill( nrHit& hit, float t, float beta, float gamma ) const
+{
+    hit = nrHit( this, t, m_Normal, m_Material );
+    hit.u = beta;
+    hit.v = gamma;
+    
+    if ( m_Smooth )
+    {
+        float alpha = 1.0f - beta - gamma;
+        
+        hit.m_Shading = ( m_NA * alpha + m_NB * beta + m_NC * gamma ).Unit();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+nrSurfaceTriangle* nrSurfaceTriangle::Parse( nrParser& parser, nrArena& arena )
 {
     nrVector3   a, b, c;
+    nrVector3   na, nb, nc;
     nrMaterial* material = 0;
     
     bool parsed_a = false;
     bool parsed_b = false;
     bool parsed_c = false;
+    bool parsed_na = false;
+    bool parsed_nb = false;
+    bool parsed_nc = false;
     bool parsed_material = false;
     
     if ( parser.NextToken() == nrParser::TOKEN_STRING )
@@ -175,6 +223,36 @@ nrSurfaceTriangle* nrSurfaceTriangle::Parse( nrParser& parser )
             
             parsed_c = true;
         }
+        else if ( parser.KeyMatches( key, "na" ) )
+        {
+            parser.ReadToken( nrParser::TOKEN_LIST_BEGIN );
+            na.x = parser.ReadFloat();
+            na.y = parser.ReadFloat();
+            na.z = parser.ReadFloat();
+            parser.ReadToken( nrParser::TOKEN_LIST_END );
+            
+            parsed_na = true;
+        }
+        else if ( parser.KeyMatches( key, "nb" ) )
+        {
+            parser.ReadToken( nrParser::TOKEN_LIST_BEGIN );
+            nb.x = parser.ReadFloat();
+            nb.y = parser.ReadFloat();
+            nb.z = parser.ReadFloat();
+            parser.ReadToken( nrParser::TOKEN_LIST_END );
+            
+            parsed_nb = true;
+        }
+        else if ( parser.KeyMatches( key, "nc" ) )
+        {
+            parser.ReadToken( nrParser::TOKEN_LIST_BEGIN );
+            nc.x = parser.ReadFloat();
+            nc.y = parser.ReadFloat();
+            nc.z = parser.ReadFloat();
+            parser.ReadToken( nrParser::TOKEN_LIST_END );
+            
+            parsed_nc = true;
+        }
         else if ( parser.KeyMatches( key, "color" ) )
         {
             material = nrMaterial::ParseColor( parser );
@@ -205,6 +283,10 @@ nrSurfaceTriangle* nrSurfaceTriangle::Parse( nrParser& parser )
     {
         parser.ParseError( "Required key \"c\" missing.\n" );
     }
+    if ( ( parsed_na || parsed_nb || parsed_nc ) && ! ( parsed_na && parsed_nb && parsed_nc ) )
+    {
+        parser.ParseError( "All or none of keys \"na\", \"nb\" and \"nc\" required.\n" );
+    }
     if ( ! parsed_material )
     {
         parser.ParseError( "Required key \"material\" missing.\n" );
@@ -217,7 +299,15 @@ nrSurfaceTriangle* nrSurfaceTriangle::Parse( nrParser& parser )
         return 0;
     }
     
-    nrSurfaceTriangle* triangle = new nrSurfaceTriangle( a, b, c, material );
+    nrSurfaceTriangle* triangle;
+    if ( parsed_na )
+    {
+        triangle = new ( arena ) nrSurfaceTriangle( a, b, c, na, nb, nc, material );
+    }
+    else
+    {
+        triangle = new ( arena ) nrSurfaceTriangle( a, b, c, material );
+    }
     
     return triangle;
 }
@@ -25,6 +25,7 @@
 // Classes
 ////////////////////////////////////////////////////////////////////////////
 
+class nrArena;
 class nrHit;
 class nrInterval;
 class nrParser;
@@ -37,6 +38,7 @@ class nrSurfaceTriangle : public nrSurface
 public:
     
     nrSurfaceTriangle( const nrVector3& a, const nrVector3& b, const nrVector3& c, const nrMaterial* material );
+    nrSurfaceTriangle( const nrVector3& a, const nrVector3& b, const nrVector3& c, const nrVector3& na, const nrVector3& nb, const nrVector3& nc, const nrMaterial* material );
     virtual ~nrSurfaceTriangle( void );
     
     // Return true if the ray hit the surface, false otherwise.
@@ -51,6 +53,9 @@ public:
     // Return the material of the surface.
     virtual const nrMaterial* Material( void ) const;
     
+    // Return the type of the surface.
+    virtual nrType Type( void ) const;
+    
     // Return a new triangle parsed from a file.  The triangle directive 
     // has the following form:
     // 
@@ -59,11 +64,22 @@ public:
     //   a < x y z >
     //   b < x y z >
     //   c < x y z >
+    //   (na < x y z >)
+    //   (nb < x y z >)
+    //   (nc < x y z >)
     //   color < r g b >
     // }
     // 
-    // elements in ()'s are optional.
-    static nrSurfaceTriangle* Parse( nrParser& parser );
+    // elements in ()'s are optional.  If the vertex normals (na, nb and
+    // nc) are given, the shading normal is interpolated from them.  The
+    // triangle is allocated from the arena.  A material given as a color
+    // is shared with every other surface of that color (see 
+    // nrMaterial::ParseColor()).
+    static nrSurfaceTriangle* Parse( nrParser& parser, nrArena& arena );
+    
+    // Fill in the hit for a ray hitting the triangle at distance t and 
+    // barycentric coordinates beta (towards b) and gamma (towards c).
+    void Fill( nrHit& hit, float t, float beta, float gamma ) const;
     
 public:
     
@@ -76,6 +92,12 @@ private:
     nrVector3 m_A;
     nrVector3 m_B;
     nrVector3 m_C;
+    nrVector3 m_Normal;
+    
+    bool      m_Smooth;
+    nrVector3 m_NA;
+    nrVector3 m_NB;
+    nrVector3 m_NC;
 
     const nrMaterial* m_Material;
 };
@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrThread.cpp
+//
+// A class for running work on several threads at once.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrThread.h"
+
+#include <assert.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+#define NR_THREAD_MAXIMUM 64
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+// What each thread is started with.
+struct nrThreadStart
+{
+    nrThread::nrFunction m_Function;
+    void*                m_Data;
+    int                  m_Thread;
+    int                  m_NumThreads;
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+// Static
+////////////////////////////////////////////////////////////////////////////
+
+int nrThread::m_NumThreads = 0;
+
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+static DWORD WINAPI nrThreadMain( LPVOID parameter )
+#else
+static void* nrThreadMain( void* parameter )
+#endif
+{
+    nrThreadStart* start = ( nrThreadStart* )parameter;
+    
+    start->m_Function( start->m_Data, start->m_Thread, start->m_NumThreads );
+    
+    return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// Public
+////////////////////////////////////////////////////////////////////////////
+
+void nrThread::Run( nrFunction function, void* data, int num_threads )
+{
+    if ( num_threads <= 0 )
+    {
+        num_threads = GetNumThreads();
+    }
+    if ( num_threads > NR_THREAD_MAXIMUM )
+    {
+        num_threads = NR_THREAD_MAXIMUM;
+    }
+    
+    nrThreadStart starts[ NR_THREAD_MAXIMUM ];
+    
+    int i;
+    for ( i = 0; i < num_threads; i++ )
+    {
+        starts[ i ].m_Function = function;
+        starts[ i ].m_Data = data;
+        starts[ i ].m_Thread = i;
+        starts[ i ].m_NumThreads = num_threads;
+    }
+    
+    // Thread 0 runs on the calling thread.
+#ifdef _WIN32
+    HANDLE threads[ NR_THREAD_MAXIMUM ];
+    
+    for ( i = 1; i < num_threads; i++ )
+    {
+        threads[ i ] = CreateThread( NULL, 0, nrThreadMain, &starts[ i ], 0, NULL );
+        assert( threads[ i ] );
+    }
+    
+    nrThreadMain( &starts[ 0 ] );
+    
+    for ( int j = 1; j < num_threads; j++ )
+    {
+        WaitForSingleObject( threads[ j ], INFINITE );
+        CloseHandle( threads[ j ] );
+    }
+#else
+    pthread_t threads[ NR_THREAD_MAXIMUM ];
+    
+    for ( i = 1; i < num_threads; i++ )
+    {
+        int error = pthread_create( &threads[ i ], NULL, nrThreadMain, &starts[ i ] );
+        assert( error == 0 );
+    }
+    
+    nrThreadMain( &starts[ 0 ] );
+    
+    for ( int j = 1; j < num_threads; j++ )
+    {
+        pthread_join( threads[ j ], NULL );
+    }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrThread::Next( volatile int& counter )
+{
+#ifdef _WIN32
+    return InterlockedIncrement( ( volatile LONG* )&counter ) - 1;
+#else
+    return __sync_fetch_and_add( &counter, 1 );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrThread::NumProcessors( void )
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    
+    int n = ( int )info.dwNumberOfProcessors;
+#else
+    int n = ( int )sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+    
+    return n > 0 ? n : 1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void nrThread::SetNumThreads( int num_threads )
+{
+    m_NumThreads = num_threads;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int nrThread::GetNumThreads( void )
+{
+    if ( m_NumThreads > 0 )
+    {
+        return m_NumThreads;
+    }
+    
+    return NumProcessors();
+}
+
+////////////////////////////////////////////////////////////////////////////
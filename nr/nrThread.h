@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// nrThread.h
+//
+// A class for running work on several threads at once.
+//
+// Run() calls a function on a number of threads (the calling thread is 
+// one of them) and waits for all of them to return.  Work is usually
+// handed out with Next(), which atomically increments a shared counter,
+// so faster threads pick up more of it.
+//
+// Nate Robins, February 2002.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef NRTHREAD_H
+#define NRTHREAD_H
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+class nrThread
+{
+public:
+    
+    // The function run on each thread.  The thread index is in 
+    // [0, num_threads).
+    typedef void ( *nrFunction )( void* data, int thread, int num_threads );
+    
+    // Call the function on num_threads threads, and wait for all of them
+    // to return.  If num_threads is 0, one thread per processor is used.
+    static void Run( nrFunction function, void* data, int num_threads = 0 );
+    
+    // Atomically increment the counter, and return its previous value.
+    static int Next( volatile int& counter );
+    
+    // Return the number of processors.
+    static int NumProcessors( void );
+    
+    // Set/Get the number of threads Run() uses by default (0 = one per
+    // processor).
+    static void SetNumThreads( int num_threads );
+    static int GetNumThreads( void );
+    
+private:
+    
+    nrThread( void );
+    ~nrThread( void );
+    
+private:
+    
+    static int m_NumThreads;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+#endif  // NRTHREAD_H
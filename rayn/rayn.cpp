@@ -14,19 +14,33 @@
 ////////////////////////////////////////////////////////////////////////////
 
 #include "nrBasis.h"
+#include "nrChannelMarble.h"
 #include "nrCmdLine.h"
 #include "nrColor.h"
+#include "nrDenoiser.h"
+#include "nrFrameBuffer.h"
 #include "nrHit.h"
 #include "nrImage.h"
+#include "nrImageWriter.h"
 #include "nrInterval.h"
+#include "nrKernel.h"
 #include "nrLight.h"
 #include "nrLog.h"
+#include "nrMaterial.h"
+#include "nrMath.h"
 #include "nrNoise.h"
+#include "nrProgram.h"
 #include "nrProgress.h"
 #include "nrRay.h"
+#include "nrRayDifferential.h"
+#include "nrSampler.h"
 #include "nrScene.h"
+#include "nrSplatBuffer.h"
 #include "nrStopWatch.h"
+#include "nrSurface.h"
 #include "nrSurfaceSphere.h"
+#include "nrSurfaceTBVH.h"
+#include "nrThread.h"
 #include "nrVector2.h"
 #include "nrVector3.h"
 #include "nrView.h"
@@ -51,120 +65,1361 @@ struct
     bool rgs;
     bool cull;
     bool sort;
+    bool tbvh;
+    bool batch;
+    int threads;
+    bool footprint;
+    bool compile;
+    bool deferred;
+    bool specialize;
+    int aa;
+    float contrast;
+    float time;         // Seconds (0 = no limit, see pass()).
+    bool stream;
+    bool async;
+    bool rle;
+    float exposure;     // Stops (see nrFrameBuffer::Resolve()).
+    float gamma;
+    bool dither;
+    int bits;
+    int denoise;        // Iterations (see nrDenoiser).
+    float blur;         // Sigma, in pixels (see nrKernel).
+    char sampler[ 16 ];
+    int sampling;       // From sampler (see NR_SAMPLER_GRID).
+    char filter[ 16 ];
+    int filtering;      // From filter (see nrSplatBuffer).
+    float radius;       // In pixels (0 = a plain box average).
+    int region[ 4 ];    // x0 y0 x1 y1, from the top left (0 0 0 0 = all).
+    bool crop;
     
 } opt;
 
+struct
+{
+    int rays;
+    int shadow_rays;
+    int refined;
+    
+} stats;
+
 
 ////////////////////////////////////////////////////////////////////////////
-// Functions
+// Defines
+////////////////////////////////////////////////////////////////////////////
+
+// Where the anti-aliasing samples go in a pixel (see Kernel::Refine()).
+#define NR_SAMPLER_GRID   0   // The centers of the quadrants.
+#define NR_SAMPLER_JITTER 1   // Random points in the quadrants.
+#define NR_SAMPLER_SOBOL  2   // Scrambled Sobol points.
+
+// Width and height of a tile (see Kernel::Tile()), in pixels.
+#define NR_TILE_SIZE   16
+#define NR_TILE_PIXELS ( NR_TILE_SIZE * NR_TILE_SIZE )
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+// The tile kernel (see Kernel::Tile()) is specialized on how the primary
+// rays are intersected with the scene, how the shadow rays are traced and
+// whether ray footprints are needed, so that none of these are decided
+// per ray.  Culling and batching need no kernels of their own, as they
+// are done to the surfaces as the scene is built.
+
+// The primary ray intersections: through whichever accelerator the scene
+// has (as nrScene::Hit()), or through a particular one.
+class HitScene
+{
+public:
+    static bool Hit( const nrScene& scene, const nrRay& ray, nrInterval& interval, nrHit& hit )
+    {
+        return scene.Hit( ray, interval, hit );
+    }
+};
+
+class HitHierarchy
+{
+public:
+    static bool Hit( const nrScene& scene, const nrRay& ray, nrInterval& interval, nrHit& hit )
+    {
+        if ( scene.m_BVH->Hit( ray, interval, hit ) )
+        {
+            interval.m_Maximum = hit.t;
+            return true;
+        }
+        
+        return false;
+    }
+};
+
+class HitGrid
+{
+public:
+    static bool Hit( const nrScene& scene, const nrRay& ray, nrInterval& interval, nrHit& hit )
+    {
+        if ( scene.m_RGS->Hit( ray, interval, hit ) )
+        {
+            interval.m_Maximum = hit.t;
+            return true;
+        }
+        
+        return false;
+    }
+};
+
+class HitList
+{
+public:
+    static bool Hit( const nrScene& scene, const nrRay& ray, nrInterval& interval, nrHit& hit )
+    {
+        bool hit_something = false;
+        
+        for ( int i = 0; i < scene.m_Surfaces.Length(); i++ )
+        {
+            if ( scene.m_Surfaces[ i ]->Hit( ray, interval, hit ) )
+            {
+                interval.m_Maximum = hit.t;
+                hit_something = true;
+            }
+        }
+        
+        return hit_something;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+// The shadow rays, from a point along l (to the light): depending on the
+// options (as nrScene::Occluded()), none, through the threaded hierarchy,
+// or through the primary ray intersections.
+class ShadowsScene
+{
+public:
+    static bool Occluded( const nrScene& scene, const nrVector3& p, const nrVector3& l )
+    {
+        if ( ! opt.shadows )
+        {
+            return false;
+        }
+        
+        stats.shadow_rays++;
+        
+        return scene.Occluded( nrRay( p, l ), nrInterval( 0.0001f, 1.0f ) );
+    }
+};
+
+class ShadowsNone
+{
+public:
+    static bool Occluded( const nrScene& scene, const nrVector3& p, const nrVector3& l )
+    {
+        return false;
+    }
+};
+
+class ShadowsTBVH
+{
+public:
+    static bool Occluded( const nrScene& scene, const nrVector3& p, const nrVector3& l )
+    {
+        stats.shadow_rays++;
+        
+        return scene.m_TBVH->Occluded( nrRay( p, l ), nrInterval( 0.0001f, 1.0f ) );
+    }
+};
+
+template < class Accelerator > class ShadowsHit
+{
+public:
+    static bool Occluded( const nrScene& scene, const nrVector3& p, const nrVector3& l )
+    {
+        stats.shadow_rays++;
+        
+        nrInterval span = nrInterval( 0.0001f, 1.0f );
+        nrHit hit;
+        
+        return Accelerator::Hit( scene, nrRay( p, l ), span, hit );
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+// The footprints of the primary rays: depending on the options, always,
+// or never.
+class FootprintOption
+{
+public:
+    static float Footprint( const nrRayDifferential& differential, const nrRay& ray, const nrHit& hit )
+    {
+        return opt.footprint ? differential.Footprint( ray, hit.t, hit.m_Normal ) : 0.0f;
+    }
+};
+
+class FootprintRay
+{
+public:
+    static float Footprint( const nrRayDifferential& differential, const nrRay& ray, const nrHit& hit )
+    {
+        return differential.Footprint( ray, hit.t, hit.m_Normal );
+    }
+};
+
+class FootprintNone
+{
+public:
+    static float Footprint( const nrRayDifferential& differential, const nrRay& ray, const nrHit& hit )
+    {
+        return 0.0f;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+// A pixel as traced by a tile, for adaptive anti-aliasing (see
+// Kernel::Antialias()): its color, and the material it hit (0 for none).
+struct Sample
+{
+    nrColor           color;
+    const nrMaterial* material;
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+// The frame being rendered: its (linear, floating point) pixels, its
+// samples (if it is to be anti-aliased), the surfaces seen through its
+// pixels (if it is to be denoised), and the splat buffer its samples are
+// filtered through (if they are, see Filter()), addressed by their
+// coordinates in the frame.  Only the pixels [ m_Left, m_Left +
+// m_Buffer.Width() ) x [ m_Top, m_Top + m_Buffer.Height() ) are held,
+// which is all of them unless the frame is streamed (see -stream) a band
+// at a time, or only a region of it is rendered (see -region).
+class Frame
+{
+public:
+    
+    Frame( int width, int height, int left, int top, int columns, int rows, bool samples, bool surfaces )
+    {
+        m_Width = width;
+        m_Height = height;
+        m_Left = left;
+        m_Top = top;
+        m_Buffer.Create( columns, rows );
+        m_Samples = samples ? new Sample[ columns * rows ] : 0;
+        m_Denoiser = 0;
+        m_Splat = 0;
+        
+        if ( surfaces )
+        {
+            m_Denoiser = new nrDenoiser;
+            m_Denoiser->Create( columns, rows );
+        }
+    }
+    
+    ~Frame( void )
+    {
+        delete [] m_Samples;
+        delete m_Denoiser;
+        delete m_Splat;
+    }
+    
+    // Filter the anti-aliasing samples (see Kernel::Antialias()) into
+    // the pixels, rather than averaging each pixel's own.  The whole frame
+    // must be held.
+    bool Filter( int filter, float radius )
+    {
+        m_Splat = new nrSplatBuffer;
+        
+        return m_Splat->Create( &m_Buffer, NR_TILE_SIZE, filter, radius );
+    }
+    
+    void SetPixel( int x, int y, const nrColor& color )
+    {
+        m_Buffer.SetPixel( x - m_Left, y - m_Top, color );
+    }
+    
+    // Splat a sample at ( x, y ) into a tile of the splat buffer (see
+    // Filter()), which is addressed from the first pixel held.
+    void Splat( nrSplatTile& tile, float x, float y, const nrColor& color, float weight ) const
+    {
+        m_Splat->Splat( tile, x - ( float )m_Left, y - ( float )m_Top, color, weight );
+    }
+    
+    // Set the surface seen through a pixel (0 for none).
+    void SetSurface( int x, int y, const nrHit* hit )
+    {
+        if ( ! m_Denoiser )
+        {
+            return;
+        }
+        
+        if ( hit && hit->m_Material )
+        {
+            m_Denoiser->SetPixel( x - m_Left, y - m_Top, hit->m_Shading, hit->t, hit->m_Material->m_ID );
+        }
+        else
+        {
+            m_Denoiser->SetPixel( x - m_Left, y - m_Top, nrVector3( 0.0f, 0.0f, 0.0f ), 0.0f, 0 );
+        }
+    }
+    
+    Sample& At( int x, int y )
+    {
+        return m_Samples[ ( y - m_Top ) * m_Buffer.Width() + x - m_Left ];
+    }
+    
+    // Return true if the pixel ( x, y ) is in the frame, and held.
+    bool Holds( int x, int y ) const
+    {
+        return x >= 0 && x < m_Width && x >= m_Left && x < m_Left + m_Buffer.Width() &&
+               y >= 0 && y < m_Height && y >= m_Top && y < m_Top + m_Buffer.Height();
+    }
+    
+    // Move the rows held down the frame, to start at row top (which is
+    // at most m_Top), keeping those of them which were already held.
+    void Scroll( int top )
+    {
+        int shift = m_Top - top;
+        int rows = m_Buffer.Height() - shift;
+        
+        if ( shift > 0 && rows > 0 )
+        {
+            memmove( m_Buffer.Pixel( 0, shift ), m_Buffer.Pixel( 0, 0 ), rows * m_Buffer.Width() * 4 * sizeof ( float ) );
+            
+            if ( m_Samples )
+            {
+                memmove( m_Samples + shift * m_Buffer.Width(), m_Samples, rows * m_Buffer.Width() * sizeof ( Sample ) );
+            }
+        }
+        
+        m_Top = top;
+    }
+    
+public:
+    
+    int m_Width;
+    int m_Height;
+    int m_Left;
+    int m_Top;
+    nrFrameBuffer m_Buffer;
+    Sample* m_Samples;
+    nrDenoiser* m_Denoiser;
+    nrSplatBuffer* m_Splat;
+};
+
 ////////////////////////////////////////////////////////////////////////////
 
-inline nrColor light( nrScene& scene, nrRay& ray, nrHit& hit )
+typedef void ( *nrTileKernel )( nrScene& scene, const nrRayDifferential& differential, Frame& frame,
+                                int x0, int y0, int x1, int y1, int step, int skip );
+
+typedef void ( *nrAntialiasKernel )( nrScene& scene, const nrRayDifferential& differential, Frame& frame,
+                                     int x0, int y0, int x1, int y1 );
+
+template < class Accelerator, class Shadows, class Footprints > class Kernel
 {
-    const nrSurface& surface = hit.Surface();
+public:
+    
+    // Trace the primary ray through ( x, y ) (in pixels) on the frame,
+    // and return true if it hit something (and the footprint at the hit).
+    static bool Primary( nrScene& scene, const nrRayDifferential& differential, const Frame& frame, float x, float y,
+                         nrRay& ray, nrHit& hit, float& footprint );
+    
+    // Trace the pixels [ x0, x1 ) x [ y0, y1 ) of the frame, and keep
+    // them in its samples (if any).  Only
+    // every step-th pixel (in x and y) is traced, and fills the step x
+    // step block below and to the right of it; pixels on every skip-th
+    // row and column (if skip isn't 0) were traced by an earlier, coarser
+    // pass and are left as they are.  x0 and y0 must be multiples of
+    // step and skip.
+    static void Tile( nrScene& scene, const nrRayDifferential& differential, Frame& frame,
+                      int x0, int y0, int x1, int y1, int step, int skip );
+    
+    // Supersample the pixels [ x0, x1 ) x [ y0, y1 ) of the frame which
+    // differ from a neighbor (see differ()), given the samples from
+    // Tile() (of the rows on either side, too).  If the frame has a splat
+    // buffer, the tile's samples (those from Tile() of the pixels which
+    // don't differ, and the supersamples of those which do) are splatted
+    // into it, weighted by the area each stands for.
+    static void Antialias( nrScene& scene, const nrRayDifferential& differential, Frame& frame,
+                           int x0, int y0, int x1, int y1 );
+    
+    // Return the tile and anti-aliasing kernels.
+    static void Kernels( nrTileKernel& tile, nrAntialiasKernel& antialias );
+    
+private:
     
+    // Trace (and shade and light) a single sample through ( x, y ).
+    static void Shade( nrScene& scene, const nrRayDifferential& differential, const Frame& frame, float x, float y,
+                       Sample& sample );
+    
+    // Return the color of the square of the given size (in pixels)
+    // centered on ( x, y ): the average of a sample in each quadrant
+    // (placed by the sampler, see NR_SAMPLER_GRID), with the quadrants
+    // whose samples differ from the others refined in turn, down to the
+    // given depth.  The square is in pixel ( i, j ), and path numbers the
+    // squares within it (for the sampler).  If tile isn't 0, the samples
+    // are splatted into it, too (see nrSplatBuffer).
+    static nrColor Refine( nrScene& scene, const nrRayDifferential& differential, const Frame& frame, 
+                           float x, float y, float size, int depth, int i, int j, unsigned int path, nrSplatTile* tile );
+};
+
+// The generic kernel, which checks the options as it goes.
+typedef Kernel< HitScene, ShadowsScene, FootprintOption > GenericKernel;
+
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+inline nrColor light( nrScene& scene, nrRay& ray, nrHit& hit, const nrColor& Ma, const nrColor& Md )
+{
     const nrColor& Ga = scene.Ambient();
     
-    nrVector3 p = ray.Point( hit.t );
-    nrVector3 n = surface.Normal( p );
+    nrVector3 p = ray.Point( hit.t );
+    const nrVector3& n = hit.m_Shading;
+    
+    const nrArray<nrLight*>& lights = scene.m_Lights;
+    
+    nrColor color = Ga + Ma;
+    
+    for ( int i = 0; i < lights.Length(); i++ )
+    {
+        const nrLight* light = lights[ i ];
+        
+        nrVector3 l = ( light->m_Position - p );
+        
+        if ( opt.shadows )
+        {
+            nrRay shadow_ray = nrRay( p, l );
+            nrInterval shadow_interval = nrInterval( 0.0001f, 1.0f );
+            
+            stats.shadow_rays++;
+            
+            if ( ! scene.Occluded( shadow_ray, shadow_interval ) )
+            {
+                l = l.Unit();
+                
+                const nrColor& Ld = light->Color();
+                
+                nrColor diffuse = Md * Ld * ( n.Dot( l ) );
+                
+                color = color + diffuse.Clamp();
+            }
+            else
+            {
+                // In shadow, so don't add contribution from this light.
+            }
+        }
+        else
+        {
+            l = l.Unit();
+            
+            const nrColor& Ld = light->Color();
+            
+            nrColor diffuse = Md * Ld * ( n.Dot( l ) );
+            
+            color = color + diffuse.Clamp();
+        }
+    }
+    
+    return color.Clamp();
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+inline void shade( nrRay* rays, nrHit* hits, bool* hit, float* footprints, int count, nrColor* Ma, nrColor* Md, nrColor* Ms )
+{
+    int i;
+    
+    if ( ! opt.compile )
+    {
+        for ( i = 0; i < count; i++ )
+        {
+            if ( hit[ i ] )
+            {
+                nrVector3 p = rays[ i ].Point( hits[ i ].t );
+                hits[ i ].m_Material->Evaluate( p, footprints[ i ], Ma[ i ], Md[ i ], Ms[ i ] );
+            }
+        }
+        
+        return;
+    }
+    
+    // Gather the points which hit the same material, and evaluate them 
+    // together.
+    bool done[ NR_PROGRAM_BATCH ];
+    for ( i = 0; i < count; i++ )
+    {
+        done[ i ] = ! hit[ i ];
+    }
+    
+    for ( int j = 0; j < count; j++ )
+    {
+        if ( done[ j ] )
+        {
+            continue;
+        }
+        
+        const nrMaterial* material = hits[ j ].m_Material;
+        
+        float x[ NR_PROGRAM_BATCH ];
+        float y[ NR_PROGRAM_BATCH ];
+        float z[ NR_PROGRAM_BATCH ];
+        float footprint[ NR_PROGRAM_BATCH ];
+        int index[ NR_PROGRAM_BATCH ];
+        int n = 0;
+        
+        for ( int k = j; k < count; k++ )
+        {
+            if ( ! done[ k ] && hits[ k ].m_Material == material )
+            {
+                nrVector3 p = rays[ k ].Point( hits[ k ].t );
+                
+                x[ n ] = p.x;
+                y[ n ] = p.y;
+                z[ n ] = p.z;
+                footprint[ n ] = footprints[ k ];
+                index[ n ] = k;
+                n++;
+                
+                done[ k ] = true;
+            }
+        }
+        
+        nrColor a[ NR_PROGRAM_BATCH ];
+        nrColor d[ NR_PROGRAM_BATCH ];
+        nrColor s[ NR_PROGRAM_BATCH ];
+        
+        material->Evaluate( x, y, z, footprint, n, a, d, s );
+        
+        for ( int l = 0; l < n; l++ )
+        {
+            Ma[ index[ l ] ] = a[ l ];
+            Md[ index[ l ] ] = d[ l ];
+            Ms[ index[ l ] ] = s[ l ];
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+// Return true if two samples hit different materials (or one hit nothing),
+// or differ by more than the contrast threshold in any channel.
+inline bool differ( const Sample& a, const Sample& b )
+{
+    return a.material != b.material ||
+           nrMath::Abs( a.color.r - b.color.r ) > opt.contrast ||
+           nrMath::Abs( a.color.g - b.color.g ) > opt.contrast ||
+           nrMath::Abs( a.color.b - b.color.b ) > opt.contrast;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template < class Accelerator, class Shadows, class Footprints > 
+bool Kernel< Accelerator, Shadows, Footprints >::Primary( nrScene& scene, const nrRayDifferential& differential, const Frame& frame, 
+                                                        float x, float y, nrRay& ray, nrHit& hit, float& footprint )
+{
+    const nrBasis& onb = scene.m_View->m_Basis;
+    const nrVector3& origin = scene.m_View->m_Eye;
+    const nrVector2& a = scene.m_View->m_BottomLeft;
+    const nrVector2& b = scene.m_View->m_TopRight;
+    
+    float dx = ( a.x + ( b.x - a.x ) * x / ( float )( frame.m_Width  - 1 ) );
+    float dy = ( a.y + ( b.y - a.y ) * y / ( float )( frame.m_Height - 1 ) );
+    float dz = -scene.m_View->m_Distance;
+    nrVector3 direction = onb.u * dx + onb.v * dy + onb.w * dz;
+    
+    ray = nrRay( origin, direction );
+    nrInterval interval = nrInterval( 0.0f, 2e30f );
+    
+    stats.rays++;
+    
+    bool is_hit = Accelerator::Hit( scene, ray, interval, hit );
+    
+    footprint = 0.0f;
+    if ( is_hit )
+    {
+        footprint = Footprints::Footprint( differential, ray, hit );
+    }
+    
+    return is_hit;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+// A tile is traced in three passes, so that each pass keeps its own code
+// and data in the caches: first the primary rays, into a G-buffer of
+// hits; then the materials, with the hits binned by material so each bin
+// is evaluated in batches; then the lighting, one light at a time, so all
+// of the shadow rays towards a light are traced together.  The results
+// are the same as tracing a row at a time.
+template < class Accelerator, class Shadows, class Footprints > 
+void Kernel< Accelerator, Shadows, Footprints >::Tile( nrScene& scene, const nrRayDifferential& differential, Frame& frame, 
+                                                     int x0, int y0, int x1, int y1, int step, int skip )
+{
+    nrRay rays[ NR_TILE_PIXELS ];
+    nrHit hits[ NR_TILE_PIXELS ];
+    bool hit[ NR_TILE_PIXELS ];
+    float footprints[ NR_TILE_PIXELS ];
+    nrVector3 points[ NR_TILE_PIXELS ];
+    int px[ NR_TILE_PIXELS ];
+    int py[ NR_TILE_PIXELS ];
+    int count = 0;
+    
+    int i, j, k;
+    for ( j = y0; j < y1; j += step )
+    {
+        for ( i = x0; i < x1; i += step )
+        {
+            if ( skip && i % skip == 0 && j % skip == 0 )
+            {
+                continue;
+            }
+            
+            px[ count ] = i;
+            py[ count ] = j;
+            
+            hit[ count ] = Primary( scene, differential, frame, ( float )i, ( float )j, rays[ count ], hits[ count ], footprints[ count ] );
+            
+            if ( hit[ count ] )
+            {
+                points[ count ] = rays[ count ].Point( hits[ count ].t );
+            }
+            
+            count++;
+        }
+    }
+    
+    // Bin the hits by material (a counting sort, so each bin stays in
+    // scan order).
+    const nrMaterial* materials[ NR_TILE_PIXELS ];
+    int bins[ NR_TILE_PIXELS ];
+    int starts[ NR_TILE_PIXELS + 1 ];
+    int ends[ NR_TILE_PIXELS ];
+    int order[ NR_TILE_PIXELS ];
+    int num_materials = 0;
+    
+    for ( k = 0; k < count; k++ )
+    {
+        if ( ! hit[ k ] )
+        {
+            continue;
+        }
+        
+        int m = 0;
+        while ( m < num_materials && materials[ m ] != hits[ k ].m_Material )
+        {
+            m++;
+        }
+        
+        if ( m == num_materials )
+        {
+            materials[ m ] = hits[ k ].m_Material;
+            starts[ m ] = 0;
+            num_materials++;
+        }
+        
+        bins[ k ] = m;
+        starts[ m ]++;
+    }
+    
+    int total = 0;
+    int m;
+    for ( m = 0; m < num_materials; m++ )
+    {
+        int n = starts[ m ];
+        starts[ m ] = total;
+        ends[ m ] = total;
+        total += n;
+    }
+    starts[ num_materials ] = total;
+    
+    for ( k = 0; k < count; k++ )
+    {
+        if ( hit[ k ] )
+        {
+            order[ ends[ bins[ k ] ]++ ] = k;
+        }
+    }
+    
+    // Evaluate the materials, a bin at a time.
+    nrColor Ma[ NR_TILE_PIXELS ];
+    nrColor Md[ NR_TILE_PIXELS ];
+    
+    for ( m = 0; m < num_materials; m++ )
+    {
+        const nrMaterial* material = materials[ m ];
+        
+        for ( int first = starts[ m ]; first < starts[ m + 1 ]; first += NR_PROGRAM_BATCH )
+        {
+            int n = nrMath::Min( starts[ m + 1 ] - first, NR_PROGRAM_BATCH );
+            int l;
+            
+            if ( ! opt.compile )
+            {
+                for ( l = 0; l < n; l++ )
+                {
+                    nrColor s;
+                    k = order[ first + l ];
+                    material->Evaluate( points[ k ], footprints[ k ], Ma[ k ], Md[ k ], s );
+                }
+                
+                continue;
+            }
+            
+            float x[ NR_PROGRAM_BATCH ];
+            float y[ NR_PROGRAM_BATCH ];
+            float z[ NR_PROGRAM_BATCH ];
+            float footprint[ NR_PROGRAM_BATCH ];
+            
+            for ( l = 0; l < n; l++ )
+            {
+                k = order[ first + l ];
+                
+                x[ l ] = points[ k ].x;
+                y[ l ] = points[ k ].y;
+                z[ l ] = points[ k ].z;
+                footprint[ l ] = footprints[ k ];
+            }
+            
+            nrColor a[ NR_PROGRAM_BATCH ];
+            nrColor d[ NR_PROGRAM_BATCH ];
+            nrColor s[ NR_PROGRAM_BATCH ];
+            
+            material->Evaluate( x, y, z, footprint, n, a, d, s );
+            
+            for ( l = 0; l < n; l++ )
+            {
+                k = order[ first + l ];
+                
+                Ma[ k ] = a[ l ];
+                Md[ k ] = d[ l ];
+            }
+        }
+    }
+    
+    // Light the hits, a light at a time (the same sums as light()).
+    nrColor colors[ NR_TILE_PIXELS ];
+    
+    for ( k = 0; k < count; k++ )
+    {
+        if ( hit[ k ] )
+        {
+            colors[ k ] = scene.Ambient() + Ma[ k ];
+        }
+    }
+    
+    const nrArray<nrLight*>& lights = scene.m_Lights;
+    
+    for ( int l = 0; l < lights.Length(); l++ )
+    {
+        const nrLight* light = lights[ l ];
+        const nrColor& Ld = light->Color();
+        
+        for ( k = 0; k < count; k++ )
+        {
+            if ( ! hit[ k ] )
+            {
+                continue;
+            }
+            
+            nrVector3 v = ( light->m_Position - points[ k ] );
+            
+            if ( Shadows::Occluded( scene, points[ k ], v ) )
+            {
+                continue;
+            }
+            
+            v = v.Unit();
+            
+            nrColor diffuse = Md[ k ] * Ld * ( hits[ k ].m_Shading.Dot( v ) );
+            
+            colors[ k ] = colors[ k ] + diffuse.Clamp();
+        }
+    }
+    
+    for ( k = 0; k < count; k++ )
+    {
+        Sample sample;
+        
+        if ( hit[ k ] )
+        {
+            sample.color = colors[ k ].Clamp();
+            sample.material = hits[ k ].m_Material;
+        }
+        else
+        {
+            sample.color = scene.Background();
+            sample.material = 0;
+        }
+        
+        int bx = nrMath::Min( px[ k ] + step, x1 );
+        int by = nrMath::Min( py[ k ] + step, y1 );
+        
+        for ( j = py[ k ]; j < by; j++ )
+        {
+            for ( i = px[ k ]; i < bx; i++ )
+            {
+                frame.SetPixel( i, j, sample.color );
+                frame.SetSurface( i, j, hit[ k ] ? &hits[ k ] : 0 );
+            }
+        }
+        
+        if ( frame.m_Samples )
+        {
+            frame.At( px[ k ], py[ k ] ) = sample;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template < class Accelerator, class Shadows, class Footprints > 
+void Kernel< Accelerator, Shadows, Footprints >::Antialias( nrScene& scene, const nrRayDifferential& differential, Frame& frame, 
+                                                          int x0, int y0, int x1, int y1 )
+{
+    int w = frame.m_Buffer.Width();
+    
+    nrSplatBuffer* splat = frame.m_Splat;
+    nrSplatTile tile;
+    
+    if ( splat )
+    {
+        splat->Begin( tile, x0 - frame.m_Left, y0 - frame.m_Top, x1 - frame.m_Left, y1 - frame.m_Top );
+    }
+    
+    for ( int j = y0; j < y1; j++ )
+    {
+        for ( int i = x0; i < x1; i++ )
+        {
+            const Sample* s = &frame.At( i, j );
+            
+            if ( ( frame.Holds( i - 1, j ) && differ( *s, *( s - 1 ) ) ) ||
+                 ( frame.Holds( i + 1, j ) && differ( *s, *( s + 1 ) ) ) ||
+                 ( frame.Holds( i, j - 1 ) && differ( *s, *( s - w ) ) ) ||
+                 ( frame.Holds( i, j + 1 ) && differ( *s, *( s + w ) ) ) )
+            {
+                stats.refined++;
+                
+                nrColor color = Refine( scene, differential, frame, ( float )i, ( float )j, 1.0f, opt.aa, i, j, 0, 
+                                        splat ? &tile : 0 );
+                frame.SetPixel( i, j, color );
+            }
+            else if ( splat )
+            {
+                frame.Splat( tile, ( float )i, ( float )j, s->color, 1.0f );
+            }
+        }
+    }
+    
+    if ( splat )
+    {
+        splat->End( tile );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template < class Accelerator, class Shadows, class Footprints > 
+void Kernel< Accelerator, Shadows, Footprints >::Kernels( nrTileKernel& tile, nrAntialiasKernel& antialias )
+{
+    tile = &Tile;
+    antialias = &Antialias;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Private
+////////////////////////////////////////////////////////////////////////////
+
+template < class Accelerator, class Shadows, class Footprints > 
+void Kernel< Accelerator, Shadows, Footprints >::Shade( nrScene& scene, const nrRayDifferential& differential, const Frame& frame, 
+                                                      float x, float y, Sample& sample )
+{
+    nrRay ray;
+    nrHit hit;
+    float footprint;
+    
+    if ( ! Primary( scene, differential, frame, x, y, ray, hit, footprint ) )
+    {
+        sample.color = scene.Background();
+        sample.material = 0;
+        return;
+    }
+    
+    nrVector3 p = ray.Point( hit.t );
+    
+    nrColor Ma, Md, Ms;
+    hit.m_Material->Evaluate( p, footprint, Ma, Md, Ms );
+    
+    // The same sums as Tile().
+    nrColor color = scene.Ambient() + Ma;
+    
+    const nrArray<nrLight*>& lights = scene.m_Lights;
+    
+    for ( int l = 0; l < lights.Length(); l++ )
+    {
+        const nrLight* light = lights[ l ];
+        
+        nrVector3 v = ( light->m_Position - p );
+        
+        if ( Shadows::Occluded( scene, p, v ) )
+        {
+            continue;
+        }
+        
+        v = v.Unit();
+        
+        nrColor diffuse = Md * light->Color() * ( hit.m_Shading.Dot( v ) );
+        
+        color = color + diffuse.Clamp();
+    }
+    
+    sample.color = color.Clamp();
+    sample.material = hit.m_Material;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+template < class Accelerator, class Shadows, class Footprints > 
+nrColor Kernel< Accelerator, Shadows, Footprints >::Refine( nrScene& scene, const nrRayDifferential& differential, const Frame& frame, 
+                                                          float x, float y, float size, int depth, int i, int j, unsigned int path, 
+                                                          nrSplatTile* tile )
+{
+    // The samples are half the size apart, so their footprints shrink to
+    // match.
+    float d = size * 0.5f;
+    nrRayDifferential subdifferential( differential.m_dDdx * d, differential.m_dDdy * d );
+    
+    // The centers of the quadrants.
+    float h = size * 0.25f;
+    float u[ 4 ] = { x - h, x + h, x - h, x + h };
+    float v[ 4 ] = { y - h, y - h, y + h, y + h };
+    
+    // The samples, by quadrant (the first four points of the Sobol
+    // sequence are one in each).
+    float su[ 4 ];
+    float sv[ 4 ];
+    
+    nrSampler sampler( i, j, path );
+    
+    int q;
+    for ( q = 0; q < 4; q++ )
+    {
+        if ( opt.sampling == NR_SAMPLER_SOBOL )
+        {
+            float s, t;
+            sampler.Sobol( q, nrSampler::DIMENSION_PIXEL, s, t );
+            
+            int k = ( s < 0.5f ? 0 : 1 ) + ( t < 0.5f ? 0 : 2 );
+            su[ k ] = x + ( s - 0.5f ) * size;
+            sv[ k ] = y + ( t - 0.5f ) * size;
+        }
+        else if ( opt.sampling == NR_SAMPLER_JITTER )
+        {
+            su[ q ] = u[ q ] + ( sampler.Random( q, 0 ) - 0.5f ) * d;
+            sv[ q ] = v[ q ] + ( sampler.Random( q, 1 ) - 0.5f ) * d;
+        }
+        else
+        {
+            su[ q ] = u[ q ];
+            sv[ q ] = v[ q ];
+        }
+    }
+    
+    Sample samples[ 4 ];
+    
+    for ( q = 0; q < 4; q++ )
+    {
+        Shade( scene, subdifferential, frame, su[ q ], sv[ q ], samples[ q ] );
+    }
+    
+    nrColor color( 0, 0, 0 );
+    
+    for ( q = 0; q < 4; q++ )
+    {
+        bool refine = false;
+        
+        if ( depth > 1 )
+        {
+            for ( int r = 0; r < 4; r++ )
+            {
+                if ( r != q && differ( samples[ q ], samples[ r ] ) )
+                {
+                    refine = true;
+                }
+            }
+        }
+        
+        if ( refine )
+        {
+            color = color + Refine( scene, differential, frame, u[ q ], v[ q ], d, depth - 1, i, j, path * 4 + q + 1, tile );
+        }
+        else
+        {
+            color = color + samples[ q ].color;
+            
+            if ( tile )
+            {
+                frame.Splat( *tile, su[ q ], sv[ q ], samples[ q ].color, d * d );
+            }
+        }
+    }
+    
+    return color * 0.25f;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+// Return the tile and anti-aliasing kernels for the scene and options.
+template < class Accelerator > class Specialize
+{
+public:
+    static void Kernels( const nrScene& scene, nrTileKernel& tile, nrAntialiasKernel& antialias )
+    {
+        if ( ! opt.shadows )
+        {
+            if ( opt.footprint )
+            {
+                Kernel< Accelerator, ShadowsNone, FootprintRay >::Kernels( tile, antialias );
+            }
+            else
+            {
+                Kernel< Accelerator, ShadowsNone, FootprintNone >::Kernels( tile, antialias );
+            }
+        }
+        else if ( scene.m_TBVH != 0 )
+        {
+            if ( opt.footprint )
+            {
+                Kernel< Accelerator, ShadowsTBVH, FootprintRay >::Kernels( tile, antialias );
+            }
+            else
+            {
+                Kernel< Accelerator, ShadowsTBVH, FootprintNone >::Kernels( tile, antialias );
+            }
+        }
+        else
+        {
+            if ( opt.footprint )
+            {
+                Kernel< Accelerator, ShadowsHit< Accelerator >, FootprintRay >::Kernels( tile, antialias );
+            }
+            else
+            {
+                Kernel< Accelerator, ShadowsHit< Accelerator >, FootprintNone >::Kernels( tile, antialias );
+            }
+        }
+    }
+};
+
+inline void kernels( const nrScene& scene, nrTileKernel& tile, nrAntialiasKernel& antialias )
+{
+    if ( ! opt.specialize )
+    {
+        GenericKernel::Kernels( tile, antialias );
+    }
+    else if ( scene.m_BVH != 0 )
+    {
+        Specialize< HitHierarchy >::Kernels( scene, tile, antialias );
+    }
+    else if ( scene.m_RGS != 0 )
+    {
+        Specialize< HitGrid >::Kernels( scene, tile, antialias );
+    }
+    else
+    {
+        Specialize< HitList >::Kernels( scene, tile, antialias );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+// Run a pass of the tile kernel (with the given step and skip, see
+// Kernel::Tile()) or, if tile is 0, of the anti-aliasing kernel over the
+// rows [ y0, y1 ) of the columns held of the frame, a tile at a time.  If
+// there is a time limit, return false (and leave the rest of the tiles as
+// they are) as soon as the clock passes it.
+inline bool pass( nrScene& scene, const nrRayDifferential& differential, Frame& frame, nrTileKernel tile, nrAntialiasKernel antialias,
+                  int step, int skip, int y0, int y1, nrProgress& progress, nrStopWatch& clock )
+{
+    for ( int y = y0; y < y1; y += NR_TILE_SIZE )
+    {
+        int right = nrMath::Min( frame.m_Left + frame.m_Buffer.Width(), frame.m_Width );
+        
+        for ( int x = frame.m_Left; x < right; x += NR_TILE_SIZE )
+        {
+            int x1 = nrMath::Min( x + NR_TILE_SIZE, right );
+            int y1 = nrMath::Min( y + NR_TILE_SIZE, frame.m_Height );
+            
+            if ( tile )
+            {
+                tile( scene, differential, frame, x, y, x1, y1, step, skip );
+            }
+            else
+            {
+                antialias( scene, differential, frame, x, y, x1, y1 );
+            }
+            
+            progress.Update( ( x1 - x ) * ( y1 - y ) );
+            
+            if ( opt.time > 0.0f )
+            {
+                // The clock has to be stopped to be read.
+                clock.Stop();
+                bool expired = clock.Elapsed() >= opt.time;
+                clock.Start();
+                
+                if ( expired )
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+// Render the frame.  If streaming, the frame holds a band of rows at a
+// time, and each band is written (or posted, see stream()) as soon as it
+// is finished; otherwise, the pixels the frame holds (all of them, unless
+// only a region is rendered) are left to be written.
+inline void trace( nrScene& scene, Frame& frame, nrImageWriter& writer )
+{
+    const nrBasis& onb = scene.m_View->m_Basis;
+    const nrVector2& a = scene.m_View->m_BottomLeft;
+    const nrVector2& b = scene.m_View->m_TopRight;
+    
+    int w = frame.m_Width;
+    int h = frame.m_Height;
     
-    nrColor Ma = surface.Material()->Ambient( p );
-    nrColor Md = surface.Material()->Diffuse( p );
+    // The primary rays all start at the eye, and their directions change
+    // by the same amount from pixel to pixel.
+    nrRayDifferential differential( 
+        onb.u * ( ( b.x - a.x ) / ( float )( w - 1 ) ),
+        onb.v * ( ( b.y - a.y ) / ( float )( h - 1 ) ) );
     
-    const nrArray<nrLight*>& lights = scene.m_Lights;
+    // The pixels held, if not streaming.
+    int x0 = frame.m_Left;
+    int y0 = frame.m_Top;
+    int x1 = x0 + frame.m_Buffer.Width();
+    int y1 = y0 + frame.m_Buffer.Height();
+    int n = frame.m_Buffer.Width() * frame.m_Buffer.Height();
     
-    nrColor color = Ga + Ma;
+    nrProgress progress;
     
-    for ( int i = 0; i < lights.Length(); i++ )
+    if ( opt.deferred )
     {
-        const nrLight* light = lights[ i ];
+        // Pick the kernels once, rather than checking the options per ray.
+        nrTileKernel tile;
+        nrAntialiasKernel antialias;
+        kernels( scene, tile, antialias );
         
-        nrVector3 l = ( light->m_Position - p );
+        nrStopWatch clock;
+        clock.Reset();
+        clock.Start();
         
-        if ( opt.shadows )
+        if ( opt.stream )
         {
-            nrRay shadow_ray = nrRay( p, l );
-            nrInterval shadow_interval = nrInterval( 0.0001f, 1.0f );
-            nrHit shadow_hit;
+            // A band (a row of tiles) at a time, from the top down.  A
+            // band is anti-aliased (which needs the rows on either side
+            // of it) once the band below it has been traced, so the frame
+            // holds the bands on either side of it, too.
+            int lag = frame.m_Samples ? NR_TILE_SIZE : 0;
+            int top = ( ( h - 1 ) / NR_TILE_SIZE ) * NR_TILE_SIZE;
+            
+            progress.Reset( frame.m_Samples ? 2 * w * h : w * h );
             
-            if ( ! scene.Hit( shadow_ray, shadow_interval, shadow_hit ) )
+            frame.m_Top = top;
+            
+            for ( int y = top; y + lag >= 0; y -= NR_TILE_SIZE )
             {
-                l = l.Unit();
-                
-                const nrColor& Ld = light->Color();
+                frame.Scroll( y );
                 
-                nrColor diffuse = Md * Ld * ( n.Dot( l ) );
+                if ( y >= 0 )
+                {
+                    pass( scene, differential, frame, tile, 0, 1, 0, y, nrMath::Min( y + NR_TILE_SIZE, h ), progress, clock );
+                }
                 
-                color = color + diffuse.Clamp();
+                int band = y + lag;
+                if ( band <= top )
+                {
+                    int end = nrMath::Min( band + NR_TILE_SIZE, h );
+                    
+                    if ( frame.m_Samples )
+                    {
+                        pass( scene, differential, frame, 0, antialias, 1, 0, band, end, progress, clock );
+                    }
+                    
+                    if ( opt.async )
+                    {
+                        writer.Post( frame.m_Buffer, band - frame.m_Top, end - band );
+                    }
+                    else
+                    {
+                        writer.Write( frame.m_Buffer, band - frame.m_Top, end - band );
+                    }
+                }
             }
-            else
+        }
+        else if ( opt.time > 0.0f )
+        {
+            // Progressively: every 4th pixel (so there is an image, however
+            // coarse, whatever the time limit), then every 2nd, then the
+            // rest, then anti-alias.  Each pass only traces the pixels the
+            // ones before it didn't, so no ray is traced twice.
+            int passes = 1;
+            
+            progress.Reset( n );
+            pass( scene, differential, frame, tile, 0, 4, 0, y0, y1, progress, clock );
+            
+            progress.Reset( n );
+            if ( pass( scene, differential, frame, tile, 0, 2, 4, y0, y1, progress, clock ) )
             {
-                // In shadow, so don't add contribution from this light.
+                passes++;
+                
+                progress.Reset( n );
+                if ( pass( scene, differential, frame, tile, 0, 1, 2, y0, y1, progress, clock ) )
+                {
+                    passes++;
+                    
+                    progress.Reset( n );
+                    if ( pass( scene, differential, frame, 0, antialias, 1, 0, y0, y1, progress, clock ) )
+                    {
+                        passes++;
+                    }
+                }
             }
+            
+            g_Log.Write( "%d of 4 progressive passes finished (%g second limit).\n", passes, opt.time );
         }
         else
         {
-            l = l.Unit();
-            
-            const nrColor& Ld = light->Color();
-            
-            nrColor diffuse = Md * Ld * ( n.Dot( l ) );
+            progress.Reset( n );
+            pass( scene, differential, frame, tile, 0, 1, 0, y0, y1, progress, clock );
             
-            color = color + diffuse.Clamp();
+            if ( frame.m_Samples )
+            {
+                progress.Reset( n );
+                pass( scene, differential, frame, 0, antialias, 1, 0, y0, y1, progress, clock );
+            }
         }
+        
+        return;
     }
     
-    return color.Clamp();
-}
-
-////////////////////////////////////////////////////////////////////////////
-
-inline void trace( nrScene& scene, nrImage& image )
-{
-    const nrBasis& onb = scene.m_View->m_Basis;
-    const nrVector3& origin = scene.m_View->m_Eye;
-    const nrVector2& a = scene.m_View->m_BottomLeft;
-    const nrVector2& b = scene.m_View->m_TopRight;
+    progress.Reset( n );
     
-    nrProgress progress;
-    progress.Reset( image.Width() * image.Height() );
-
-    for ( int j = 0; j < image.Height(); j++ )
+    // A row is traced a batch of pixels at a time: first the primary
+    // rays, then the materials at all of the hits, then the lighting.
+    nrRay rays[ NR_PROGRAM_BATCH ];
+    nrHit hits[ NR_PROGRAM_BATCH ];
+    bool hit[ NR_PROGRAM_BATCH ];
+    float footprints[ NR_PROGRAM_BATCH ];
+    nrColor Ma[ NR_PROGRAM_BATCH ];
+    nrColor Md[ NR_PROGRAM_BATCH ];
+    nrColor Ms[ NR_PROGRAM_BATCH ];
+    
+    for ( int j = y0; j < y1; j++ )
     {
-        for ( int i = 0; i < image.Width(); i++ )
+        for ( int first = x0; first < x1; first += NR_PROGRAM_BATCH )
         {
-            float dx = ( a.x + ( b.x - a.x ) * ( float )i / ( float )( image.Width()  - 1 ) );
-            float dy = ( a.y + ( b.y - a.y ) * ( float )j / ( float )( image.Height() - 1 ) );
-            float dz = -scene.m_View->m_Distance;
-            nrVector3 direction = onb.u * dx + onb.v * dy + onb.w * dz;
+            int count = nrMath::Min( x1 - first, NR_PROGRAM_BATCH );
             
-            nrRay ray = nrRay( origin, direction );
-            nrInterval interval = nrInterval( 0.0f, 2e30f );
-            nrHit hit;
-            
-            nrColor color;
-            
-            if ( scene.Hit( ray, interval, hit ) )
-            {
-                color = light( scene, ray, hit );
-            }
-            else
+            int k;
+            for ( k = 0; k < count; k++ )
             {
-                color = scene.Background();
+                hit[ k ] = GenericKernel::Primary( scene, differential, frame, ( float )( first + k ), ( float )j, rays[ k ], hits[ k ], footprints[ k ] );
             }
             
-            unsigned char r = ( unsigned char )( color.r * 255 );
-            unsigned char g = ( unsigned char )( color.g * 255 );
-            unsigned char b = ( unsigned char )( color.b * 255 );
-            image.SetPixel( i, j, nrPixel( r, g, b ) );
+            shade( rays, hits, hit, footprints, count, Ma, Md, Ms );
             
-            progress.Update();
+            for ( k = 0; k < count; k++ )
+            {
+                nrColor color;
+                
+                if ( hit[ k ] )
+                {
+                    color = light( scene, rays[ k ], hits[ k ], Ma[ k ], Md[ k ] );
+                }
+                else
+                {
+                    color = scene.Background();
+                }
+                
+                frame.SetPixel( first + k, j, color );
+                frame.SetSurface( first + k, j, hit[ k ] ? &hits[ k ] : 0 );
+                
+                progress.Update();
+            }
         }
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////
 
+// What stream() renders.
+struct Render
+{
+    nrScene*       scene;
+    Frame*         frame;
+    nrImageWriter* writer;
+};
+
+// Render (see trace()) on thread 0, posting each band to the writer as it
+// is finished, while thread 1 encodes and writes them.
+inline void stream( void* data, int thread, int num_threads )
+{
+    Render* render = ( Render* )data;
+    
+    if ( thread == 0 )
+    {
+        trace( *render->scene, *render->frame, *render->writer );
+        render->writer->Finish();
+    }
+    else
+    {
+        render->writer->Serve();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+// Composite the region [ x0, x1 ) x [ y0, y1 ) of the frame (resolved as
+// the writer would, see nrFrameBuffer::Resolve()) into an image of the
+// whole frame, read from a file.  nrImage keeps the rows of a PPM file as
+// they are in it, top down, and those of a TGA file bottom up, as the
+// frame is.
+inline void composite( const Frame& frame, int x0, int y0, int x1, int y1, nrImage& image, bool top_down )
+{
+    const nrFrameBuffer& buffer = frame.m_Buffer;
+    
+    int w = x1 - x0;
+    int h = y1 - y0;
+    
+    unsigned char* row = new unsigned char[ buffer.Width() * 3 ];
+    unsigned char* pixels = new unsigned char[ w * h * 3 ];
+    
+    // The rows held are resolved whole, so that their dithers line up
+    // with those of the whole frame.
+    for ( int j = 0; j < h; j++ )
+    {
+        buffer.Resolve( y0 + j - frame.m_Top, opt.exposure, opt.gamma, opt.dither, 8, row );
+        memcpy( pixels + ( top_down ? h - 1 - j : j ) * w * 3, row + ( x0 - frame.m_Left ) * 3, w * 3 );
+    }
+    
+    nrImage region;
+    region.CreateFromBytes( w, h, 3, pixels );
+    image.CopySub( region, 0, 0, w, h, x0, top_down ? frame.m_Height - y1 : y0 );
+    
+    delete [] row;
+    delete [] pixels;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 int main( int argc, const char** argv )
 {
     // Enumerate the command line arguments.
@@ -179,6 +1434,30 @@ int main( int argc, const char** argv )
         nrCmdLineArg( "-bvh",     "<true/false>",       "false", "generate bounding volume hierarchy", opt.bvh ),
         nrCmdLineArg( "-sort",    "<true/false>",       "false", "sort (not split) surfaces (bvh)",    opt.sort ),
         nrCmdLineArg( "-cull",    "<true/false>",       "false", "cull backfacing triangles",          opt.cull ),
+        nrCmdLineArg( "-batch",   "<true/false>",       "false", "batch primitives by type (simd)",    opt.batch ),
+        nrCmdLineArg( "-tbvh",    "<true/false>",       "false", "threaded bvh for shadow rays",       opt.tbvh ),
+        nrCmdLineArg( "-threads", "<count>",                "0", "number of threads (0 = processors)", opt.threads ),
+        nrCmdLineArg( "-footprint", "<true/false>",      "true", "skip noise finer than a pixel",      opt.footprint ),
+        nrCmdLineArg( "-compile", "<true/false>",        "true", "shade batches with compiled materials", opt.compile ),
+        nrCmdLineArg( "-deferred", "<true/false>",       "true", "trace, shade and light a tile at a time", opt.deferred ),
+        nrCmdLineArg( "-specialize", "<true/false>",     "true", "use tile kernels specialized on the options", opt.specialize ),
+        nrCmdLineArg( "-aa",      "<depth>",                "0", "adaptive anti-aliasing depth (0 = none)", opt.aa ),
+        nrCmdLineArg( "-contrast", "<threshold>",         "0.1", "anti-alias pixels differing by more than", opt.contrast ),
+        nrCmdLineArg( "-sampler", "<grid/jitter/sobol>", "grid", "anti-aliasing sample placement",     opt.sampler, sizeof ( opt.sampler ) ),
+        nrCmdLineArg( "-filter",  "<box/gaussian/mitchell>", "box", "anti-aliasing reconstruction filter", opt.filter, sizeof ( opt.filter ) ),
+        nrCmdLineArg( "-radius",  "<pixels>",               "0", "filter radius (0 = box 0.5, gaussian 1.5, mitchell 2)", opt.radius ),
+        nrCmdLineArg( "-time",    "<seconds>",              "0", "render progressively for at most (0 = no limit)", opt.time ),
+        nrCmdLineArg( "-stream",  "<true/false>",       "false", "write the image a band at a time, as it is rendered", opt.stream ),
+        nrCmdLineArg( "-async",   "<true/false>",        "true", "write the bands on another thread (stream)", opt.async ),
+        nrCmdLineArg( "-rle",     "<true/false>",       "false", "run length encode the image (tga)",  opt.rle ),
+        nrCmdLineArg( "-exposure", "<stops>",               "0", "scale the image by 2^stops",         opt.exposure ),
+        nrCmdLineArg( "-gamma",   "<gamma>",                "1", "gamma correct the image",            opt.gamma ),
+        nrCmdLineArg( "-dither",  "<true/false>",       "false", "dither the image as it is quantized", opt.dither ),
+        nrCmdLineArg( "-bits",    "<8/16>",                 "8", "bits per component (16 for ppm)",    opt.bits ),
+        nrCmdLineArg( "-denoise", "<iterations>",           "0", "filter the noise out of the image (0 = none)", opt.denoise ),
+        nrCmdLineArg( "-blur",    "<sigma>",                "0", "gaussian blur the image (0 = none)", opt.blur ),
+        nrCmdLineArg( "-region",  "<x0 y0 x1 y1>",    "0 0 0 0", "render only [x0,x1) x [y0,y1), from the top left", opt.region, 4 ),
+        nrCmdLineArg( "-crop",    "<true/false>",       "false", "write just the region (not into the output image)", opt.crop ),
     };
     
     // Parse the command line.
@@ -193,16 +1472,191 @@ int main( int argc, const char** argv )
         g_Log.Write( "rayn: both -rgs and -bvh specified, using -bvh.\n" );
         opt.rgs = false;
     }
+    bool region = false;
+    if ( opt.region[ 0 ] != 0 || opt.region[ 1 ] != 0 || opt.region[ 2 ] != 0 || opt.region[ 3 ] != 0 )
+    {
+        opt.region[ 0 ] = nrMath::Max( opt.region[ 0 ], 0 );
+        opt.region[ 1 ] = nrMath::Max( opt.region[ 1 ], 0 );
+        opt.region[ 2 ] = nrMath::Min( opt.region[ 2 ], opt.width );
+        opt.region[ 3 ] = nrMath::Min( opt.region[ 3 ], opt.height );
+        
+        region = ( opt.region[ 2 ] > opt.region[ 0 ] && opt.region[ 3 ] > opt.region[ 1 ] );
+        if ( ! region )
+        {
+            g_Log.Write( "rayn: -region is empty, rendering the whole image.\n" );
+        }
+    }
+    if ( ! region )
+    {
+        opt.region[ 0 ] = 0;
+        opt.region[ 1 ] = 0;
+        opt.region[ 2 ] = opt.width;
+        opt.region[ 3 ] = opt.height;
+    }
+    if ( region && opt.stream )
+    {
+        g_Log.Write( "rayn: -stream needs the whole image, ignoring -stream.\n" );
+        opt.stream = false;
+    }
+    if ( stricmp( opt.sampler, "grid" ) == 0 )
+    {
+        opt.sampling = NR_SAMPLER_GRID;
+    }
+    else if ( stricmp( opt.sampler, "sobol" ) == 0 )
+    {
+        opt.sampling = NR_SAMPLER_SOBOL;
+    }
+    else if ( stricmp( opt.sampler, "jitter" ) == 0 )
+    {
+        opt.sampling = NR_SAMPLER_JITTER;
+    }
+    else
+    {
+        g_Log.Write( "rayn: unknown sampler \"%s\".\n", opt.sampler );
+        cmdline.Usage( argv[ 0 ] );
+        return 1;
+    }
+    if ( stricmp( opt.filter, "box" ) == 0 )
+    {
+        // A box of radius 0.5 is each pixel's own samples, averaged.
+        opt.filtering = nrSplatBuffer::Box;
+    }
+    else if ( stricmp( opt.filter, "gaussian" ) == 0 )
+    {
+        opt.filtering = nrSplatBuffer::Gaussian;
+        opt.radius = opt.radius == 0.0f ? 1.5f : opt.radius;
+    }
+    else if ( stricmp( opt.filter, "mitchell" ) == 0 )
+    {
+        opt.filtering = nrSplatBuffer::Mitchell;
+        opt.radius = opt.radius == 0.0f ? 2.0f : opt.radius;
+    }
+    else
+    {
+        g_Log.Write( "rayn: unknown filter \"%s\".\n", opt.filter );
+        cmdline.Usage( argv[ 0 ] );
+        return 1;
+    }
+    if ( opt.radius < 0.0f || opt.radius > NR_SPLAT_RADIUS )
+    {
+        g_Log.Write( "rayn: -radius must be 0 to %d pixels, using %d.\n", NR_SPLAT_RADIUS, NR_SPLAT_RADIUS );
+        opt.radius = NR_SPLAT_RADIUS;
+    }
+    if ( opt.radius > 0.0f && opt.stream )
+    {
+        g_Log.Write( "rayn: -filter needs the whole image, ignoring -filter.\n" );
+        opt.radius = 0.0f;
+    }
+    if ( opt.radius > 0.0f && opt.aa == 0 )
+    {
+        g_Log.Write( "rayn: -filter needs -aa, using -aa 1.\n" );
+        opt.aa = 1;
+    }
+    if ( opt.aa > 0 && ! opt.deferred )
+    {
+        g_Log.Write( "rayn: -aa needs -deferred, using -deferred.\n" );
+        opt.deferred = true;
+    }
+    if ( opt.time > 0.0f && opt.stream )
+    {
+        g_Log.Write( "rayn: -time needs the whole image, ignoring -time.\n" );
+        opt.time = 0.0f;
+    }
+    if ( ! opt.stream )
+    {
+        // Only bands are written on another thread.
+        opt.async = false;
+    }
+    if ( opt.stream && ! opt.deferred )
+    {
+        g_Log.Write( "rayn: -stream needs -deferred, using -deferred.\n" );
+        opt.deferred = true;
+    }
+    if ( opt.time > 0.0f && ! opt.deferred )
+    {
+        g_Log.Write( "rayn: -time needs -deferred, using -deferred.\n" );
+        opt.deferred = true;
+    }
+    if ( opt.time > 0.0f && opt.aa == 0 )
+    {
+        // The last progressive pass anti-aliases.
+        opt.aa = 2;
+    }
+    if ( opt.denoise > 0 && opt.stream )
+    {
+        g_Log.Write( "rayn: -denoise needs the whole image, ignoring -denoise.\n" );
+        opt.denoise = 0;
+    }
+    if ( opt.blur > 0.0f && opt.stream )
+    {
+        g_Log.Write( "rayn: -blur needs the whole image, ignoring -blur.\n" );
+        opt.blur = 0.0f;
+    }
+    if ( opt.gamma <= 0.0f )
+    {
+        g_Log.Write( "rayn: -gamma must be positive, using 1.\n" );
+        opt.gamma = 1.0f;
+    }
+    nrThread::SetNumThreads( opt.threads );
+    
+    // The region, in the frame (from the bottom left).
+    int x0 = opt.region[ 0 ];
+    int y0 = opt.height - opt.region[ 3 ];
+    int x1 = opt.region[ 2 ];
+    int y1 = opt.height - opt.region[ 1 ];
+    
+    // Composite the region into the output image, if there is one of the
+    // frame's size to composite it into; otherwise write just the region.
+    nrImage image;
+    bool composited = false;
+    bool top_down = false;
+    if ( region && ! opt.crop )
+    {
+        const char* extension = strrchr( opt.output, '.' );
+        top_down = ( extension && stricmp( extension, ".ppm" ) == 0 );
+        
+        // Open it for writing too (without truncating it), to make sure
+        // it can be.
+        FILE* file = fopen( opt.output, "r+b" );
+        if ( ! file || ! extension || ( ! top_down && stricmp( extension, ".tga" ) != 0 ) )
+        {
+            g_Log.Write( "rayn: no image \"%s\" to composite the region into, writing it cropped.\n", opt.output );
+        }
+        else if ( image.CreateFromFile( opt.output ) && 
+                  image.Width() == opt.width && image.Height() == opt.height && image.Depth() == 3 )
+        {
+            composited = true;
+        }
+        else
+        {
+            g_Log.Write( "rayn: \"%s\" isn't an 8 bit %dx%d image, writing the region cropped.\n", opt.output, opt.width, opt.height );
+        }
+        
+        if ( file )
+        {
+            fclose( file );
+        }
+    }
+    if ( composited && opt.bits != 8 )
+    {
+        g_Log.Write( "rayn: compositing needs -bits 8, using -bits 8.\n" );
+        opt.bits = 8;
+    }
+    if ( composited && opt.rle )
+    {
+        g_Log.Write( "rayn: composited images aren't run length encoded, ignoring -rle.\n" );
+        opt.rle = false;
+    }
     
     // Make sure the output file can be opened for writing, before any work 
     // is done.
-    FILE* f = fopen( opt.output, "wb" );
-    if ( f == 0 )
+    nrImageWriter writer;
+    if ( ! composited && ! writer.Open( opt.output, x1 - x0, y1 - y0, opt.rle, opt.bits ) )
     {
         g_Log.Write( "Unable to open output file for writing \"%s\".\n", opt.output );
         return 1;
     }
-    fclose( f );
+    writer.SetResolve( opt.exposure, opt.gamma, opt.dither );
     
     // Read the scene file.
     nrScene scene;
@@ -211,13 +1665,26 @@ int main( int argc, const char** argv )
         g_Log.Write( "Reading scene file \"%s\".\n", opt.scene );
         stopwatch.Reset();
         stopwatch.Start();
-
+        
 	    scene.CullBackfaces( opt.cull );
         if ( ! scene.Parse( opt.scene ) )
         {
             return 1;
         }
-
+        
+        stopwatch.Stop();
+        g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
+    }
+    
+    // Gather the spheres, boxes and triangles into batches.
+    if ( opt.batch )
+    {
+        g_Log.Write( "Batching primitives.\n" );
+        stopwatch.Reset();
+        stopwatch.Start();
+        
+        scene.CreateBatches();
+        
         stopwatch.Stop();
         g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
     }
@@ -246,27 +1713,84 @@ int main( int argc, const char** argv )
         g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
     }
     
-    // Create a blank image to start with.
-    nrImage image;
-    image.CreateBlank( opt.width, opt.height );
+    // Create a threaded bounding volume hierarchy for the shadow rays.
+    if ( opt.tbvh && opt.shadows )
+    {
+        g_Log.Write( "Building threaded bounding volume hierarchy.\n" );
+        stopwatch.Reset();
+        stopwatch.Start();
+        
+        scene.CreateTBVH();
+        
+        stopwatch.Stop();
+        g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
+    }
+    
+    g_Log.Write( "%d allocations (%d KB in %d blocks) in the scene arena.\n", 
+        scene.m_Arena.NumAllocations(), scene.m_Arena.Size() / 1024, scene.m_Arena.NumBlocks() );
+    g_Log.Write( "%d KB peak memory.\n", nrArena::PeakMemory() );
+    
+    // Create a blank frame to start with (just the rows needed at a time,
+    // if streaming, see trace()), with samples for anti-aliasing.  Of a
+    // region, it holds the tiles around it as far as its pixels reach: to
+    // their neighbors (see differ()), filtered samples (see -filter),
+    // denoiser taps (2 steps of 2^i pixels an iteration) and blur, so they
+    // come out just as they would in the whole frame.
+    int margin = NR_SPLAT_RADIUS + 1;
+    if ( opt.denoise > 0 )
+    {
+        margin += 2 * ( ( 1 << nrMath::Min( opt.denoise, 16 ) ) - 1 );
+    }
+    if ( opt.blur > 0.0f )
+    {
+        margin += ( int )nrMath::Ceil( 3.0f * opt.blur );
+    }
+    int left = ( nrMath::Max( x0 - margin, 0 ) / NR_TILE_SIZE ) * NR_TILE_SIZE;
+    int bottom = ( nrMath::Max( y0 - margin, 0 ) / NR_TILE_SIZE ) * NR_TILE_SIZE;
+    int right = nrMath::Min( ( ( x1 + margin + NR_TILE_SIZE - 1 ) / NR_TILE_SIZE ) * NR_TILE_SIZE, opt.width );
+    int top = nrMath::Min( ( ( y1 + margin + NR_TILE_SIZE - 1 ) / NR_TILE_SIZE ) * NR_TILE_SIZE, opt.height );
+    if ( opt.stream )
+    {
+        top = opt.aa > 0 ? 3 * NR_TILE_SIZE : NR_TILE_SIZE;
+    }
+    Frame frame( opt.width, opt.height, left, bottom, right - left, top - bottom, opt.aa > 0, opt.denoise > 0 );
+    nrFrameBuffer& buffer = frame.m_Buffer;
+    if ( opt.radius > 0.0f && ! frame.Filter( opt.filtering, opt.radius ) )
+    {
+        return 1;
+    }
     
     // Ray trace, dude.
     g_Log.Write( "Raytracing scene.\n" );
+    if ( region )
+    {
+        g_Log.Write( "Rendering region [%d,%d) x [%d,%d) (%d of %d pixels traced).\n", 
+            opt.region[ 0 ], opt.region[ 2 ], opt.region[ 1 ], opt.region[ 3 ], 
+            frame.m_Buffer.Width() * frame.m_Buffer.Height(), opt.width * opt.height );
+    }
+    if ( frame.m_Splat )
+    {
+        g_Log.Write( "Filtering samples through a %s filter (radius %g).\n", opt.filter, opt.radius );
+    }
+    if ( opt.stream )
+    {
+        g_Log.Write( "Writing image to \"%s\" as it is rendered.\n", opt.output );
+    }
     stopwatch.Reset();
     stopwatch.Start();
     
     #if 0
     {
-        for ( int j = 0; j < image.Height(); j++ )
+        for ( int j = 0; j < buffer.Height(); j++ )
         {
-            for ( int i = 0; i < image.Width(); i++ )
+            for ( int i = 0; i < buffer.Width(); i++ )
             {
                 nrColor c;
                 
                 const float m = 4.0f;
-                //float n = nrNoise::Marble2( nrVector2( m * i / image.Width(), m * j / image.Height() ), 1.0f );
-                //float n = nrNoise::Turbulence2( nrVector2( m * i / image.Width(), m * j / image.Height() ) );
-                float n = nrNoise::Fractal2( nrVector2( m * i / image.Width(), m * j / image.Height() ) );
+                //float n = nrNoise::Marble2( nrVector2( m * i / buffer.Width(), m * j / buffer.Height() ), 1.0f );
+                //float n = nrNoise::Turbulence2( nrVector2( m * i / buffer.Width(), m * j / buffer.Height() ) );
+                float n = nrNoise::Fractal2( nrVector2( m * i / buffer.Width(), m * j / buffer.Height() ) );
                 
                 //n = Clamp( n * 1.333f, -1.0f, 1.0f );
                 //n = nrMath::Abs( n );
@@ -276,27 +1800,135 @@ int main( int argc, const char** argv )
                 c.g = n;
                 c.b = n;
                 
-                image.SetPixel( i, j, c );
+                buffer.SetPixel( i, j, c );
             }
         }
     }
     #else
     {
-        trace( scene, image );
+        if ( opt.async )
+        {
+            Render render = { &scene, &frame, &writer };
+            nrThread::Run( stream, &render, 2 );
+        }
+        else
+        {
+            trace( scene, frame, writer );
+        }
     }
     #endif
     
+    // Add in the samples which were splatted across the edges of tiles.
+    if ( frame.m_Splat )
+    {
+        frame.m_Splat->Merge();
+    }
+    
     stopwatch.Stop();
     g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
     
-    // Output the image.
-    g_Log.Write( "Writing image to \"%s\".\n", opt.output );
+    g_Log.Write( "%d rays (%d shadow rays), %g rays per second.\n", 
+        stats.rays + stats.shadow_rays, stats.shadow_rays, ( stats.rays + stats.shadow_rays ) / stopwatch.Elapsed() );
+    
+    if ( opt.aa > 0 )
+    {
+        g_Log.Write( "%g samples per pixel (%d pixels anti-aliased).\n", 
+            ( float )stats.rays / ( float )( frame.m_Width * frame.m_Height ), stats.refined );
+    }
+    
+    if ( nrChannelMarble::NumShades() > 0 )
+    {
+        g_Log.Write( "%g octaves of noise per marble shade (%d shades).\n", 
+            nrChannelMarble::AverageOctaves(), nrChannelMarble::NumShades() );
+    }
+    
+    // Filter the noise out of the image, guided by the surfaces seen
+    // through each pixel.
+    if ( opt.denoise > 0 )
+    {
+        g_Log.Write( "Denoising image (%d iterations).\n", opt.denoise );
+        
+        double noise = frame.m_Denoiser->Noise( buffer );
+        
+        stopwatch.Reset();
+        stopwatch.Start();
+        
+        frame.m_Denoiser->Denoise( buffer, opt.denoise );
+        
+        stopwatch.Stop();
+        g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
+        
+        double denoised = frame.m_Denoiser->Noise( buffer );
+        
+        g_Log.Write( "Noise reduced from %g to %g (%g%%) in %g ms.\n", noise, denoised, 
+            noise > 0.0 ? 100.0 * ( noise - denoised ) / noise : 0.0, stopwatch.Elapsed() * 1000.0 );
+    }
+    
+    // Blur the image, out to 3 sigma.
+    if ( opt.blur > 0.0f )
+    {
+        g_Log.Write( "Blurring image (sigma %g).\n", opt.blur );
+        stopwatch.Reset();
+        stopwatch.Start();
+        
+        nrKernel kernel;
+        kernel.CreateGaussian( 2 * ( int )nrMath::Ceil( 3.0f * opt.blur ) + 1, opt.blur );
+        kernel.Convolve( buffer, buffer );
+        
+        stopwatch.Stop();
+        g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
+    }
     
-    if ( strstr( opt.output, ".ppm" ) )
+    // Output the image (unless it was written as it was rendered), or
+    // composite the region into it.
+    if ( composited )
+    {
+        g_Log.Write( "Compositing region into \"%s\".\n", opt.output );
+        stopwatch.Reset();
+        stopwatch.Start();
+        
+        composite( frame, x0, y0, x1, y1, image, top_down );
+        
+        if ( ! image.WriteToFile( opt.output ) )
+        {
+            return 1;
+        }
+        
+        stopwatch.Stop();
+        g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
+    }
+    else
     {
-        image.FlipVertical();
+        if ( ! opt.stream )
+        {
+            g_Log.Write( "Writing image to \"%s\".\n", opt.output );
+            stopwatch.Reset();
+            stopwatch.Start();
+            
+            if ( region )
+            {
+                nrFrameBuffer cropped;
+                cropped.Create( x1 - x0, y1 - y0 );
+                cropped.CopySub( buffer, x0 - frame.m_Left, y0 - frame.m_Top, x1 - x0, y1 - y0 );
+                
+                writer.Write( cropped, 0, cropped.Height() );
+            }
+            else
+            {
+                writer.Write( buffer, 0, buffer.Height() );
+            }
+            
+            stopwatch.Stop();
+            g_Log.Write( "%s (%g seconds).\n", stopwatch.ElapsedInHMS(), stopwatch.Elapsed() );
+        }
+        if ( ! writer.Close() )
+        {
+            return 1;
+        }
+        g_Log.Write( "%d KB written.\n", ( int )( writer.Size() / 1024 ) );
     }
-    image.WriteToFile( opt.output );
+    
+    g_Log.Write( "%d KB peak memory.\n", nrArena::PeakMemory() );
     
     return 0;
 }
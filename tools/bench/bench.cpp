@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Bench.cpp
+//
+// Leaf loop benchmark.  Intersects a grid of primary rays with every 
+// primitive in a scene (no hierarchy or grid), first with a virtual
+// nrSurface::Hit() call per primitive, and then with the primitives 
+// batched by type (see nrPrimitives), which dispatches on the type once
+// per batch.
+//
+// Nate Robins, February 2002
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrArray.h"
+#include "nrBasis.h"
+#include "nrCmdLine.h"
+#include "nrHit.h"
+#include "nrInterval.h"
+#include "nrLog.h"
+#include "nrRay.h"
+#include "nrScene.h"
+#include "nrStopWatch.h"
+#include "nrSurface.h"
+#include "nrVector2.h"
+#include "nrVector3.h"
+#include "nrView.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+// Fill the grid array with a width by height grid of primary rays.
+void rays( const nrScene& scene, int width, int height, nrArray<nrRay>& grid )
+{
+    const nrBasis& onb = scene.m_View->m_Basis;
+    const nrVector3& origin = scene.m_View->m_Eye;
+    const nrVector2& a = scene.m_View->m_BottomLeft;
+    const nrVector2& b = scene.m_View->m_TopRight;
+    
+    for ( int j = 0; j < height; j++ )
+    {
+        for ( int i = 0; i < width; i++ )
+        {
+            float dx = ( a.x + ( b.x - a.x ) * ( float )i / ( float )( width  - 1 ) );
+            float dy = ( a.y + ( b.y - a.y ) * ( float )j / ( float )( height - 1 ) );
+            float dz = -scene.m_View->m_Distance;
+            nrVector3 direction = onb.u * dx + onb.v * dy + onb.w * dz;
+            
+            grid.Add( nrRay( origin, direction ) );
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+// Intersect every ray with every surface, and return the time taken.  The 
+// number of rays that hit something and the sum of the closest hit 
+// distances are returned as a checksum.
+float leaves( const nrArray<nrSurface*>& surfaces, const nrArray<nrRay>& grid, int repeat, int& num_hits, double& sum )
+{
+    nrStopWatch stopwatch;
+    stopwatch.Reset();
+    stopwatch.Start();
+    
+    for ( int n = 0; n < repeat; n++ )
+    {
+        num_hits = 0;
+        sum = 0.0;
+        
+        for ( int r = 0; r < grid.Length(); r++ )
+        {
+            nrInterval interval = nrInterval( 0.0f, 2e30f );
+            nrHit hit;
+            bool hit_something = false;
+            
+            for ( int l = 0; l < surfaces.Length(); l++ )
+            {
+                if ( surfaces[ l ]->Hit( grid[ r ], interval, hit ) )
+                {
+                    interval.m_Maximum = hit.t;
+                    hit_something = true;
+                }
+            }
+            
+            if ( hit_something )
+            {
+                num_hits++;
+                sum += hit.t;
+            }
+        }
+    }
+    
+    stopwatch.Stop();
+    
+    return stopwatch.Elapsed();
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int main( int argc, const char** argv )
+{
+    char scene_file[ 256 ];
+    int width;
+    int height;
+    int repeat;
+    
+    nrCmdLineArg cmdlineargs[] = 
+    {
+        nrCmdLineArg( 0,    "<scene_file>", 0,    "file containing scene description", scene_file, sizeof ( scene_file ) ),
+        nrCmdLineArg( "-w", "<width>",      "64", "width of the grid of rays",         width ),
+        nrCmdLineArg( "-h", "<height>",     "64", "height of the grid of rays",        height ),
+        nrCmdLineArg( "-n", "<repeat>",     "1",  "number of times to repeat",         repeat ),
+    };
+    
+    nrCmdLine c( cmdlineargs, sizeof ( cmdlineargs ) / sizeof ( nrCmdLineArg ) );
+    if ( ! c.Parse( argc, argv ) )
+    {
+        c.Usage( argv[ 0 ] );
+        return 1;
+    }
+    
+    nrScene scene;
+    if ( ! scene.Parse( scene_file ) )
+    {
+        g_Log.Write( "Can't parse scene file \"%s\".\n", scene_file );
+        return 1;
+    }
+    
+    nrArray<nrRay> grid( width * height );
+    rays( scene, width, height, grid );
+    
+    // The primitives are owned by the scene (and later by the batches),
+    // so this is just a copy of the pointers.
+    nrArray<nrSurface*> primitives( scene.m_Surfaces.Length() );
+    for ( int i = 0; i < scene.m_Surfaces.Length(); i++ )
+    {
+        primitives.Add( scene.m_Surfaces[ i ] );
+    }
+    
+    int virtual_hits;
+    double virtual_sum;
+    float virtual_time = leaves( primitives, grid, repeat, virtual_hits, virtual_sum );
+    
+    scene.CreateBatches();
+    
+    int batched_hits;
+    double batched_sum;
+    float batched_time = leaves( scene.m_Surfaces, grid, repeat, batched_hits, batched_sum );
+    
+    double num_rays = ( double )grid.Length() * repeat;
+    
+    g_Log.Write( "%d rays, %d primitives, %d leaves.\n", grid.Length(), primitives.Length(), scene.m_Surfaces.Length() );
+    g_Log.Write( "virtual: %g seconds (%g rays/second), %d hits, checksum %g.\n", 
+        virtual_time, num_rays / virtual_time, virtual_hits, virtual_sum );
+    g_Log.Write( "batched: %g seconds (%g rays/second), %d hits, checksum %g.\n", 
+        batched_time, num_rays / batched_time, batched_hits, batched_sum );
+    g_Log.Write( "speedup: %gx\n", virtual_time / batched_time );
+    
+    if ( virtual_hits != batched_hits || virtual_sum != batched_sum )
+    {
+        g_Log.Write( "The batched hits do not match the virtual hits!\n" );
+        return 1;
+    }
+    
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
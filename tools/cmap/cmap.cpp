@@ -1,6 +1,9 @@
 
+#include "nrArray.h"
 #include "nrColor.h"
+#include "nrColorRamp.h"
 #include "nrCmdLine.h"
+#include "nrImage.h"
 #include "nrLog.h"
 
 /*
@@ -247,11 +250,15 @@ int main( int argc, const char** argv )
 {
     int type;
     int size;
+    bool lut;
+    char output[ 256 ];
     
     nrCmdLineArg args[] = 
     {
-        nrCmdLineArg( "-type", "<type>", "15", "type of colormap", type ),
-        nrCmdLineArg( "-size", "<args>",  "8", "size of colormap", size ),
+        nrCmdLineArg( "-type", "<type>",             "15", "type of colormap", type ),
+        nrCmdLineArg( "-size", "<args>",              "8", "size of colormap", size ),
+        nrCmdLineArg( "-lut",  "<true/false>",    "false", "print the resampled ramp table", lut ),
+        nrCmdLineArg( "-o",    "<output_file>",        "", "write the ramp table as an image", output, sizeof ( output ) ),
     };
     
     nrCmdLine c( args, sizeof ( args ) / sizeof ( nrCmdLineArg ) );
@@ -277,17 +284,57 @@ int main( int argc, const char** argv )
         return 1;
     }
     
-	printf( "     ramp { # \"type=%d\"\n", type );
+    nrArray< nrColor > colors;
     
 	for ( int i = 0; i < size; i++ )
 	{
 		float t = ( float )i / ( float )size;
-		nrColor c = GetColour( t, 0, 1, type );
-		
-		printf( "       < %f %f %f >\n", c.r, c.g, c.b );
+		colors.Add( GetColour( t, 0, 1, type ) );
 	}
     
+    // The ramp resamples the colors into the table it looks colors up in
+    // (see nrColorRamp).
+    nrColorRamp ramp;
+    ramp.CreateFromColors( colors );
+    
+	printf( "     ramp { # \"type=%d\"\n", type );
+    
+    if ( lut )
+    {
+        for ( int j = 0; j < ramp.Size(); j++ )
+        {
+            nrColor c = ramp.Entry( j );
+            printf( "       < %f %f %f >\n", c.r, c.g, c.b );
+        }
+    }
+    else
+    {
+        for ( int j = 0; j < colors.Length(); j++ )
+        {
+            nrColor c = colors[ j ];
+            printf( "       < %f %f %f >\n", c.r, c.g, c.b );
+        }
+    }
+    
 	printf ( "     }\n" );
     
+    // The image can be read back in with nrColorRamp::CreateFromImage().
+    if ( output[ 0 ] )
+    {
+        nrImage image;
+        image.CreateBlank( ramp.Size(), 1 );
+        
+        for ( int k = 0; k < ramp.Size(); k++ )
+        {
+            image.SetPixel( k, 0, ramp.Entry( k ) );
+        }
+        
+        if ( ! image.WriteToFile( output ) )
+        {
+            g_Log.Write( "Unable to write \"%s\".\n", output );
+            return 1;
+        }
+    }
+    
     return 0;
 }
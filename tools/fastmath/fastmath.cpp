@@ -0,0 +1,320 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// fastmath.cpp
+//
+// Fast math benchmark.  Evaluates each function of nrFastMath at a set of
+// random arguments with the accurate code (nrMath, or the C library), the
+// fast scalar code and the fast 8 wide (SIMD, if available) code, and
+// logs the time taken and the largest errors against double precision.
+// The 8 wide results are checked against the scalar results.
+//
+// Nate Robins, March 2002
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrCmdLine.h"
+#include "nrFastMath.h"
+#include "nrLog.h"
+#include "nrMath.h"
+#include "nrStopWatch.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Classes
+////////////////////////////////////////////////////////////////////////////
+
+// The functions, each with the range of its arguments (logarithmic ranges
+// are exponents of 10), the reference (double precision), accurate and
+// fast versions.
+
+class Sin
+{
+public:
+    static const char* Name( void ) { return "Sin"; }
+    static bool Logarithmic( void ) { return false; }
+    static float Minimum( void ) { return -3600.0f; }
+    static float Maximum( void ) { return 3600.0f; }
+    static double Reference( double x, double y ) { return sin( x * 3.14159265358979323846 / 180.0 ); }
+    static float Accurate( float x, float y ) { return nrMath::Sin( x ); }
+    static float Fast( float x, float y ) { return nrFastMath::Sin( x ); }
+#ifdef NR_AVX2
+    static __m256 Fast( __m256 x, __m256 y ) { return nrFastMath::Sin( x ); }
+#endif
+};
+
+class Cos
+{
+public:
+    static const char* Name( void ) { return "Cos"; }
+    static bool Logarithmic( void ) { return false; }
+    static float Minimum( void ) { return -3600.0f; }
+    static float Maximum( void ) { return 3600.0f; }
+    static double Reference( double x, double y ) { return cos( x * 3.14159265358979323846 / 180.0 ); }
+    static float Accurate( float x, float y ) { return nrMath::Cos( x ); }
+    static float Fast( float x, float y ) { return nrFastMath::Cos( x ); }
+#ifdef NR_AVX2
+    static __m256 Fast( __m256 x, __m256 y ) { return nrFastMath::Cos( x ); }
+#endif
+};
+
+class SinRadians
+{
+public:
+    static const char* Name( void ) { return "SinRadians"; }
+    static bool Logarithmic( void ) { return false; }
+    static float Minimum( void ) { return -100.0f; }
+    static float Maximum( void ) { return 100.0f; }
+    static double Reference( double x, double y ) { return sin( x ); }
+    static float Accurate( float x, float y ) { return sinf( x ); }
+    static float Fast( float x, float y ) { return nrFastMath::SinRadians( x ); }
+#ifdef NR_AVX2
+    static __m256 Fast( __m256 x, __m256 y ) { return nrFastMath::SinRadians( x ); }
+#endif
+};
+
+class CosRadians
+{
+public:
+    static const char* Name( void ) { return "CosRadians"; }
+    static bool Logarithmic( void ) { return false; }
+    static float Minimum( void ) { return -100.0f; }
+    static float Maximum( void ) { return 100.0f; }
+    static double Reference( double x, double y ) { return cos( x ); }
+    static float Accurate( float x, float y ) { return cosf( x ); }
+    static float Fast( float x, float y ) { return nrFastMath::CosRadians( x ); }
+#ifdef NR_AVX2
+    static __m256 Fast( __m256 x, __m256 y ) { return nrFastMath::CosRadians( x ); }
+#endif
+};
+
+class Exp
+{
+public:
+    static const char* Name( void ) { return "Exp"; }
+    static bool Logarithmic( void ) { return false; }
+    static float Minimum( void ) { return -80.0f; }
+    static float Maximum( void ) { return 80.0f; }
+    static double Reference( double x, double y ) { return exp( x ); }
+    static float Accurate( float x, float y ) { return expf( x ); }
+    static float Fast( float x, float y ) { return nrFastMath::Exp( x ); }
+#ifdef NR_AVX2
+    static __m256 Fast( __m256 x, __m256 y ) { return nrFastMath::Exp( x ); }
+#endif
+};
+
+class Log
+{
+public:
+    static const char* Name( void ) { return "Log"; }
+    static bool Logarithmic( void ) { return true; }
+    static float Minimum( void ) { return -30.0f; }
+    static float Maximum( void ) { return 30.0f; }
+    static double Reference( double x, double y ) { return log( x ); }
+    static float Accurate( float x, float y ) { return logf( x ); }
+    static float Fast( float x, float y ) { return nrFastMath::Log( x ); }
+#ifdef NR_AVX2
+    static __m256 Fast( __m256 x, __m256 y ) { return nrFastMath::Log( x ); }
+#endif
+};
+
+class Pow
+{
+public:
+    static const char* Name( void ) { return "Pow"; }
+    static bool Logarithmic( void ) { return true; }
+    static float Minimum( void ) { return -2.0f; }
+    static float Maximum( void ) { return 2.0f; }
+    static double Reference( double x, double y ) { return pow( x, y ); }
+    static float Accurate( float x, float y ) { return nrMath::Pow( x, y ); }
+    static float Fast( float x, float y ) { return nrFastMath::Pow( x, y ); }
+#ifdef NR_AVX2
+    static __m256 Fast( __m256 x, __m256 y ) { return nrFastMath::Pow( x, y ); }
+#endif
+};
+
+class RSqrt
+{
+public:
+    static const char* Name( void ) { return "RSqrt"; }
+    static bool Logarithmic( void ) { return true; }
+    static float Minimum( void ) { return -10.0f; }
+    static float Maximum( void ) { return 10.0f; }
+    static double Reference( double x, double y ) { return 1.0 / sqrt( x ); }
+    static float Accurate( float x, float y ) { return 1.0f / nrMath::Sqrt( x ); }
+    static float Fast( float x, float y ) { return nrFastMath::RSqrt( x ); }
+#ifdef NR_AVX2
+    static __m256 Fast( __m256 x, __m256 y ) { return nrFastMath::RSqrt( x ); }
+#endif
+};
+
+////////////////////////////////////////////////////////////////////////////
+
+template < class F > class Benchmark
+{
+public:
+
+    // Benchmark the function with count (a multiple of 8) arguments.
+    // Return the number of mismatches between the 8 wide and scalar
+    // results.
+    static int Run( int count )
+    {
+        float* x = new float[ count ];
+        float* y = new float[ count ];
+        double* reference = new double[ count ];
+        float* results = new float[ count ];
+        float* scalar = new float[ count ];
+
+        int i;
+        for ( i = 0; i < count; i++ )
+        {
+            x[ i ] = nrMath::Random_f( F::Minimum(), F::Maximum() );
+            if ( F::Logarithmic() )
+            {
+                x[ i ] = ( float )pow( 10.0, x[ i ] );
+            }
+
+            // The exponent, for Pow().
+            y[ i ] = nrMath::Random_f( -4.0f, 4.0f );
+
+            reference[ i ] = F::Reference( x[ i ], y[ i ] );
+        }
+
+        nrStopWatch stopwatch;
+
+        // The accurate code.
+        stopwatch.Reset();
+        stopwatch.Start();
+        for ( i = 0; i < count; i++ )
+        {
+            results[ i ] = F::Accurate( x[ i ], y[ i ] );
+        }
+        stopwatch.Stop();
+        check( "accurate", stopwatch.Elapsed(), count, results, reference );
+
+        // The fast scalar code.
+        stopwatch.Reset();
+        stopwatch.Start();
+        for ( i = 0; i < count; i++ )
+        {
+            scalar[ i ] = F::Fast( x[ i ], y[ i ] );
+        }
+        stopwatch.Stop();
+        check( "fast", stopwatch.Elapsed(), count, scalar, reference );
+
+        int mismatches = 0;
+
+#ifdef NR_AVX2
+        // The fast 8 wide code.
+        stopwatch.Reset();
+        stopwatch.Start();
+        for ( i = 0; i < count; i += 8 )
+        {
+            _mm256_storeu_ps( results + i, F::Fast( _mm256_loadu_ps( x + i ), _mm256_loadu_ps( y + i ) ) );
+        }
+        stopwatch.Stop();
+        check( "fast x8", stopwatch.Elapsed(), count, results, reference );
+
+        for ( i = 0; i < count; i++ )
+        {
+            if ( memcmp( &results[ i ], &scalar[ i ], sizeof ( float ) ) != 0 )
+            {
+                mismatches++;
+            }
+        }
+
+        if ( mismatches > 0 )
+        {
+            g_Log.Write( "%-10s %d mismatches between the 8 wide and scalar code.\n", "", mismatches );
+        }
+#endif
+
+        delete [] x;
+        delete [] y;
+        delete [] reference;
+        delete [] results;
+        delete [] scalar;
+
+        return mismatches;
+    }
+
+private:
+
+    // Log the time taken, and the largest absolute and relative errors.
+    static void check( const char* name, float time, int count, const float* results, const double* reference )
+    {
+        double absolute = 0.0;
+        double relative = 0.0;
+
+        for ( int i = 0; i < count; i++ )
+        {
+            double error = fabs( results[ i ] - reference[ i ] );
+
+            absolute = error > absolute ? error : absolute;
+
+            if ( fabs( reference[ i ] ) > 1e-3 )
+            {
+                error = error / fabs( reference[ i ] );
+                relative = error > relative ? error : relative;
+            }
+        }
+
+        g_Log.Write( "%-10s %-8s %8.2f M per second, error %.2e (absolute) %.2e (relative).\n",
+            F::Name(), name, count / time / 1e6, absolute, relative );
+    }
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+int main( int argc, const char** argv )
+{
+    int count;
+
+    nrCmdLineArg cmdlineargs[] =
+    {
+        nrCmdLineArg( "-n", "<count>", "4000000", "number of arguments", count ),
+    };
+
+    nrCmdLine c( cmdlineargs, sizeof ( cmdlineargs ) / sizeof ( nrCmdLineArg ) );
+    if ( ! c.Parse( argc, argv ) )
+    {
+        c.Usage( argv[ 0 ] );
+        return 1;
+    }
+
+    // Round up to a multiple of 8, for the 8 wide code.
+    count = ( count + 7 ) & ~7;
+
+    int mismatches = 0;
+
+    mismatches += Benchmark< Sin >::Run( count );
+    mismatches += Benchmark< Cos >::Run( count );
+    mismatches += Benchmark< SinRadians >::Run( count );
+    mismatches += Benchmark< CosRadians >::Run( count );
+    mismatches += Benchmark< Exp >::Run( count );
+    mismatches += Benchmark< Log >::Run( count );
+    mismatches += Benchmark< Pow >::Run( count );
+    mismatches += Benchmark< RSqrt >::Run( count );
+
+    if ( mismatches > 0 )
+    {
+        g_Log.Write( "The 8 wide code does not match the scalar code!\n" );
+        return 1;
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
@@ -105,6 +105,20 @@ void model( const char* name )
             printf( " a < %g %g %g >", a.x, a.y, a.z );
             printf( " b < %g %g %g >", b.x, b.y, b.z );
             printf( " c < %g %g %g >\n", c.x, c.y, c.z );
+            
+            // Pass the vertex normals along (if the model has them) for
+            // smooth shading.
+            if ( t.m_Vertices[ 0 ].m_NormalIndex >= 0 && t.m_Vertices[ 1 ].m_NormalIndex >= 0 && t.m_Vertices[ 2 ].m_NormalIndex >= 0 )
+            {
+                const nrVector3& na = t.Normal( 0 );
+                const nrVector3& nb = t.Normal( 1 );
+                const nrVector3& nc = t.Normal( 2 );
+                
+                printf( " na < %g %g %g >", na.x, na.y, na.z );
+                printf( " nb < %g %g %g >", nb.x, nb.y, nb.z );
+                printf( " nc < %g %g %g >\n", nc.x, nc.y, nc.z );
+            }
+            
             printf( " material \"%s\"\n", material.GetName() );
             printf( "}\n" );
             
@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Noise.cpp
+//
+// Noise benchmark.  Evaluates 3D noise at a set of random points with the
+// general (recursive) code, the hand specialized scalar code, and the 8
+// point (SIMD, if available) code, and then fractal noise a point at a
+// time and 8 octaves at a time.  The results of each are checked against
+// the general code.
+//
+// Nate Robins, February 2002
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////
+
+#include "nrCmdLine.h"
+#include "nrLog.h"
+#include "nrMath.h"
+#include "nrNoise.h"
+#include "nrStopWatch.h"
+#include "nrVector3.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+////////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////////
+
+// Compare the results to the reference results, and log the time taken,
+// the number of mismatches and the largest difference.  Return the number
+// of mismatches.
+int check( const char* name, float time, int count, const float* results, const float* reference )
+{
+    int mismatches = 0;
+    float difference = 0.0f;
+    
+    for ( int i = 0; i < count; i++ )
+    {
+        if ( results[ i ] != reference[ i ] )
+        {
+            mismatches++;
+        }
+        
+        difference = nrMath::Max( difference, nrMath::Abs( results[ i ] - reference[ i ] ) );
+    }
+    
+    g_Log.Write( "%-10s %g seconds (%g per second), %d mismatches (largest difference %g).\n", 
+        name, time, count / time, mismatches, difference );
+    
+    return mismatches;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+int main( int argc, const char** argv )
+{
+    int count;
+    int octaves;
+    float range;
+    
+    nrCmdLineArg cmdlineargs[] = 
+    {
+        nrCmdLineArg( "-n", "<count>",   "1000000", "number of points",              count ),
+        nrCmdLineArg( "-o", "<octaves>", "12",      "number of octaves of fractals", octaves ),
+        nrCmdLineArg( "-r", "<range>",   "100",     "range of the points (+/-)",     range ),
+    };
+    
+    nrCmdLine c( cmdlineargs, sizeof ( cmdlineargs ) / sizeof ( nrCmdLineArg ) );
+    if ( ! c.Parse( argc, argv ) )
+    {
+        c.Usage( argv[ 0 ] );
+        return 1;
+    }
+    
+    // Round up to a multiple of 8, for the 8 point code.
+    count = ( count + 7 ) & ~7;
+    
+    nrNoiseN<3> noise;
+    
+    float* x = new float[ count ];
+    float* y = new float[ count ];
+    float* z = new float[ count ];
+    float* reference = new float[ count ];
+    float* results = new float[ count ];
+    
+    int i;
+    for ( i = 0; i < count; i++ )
+    {
+        x[ i ] = nrMath::Random_f( -range, range );
+        y[ i ] = nrMath::Random_f( -range, range );
+        z[ i ] = nrMath::Random_f( -range, range );
+    }
+    
+    int mismatches = 0;
+    nrStopWatch stopwatch;
+    
+    // The general code.
+    stopwatch.Reset();
+    stopwatch.Start();
+    for ( i = 0; i < count; i++ )
+    {
+        float v[ 3 ] = { x[ i ], y[ i ], z[ i ] };
+        reference[ i ] = noise.GetRecursive( v );
+    }
+    stopwatch.Stop();
+    mismatches += check( "recursive", stopwatch.Elapsed(), count, reference, reference );
+    
+    // The hand specialized code.
+    stopwatch.Reset();
+    stopwatch.Start();
+    for ( i = 0; i < count; i++ )
+    {
+        float v[ 3 ] = { x[ i ], y[ i ], z[ i ] };
+        results[ i ] = noise.Get( v );
+    }
+    stopwatch.Stop();
+    mismatches += check( "scalar", stopwatch.Elapsed(), count, results, reference );
+    
+    // The 8 point code.
+    memset( results, 0, count * sizeof ( float ) );
+    stopwatch.Reset();
+    stopwatch.Start();
+    for ( i = 0; i < count; i += 8 )
+    {
+        float v[ 3 ][ 8 ];
+        memcpy( v[ 0 ], x + i, sizeof ( v[ 0 ] ) );
+        memcpy( v[ 1 ], y + i, sizeof ( v[ 1 ] ) );
+        memcpy( v[ 2 ], z + i, sizeof ( v[ 2 ] ) );
+        
+        noise.Get( v, results + i );
+    }
+    stopwatch.Stop();
+    mismatches += check( "8 points", stopwatch.Elapsed(), count, results, reference );
+    
+    // Fractal noise, one octave at a time (the reference), and then with
+    // nrNoise::Fractal3(), which computes 8 octaves at a time (if SIMD is
+    // available).  Scaled down to cover about the same number of noise
+    // evaluations as above.
+    int fractals = nrMath::Max( count / octaves, 1 );
+    
+    stopwatch.Reset();
+    stopwatch.Start();
+    for ( i = 0; i < fractals; i++ )
+    {
+        nrVector3 v( x[ i ], y[ i ], z[ i ] );
+        
+        float n = 0.0f;
+        for ( int j = 0; j < octaves; j++ )
+        {
+            float o = ( float )( 1 << j );
+            
+            n += nrNoise::Noise3( v * o ) / o;
+        }
+        
+        reference[ i ] = n;
+    }
+    stopwatch.Stop();
+    mismatches += check( "octaves", stopwatch.Elapsed(), fractals, reference, reference );
+    
+    stopwatch.Reset();
+    stopwatch.Start();
+    for ( i = 0; i < fractals; i++ )
+    {
+        results[ i ] = nrNoise::Fractal3( nrVector3( x[ i ], y[ i ], z[ i ] ), octaves );
+    }
+    stopwatch.Stop();
+    mismatches += check( "fractal", stopwatch.Elapsed(), fractals, results, reference );
+    
+    delete [] x;
+    delete [] y;
+    delete [] z;
+    delete [] reference;
+    delete [] results;
+    
+    if ( mismatches > 0 )
+    {
+        g_Log.Write( "The noise does not match the general code!\n" );
+        return 1;
+    }
+    
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////